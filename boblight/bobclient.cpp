@@ -43,8 +43,7 @@ BobClient::BobClient(const QString &host, const int &port, QObject *parent) :
     m_connected(false)
 {
     m_syncTimer = new QTimer(this);
-    m_syncTimer->setSingleShot(false);
-    m_syncTimer->setInterval(25);
+    m_syncTimer->setSingleShot(true);
 
     connect(m_syncTimer, SIGNAL(timeout()), this, SLOT(sync()));
 }
@@ -77,7 +76,7 @@ bool BobClient::connectToBoblight()
     for (int i = 0; i < lightsCount(); ++i) {
         BobChannel *channel = new BobChannel(i, this);
         channel->setColor(QColor(255,255,255,0));
-        connect(channel, SIGNAL(colorChanged()), this, SLOT(sync()));
+        connect(channel, SIGNAL(finalColorChanged()), this, SLOT(onChannelChanged()));
         m_channels.insert(i, channel);
     }
     setConnected(true);
@@ -144,22 +143,53 @@ void BobClient::setBrightness(int channel, int brightness)
     }
 }
 
+void BobClient::scheduleFrame()
+{
+    if (!m_connected || m_syncTimer->isActive())
+        return;
+
+    // Changes within one frame interval get coalesced into one frame
+    int delay = 0;
+    if (m_lastFrame.isValid()) {
+        delay = qMax(0, m_frameInterval - static_cast<int>(m_lastFrame.elapsed()));
+    }
+    m_syncTimer->start(delay);
+}
+
+void BobClient::onChannelChanged()
+{
+    // Emitted for every animation step as well, so running animations keep the frames going
+    BobChannel *channel = static_cast<BobChannel *>(sender());
+    m_dirtyChannels.insert(channel->id());
+    scheduleFrame();
+}
+
 void BobClient::sync()
 {
-    if (!m_connected)
+    if (!m_connected || m_dirtyChannels.isEmpty())
         return;
 
-    foreach (BobChannel *channel, m_channels) {
+    // libboblight keeps the values of unchanged lights, only the dirty ones need to be updated
+    foreach (int id, m_dirtyChannels) {
+        BobChannel *channel = m_channels.value(id);
+        if (!channel)
+            continue;
+
+        QColor color = channel->finalColor();
+        qreal alpha = color.alphaF();
         int rgb[3];
-        rgb[0] = channel->finalColor().red() * channel->finalColor().alphaF();
-        rgb[1] = channel->finalColor().green() * channel->finalColor().alphaF();
-        rgb[2] = channel->finalColor().blue() * channel->finalColor().alphaF();
+        rgb[0] = color.red() * alpha;
+        rgb[1] = color.green() * alpha;
+        rgb[2] = color.blue() * alpha;
         boblight_addpixel(m_boblight, channel->id(), rgb);
     }
+    m_dirtyChannels.clear();
+    m_lastFrame.start();
 
     if (!boblight_sendrgb(m_boblight, 1, nullptr)) {
         qCWarning(dcBoblight) << "Boblight connection error:" << boblight_geterror(m_boblight);
         boblight_destroy(m_boblight);
+        m_boblight = nullptr;
         qDeleteAll(m_channels);
         m_channels.clear();
         setConnected(false);
@@ -174,9 +204,15 @@ void BobClient::setConnected(bool connected)
     // if disconnected, delete all channels
     if (!connected) {
         m_syncTimer->stop();
+        m_dirtyChannels.clear();
         qDeleteAll(m_channels);
+        m_channels.clear();
     } else {
-        m_syncTimer->start();
+        // Send the initial state of all channels
+        foreach (BobChannel *channel, m_channels) {
+            m_dirtyChannels.insert(channel->id());
+        }
+        scheduleFrame();
     }
 }
 
@@ -36,6 +36,8 @@
 #include <QMap>
 #include <QColor>
 #include <QTime>
+#include <QSet>
+#include <QElapsedTimer>
 
 #include <bobchannel.h>
 
@@ -61,7 +63,11 @@ public:
 private:
     void *m_boblight = nullptr;
 
+    // Frames are only sent if a channel changed, at most one per frame interval
     QTimer *m_syncTimer;
+    QElapsedTimer m_lastFrame;
+    QSet<int> m_dirtyChannels;
+    int m_frameInterval = 25;
     QString m_host;
     int m_port;
     bool m_connected;
@@ -72,8 +78,10 @@ private:
 
     BobChannel *getChannel(const int &id);
 
+    void scheduleFrame();
 
 private slots:
+    void onChannelChanged();
     void sync();
     void setConnected(bool connected);
 
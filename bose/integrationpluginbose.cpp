@@ -425,7 +425,12 @@ void IntegrationPluginBose::updateConsumerKey()
 
 void IntegrationPluginBose::onPluginTimer()
 {
+    // Speakers with a notification channel push their changes, they are only refreshed once a minute as a fallback
+    m_pluginTimerCounter = (m_pluginTimerCounter + 1) % 30;
     foreach(SoundTouch *soundTouch, m_soundTouch.values()) {
+        if (soundTouch->notificationsConnected() && m_pluginTimerCounter != 0)
+            continue;
+
         soundTouch->getInfo();
         soundTouch->getNowPlaying();
         soundTouch->getVolume();
@@ -66,6 +66,7 @@ private:
     QString m_consumerKey;
     ZeroConfServiceBrowser *m_serviceBrowser = nullptr;
     PluginTimer *m_pluginTimer = nullptr;
+    int m_pluginTimerCounter = 0;
 
     QHash<Thing *, SoundTouch *> m_soundTouch;
     QHash<QUuid, ThingActionInfo *> m_pendingActions;
@@ -49,6 +49,9 @@ class SoundTouch : public QObject
 public:
     explicit SoundTouch(NetworkAccessManager *networkAccessManager, QString ipAddress, QObject *parent = nullptr);
 
+    // True while change notifications are pushed over the websocket
+    bool notificationsConnected() const;
+
     QUuid getInfo();             //Get basic information about a product.
     QUuid getVolume();           //Get the current volume and mute status of a product.
     QUuid getNowPlaying();       //Get information about what's playing on a product.
@@ -82,8 +85,12 @@ private:
     QString m_ipAddress;
     int m_port = 8090;
     QWebSocket *m_websocket = nullptr;
+    QTimer *m_websocketReconnectTimer = nullptr;
+    int m_websocketReconnectInterval = 0;
+
     void emitRequestStatus(QUuid requestId, QNetworkReply *reply); //returns the status, -1 in case of error
     void parseData(QUuid requestId, const QByteArray &data);
+    void parseElement(QUuid requestId, QXmlStreamReader &xml);
 
 signals:
     void connectionChanged(bool connected);
@@ -102,9 +109,11 @@ signals:
     void errorReceived(ErrorObject error);
 
 private slots:
+    void connectWebsocket();
     void onWebsocketConnected();
     void onWebsocketDisconnected();
-    void onWebsocketMessageReceived(QString message);
+    void onWebsocketError(QAbstractSocket::SocketError error);
+    void onWebsocketMessageReceived(const QString &message);
 };
 
 #endif // SOUNDTOUCH_H
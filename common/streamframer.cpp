@@ -0,0 +1,238 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "streamframer.h"
+
+Q_LOGGING_CATEGORY(dcStreamFramer, "StreamFramer")
+
+StreamFramer::StreamFramer(const Configuration &configuration, QObject *parent) :
+    QObject(parent),
+    m_configuration(configuration)
+{
+    m_configuration.lengthPrefixSize = qBound(1, m_configuration.lengthPrefixSize, 4);
+
+    if (m_configuration.mode == ModeIdleGap) {
+        m_idleTimer = new QTimer(this);
+        m_idleTimer->setSingleShot(true);
+        m_idleTimer->setInterval(m_configuration.idleTimeout);
+        connect(m_idleTimer, &QTimer::timeout, this, &StreamFramer::flushBuffer);
+    }
+}
+
+StreamFramer::Configuration StreamFramer::configuration() const
+{
+    return m_configuration;
+}
+
+void StreamFramer::addData(const QByteArray &data)
+{
+    if (data.isEmpty())
+        return;
+
+    if (m_configuration.mode == ModeNone) {
+        emit frameReceived(data);
+        return;
+    }
+
+    m_buffer.append(data);
+    processBuffer();
+
+    // Drop the already framed data once it takes up most of the buffer
+    if (m_readPosition == m_buffer.size()) {
+        m_buffer.clear();
+        m_readPosition = 0;
+    } else if (m_readPosition > m_buffer.size() / 2) {
+        m_buffer.remove(0, m_readPosition);
+        m_readPosition = 0;
+    }
+}
+
+void StreamFramer::reset()
+{
+    if (m_idleTimer)
+        m_idleTimer->stop();
+
+    m_buffer.clear();
+    m_readPosition = 0;
+}
+
+StreamFramer::Mode StreamFramer::modeFromString(const QString &mode)
+{
+    if (mode == "Delimiter") {
+        return ModeDelimiter;
+    } else if (mode == "Fixed length") {
+        return ModeFixedLength;
+    } else if (mode == "Length prefix") {
+        return ModeLengthPrefix;
+    } else if (mode == "Idle gap") {
+        return ModeIdleGap;
+    }
+    return ModeNone;
+}
+
+QByteArray StreamFramer::decodeDelimiter(const QString &delimiter)
+{
+    // Allows entering control characters like "\r\n" or "\x03" as plain text
+    QByteArray escaped = delimiter.toUtf8();
+    QByteArray decoded;
+    for (int i = 0; i < escaped.length(); i++) {
+        if (escaped.at(i) != '\\' || i + 1 >= escaped.length()) {
+            decoded.append(escaped.at(i));
+            continue;
+        }
+
+        char escape = escaped.at(++i);
+        switch (escape) {
+        case 'n':
+            decoded.append('\n');
+            break;
+        case 'r':
+            decoded.append('\r');
+            break;
+        case 't':
+            decoded.append('\t');
+            break;
+        case '0':
+            decoded.append('\0');
+            break;
+        case 'x': {
+            bool ok = false;
+            char value = static_cast<char>(escaped.mid(i + 1, 2).toUInt(&ok, 16));
+            if (ok) {
+                decoded.append(value);
+                i += 2;
+            } else {
+                decoded.append("\\x");
+            }
+            break;
+        }
+        default:
+            decoded.append(escape);
+            break;
+        }
+    }
+    return decoded;
+}
+
+void StreamFramer::processBuffer()
+{
+    switch (m_configuration.mode) {
+    case ModeDelimiter: {
+        const QByteArray &delimiter = m_configuration.delimiter;
+        if (delimiter.isEmpty()) {
+            flushBuffer();
+            return;
+        }
+
+        int index = m_buffer.indexOf(delimiter, m_readPosition);
+        while (index >= 0) {
+            int frameSize = index - m_readPosition;
+            if (frameSize > m_configuration.maximumFrameSize) {
+                qCWarning(m_configuration.loggingCategory) << "Dropping frame exceeding the maximum frame size of" << m_configuration.maximumFrameSize << "bytes";
+            } else {
+                emit frameReceived(m_buffer.mid(m_readPosition, frameSize));
+            }
+            m_readPosition = index + delimiter.size();
+            index = m_buffer.indexOf(delimiter, m_readPosition);
+        }
+
+        if (m_buffer.size() - m_readPosition > m_configuration.maximumFrameSize + delimiter.size()) {
+            discardBuffer("No delimiter found within the maximum frame size");
+        }
+        break;
+    }
+    case ModeFixedLength: {
+        int frameLength = m_configuration.frameLength;
+        if (frameLength <= 0) {
+            flushBuffer();
+            return;
+        }
+
+        while (m_buffer.size() - m_readPosition >= frameLength) {
+            emit frameReceived(m_buffer.mid(m_readPosition, frameLength));
+            m_readPosition += frameLength;
+        }
+        break;
+    }
+    case ModeLengthPrefix: {
+        int prefixSize = m_configuration.lengthPrefixSize;
+        while (m_buffer.size() - m_readPosition >= prefixSize) {
+            quint32 frameLength = 0;
+            for (int i = 0; i < prefixSize; i++) {
+                frameLength = (frameLength << 8) | static_cast<quint8>(m_buffer.at(m_readPosition + i));
+            }
+
+            if (frameLength > static_cast<quint32>(m_configuration.maximumFrameSize)) {
+                // There is no way to find the start of the next frame again
+                discardBuffer(QString("Announced frame length %1 exceeds the maximum frame size").arg(frameLength));
+                return;
+            }
+
+            if (static_cast<quint32>(m_buffer.size() - m_readPosition - prefixSize) < frameLength)
+                break;
+
+            emit frameReceived(m_buffer.mid(m_readPosition + prefixSize, static_cast<int>(frameLength)));
+            m_readPosition += prefixSize + static_cast<int>(frameLength);
+        }
+        break;
+    }
+    case ModeIdleGap:
+        if (m_buffer.size() - m_readPosition >= m_configuration.maximumFrameSize) {
+            flushBuffer();
+        } else {
+            m_idleTimer->start();
+        }
+        break;
+    case ModeNone:
+        flushBuffer();
+        break;
+    }
+}
+
+void StreamFramer::flushBuffer()
+{
+    if (m_idleTimer)
+        m_idleTimer->stop();
+
+    if (m_readPosition >= m_buffer.size())
+        return;
+
+    QByteArray frame = m_buffer.mid(m_readPosition);
+    m_buffer.clear();
+    m_readPosition = 0;
+    emit frameReceived(frame);
+}
+
+void StreamFramer::discardBuffer(const QString &reason)
+{
+    qCWarning(m_configuration.loggingCategory) << "Discarding" << m_buffer.size() - m_readPosition << "bytes of received data:" << reason;
+    m_buffer.clear();
+    m_readPosition = 0;
+}
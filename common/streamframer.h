@@ -0,0 +1,92 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef STREAMFRAMER_H
+#define STREAMFRAMER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(dcStreamFramer)
+
+// Splits a byte stream into frames, so one logical message results in exactly
+// one frame no matter how the data has been fragmented on the way.
+class StreamFramer : public QObject
+{
+    Q_OBJECT
+public:
+    enum Mode {
+        ModeNone,           // Every chunk of received data is a frame
+        ModeDelimiter,      // Frames are terminated by a delimiter
+        ModeFixedLength,    // Frames have a fixed length
+        ModeLengthPrefix,   // Frames start with a big endian length field
+        ModeIdleGap         // Frames are separated by a gap in the stream
+    };
+    Q_ENUM(Mode)
+
+    struct Configuration {
+        Mode mode = ModeNone;
+        QByteArray delimiter = "\n";
+        int frameLength = 0;
+        int lengthPrefixSize = 2;
+        int idleTimeout = 50;
+        int maximumFrameSize = 65536;
+        // Plugins pass their own category so warnings show up in their log
+        const QLoggingCategory &(*loggingCategory)() = dcStreamFramer;
+    };
+
+    explicit StreamFramer(const Configuration &configuration, QObject *parent = nullptr);
+
+    Configuration configuration() const;
+
+    void addData(const QByteArray &data);
+    void reset();
+
+    static Mode modeFromString(const QString &mode);
+    static QByteArray decodeDelimiter(const QString &delimiter);
+
+signals:
+    void frameReceived(const QByteArray &frame);
+
+private:
+    Configuration m_configuration;
+    QTimer *m_idleTimer = nullptr;
+
+    // Received data, everything before m_readPosition has already been framed
+    QByteArray m_buffer;
+    int m_readPosition = 0;
+
+    void processBuffer();
+    void flushBuffer();
+    void discardBuffer(const QString &reason);
+};
+
+#endif // STREAMFRAMER_H
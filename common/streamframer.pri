@@ -0,0 +1,7 @@
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/streamframer.cpp \
+
+HEADERS += \
+    $$PWD/streamframer.h \
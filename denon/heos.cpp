@@ -588,602 +588,574 @@ void Heos::onError(QAbstractSocket::SocketError socketError)
 
 void Heos::readData()
 {
-    QByteArray data;
-    QJsonParseError error;
-
     while (m_socket->canReadLine()) {
-        data = m_socket->readLine();
-        QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
-        if (error.error != QJsonParseError::NoError) {
-            qCWarning(dcDenon) << "failed to parse json :" << error.errorString();
-            return;
+        processLine(m_socket->readLine());
+    }
+}
+
+const QHash<QString, Heos::ResponseHandler> &Heos::responseHandlers()
+{
+    static const QHash<QString, ResponseHandler> handlers = {
+        /*
+         * 4.1 System Commands
+         */
+        { "system/register_for_change_events", &Heos::processRegisterForChangeEvents },
+        { "system/check_account", &Heos::processCheckAccount },
+        { "system/sign_in", &Heos::processSignIn },
+        { "system/sign_out", &Heos::processSignOut },
+        { "system/heart_beat", nullptr },
+        { "system/reboot", nullptr },
+        { "system/prettify_json_response", nullptr },
+
+        /*
+         * 4.2 Player Commands
+         */
+        { "player/get_players", &Heos::processGetPlayers },
+        { "player/get_player_info", &Heos::processGetPlayerInfo },
+        { "player/get_now_playing_media", &Heos::processNowPlayingMedia },
+        { "player/get_play_state", &Heos::processPlayState },
+        { "player/set_play_state", &Heos::processPlayState },
+        { "player/get_volume", &Heos::processVolume },
+        { "player/set_volume", &Heos::processVolume },
+        { "player/get_mute", &Heos::processMute },
+        { "player/set_mute", &Heos::processMute },
+        { "player/get_play_mode", &Heos::processPlayMode },
+        { "player/set_play_mode", &Heos::processPlayMode },
+        { "player/check_update", &Heos::processCheckUpdate },
+        { "player/volume_up", nullptr },
+        { "player/volume_down", nullptr },
+        { "player/toggle_mute", nullptr },
+        { "player/get_queue", nullptr },
+        { "player/clear_queue", nullptr },
+        { "player/move_queue_item", nullptr },
+        { "player/play_next", nullptr },
+        { "player/play_previous", nullptr },
+
+        /*
+         * 4.3 Group Commands
+         */
+        { "group/get_groups", &Heos::processGetGroups },
+        { "group/get_group_info", &Heos::processGetGroupInfo },
+        { "group/set_group", &Heos::processSetGroup },
+        { "group/get_volume", &Heos::processGroupVolume },
+        { "group/set_volume", &Heos::processGroupVolume },
+        { "group/volume_up", nullptr },
+        { "group/volume_down", nullptr },
+        { "group/get_mute", &Heos::processGroupMute },
+        { "group/set_mute", &Heos::processGroupMute },
+        { "group/toggle_mute", nullptr },
+
+        /*
+         * 4.4 Browse Commands
+         */
+        { "browse/get_music_sources", &Heos::processMusicSources },
+        { "browse/get_source_info", &Heos::processMusicSources },
+        { "browse/browse", &Heos::processBrowse },
+        { "browse/get_search_criteria", nullptr },
+        { "browse/play_stream", nullptr },
+        { "browse/play_preset", nullptr },
+        { "browse/play_input", nullptr },
+        { "browse/add_to_queue", nullptr },
+        { "browse/rename_playlist", nullptr },
+        { "browse/delete_playlist", nullptr },
+        { "browse/retrieve_metadata", nullptr },
+
+        /*
+         * 5. Change Events (Unsolicited Responses)
+         */
+        { "event/sources_changed", &Heos::processSourcesChangedEvent },
+        { "event/players_changed", &Heos::processPlayersChangedEvent },
+        { "event/groups_changed", &Heos::processGroupsChangedEvent },
+        { "event/player_state_changed", &Heos::processPlayerStateChangedEvent },
+        { "event/player_now_playing_changed", &Heos::processNowPlayingChangedEvent },
+        { "event/player_now_playing_progress", &Heos::processNowPlayingProgressEvent },
+        { "event/player_playback_error", &Heos::processPlaybackErrorEvent },
+        { "event/player_queue_changed", &Heos::processQueueChangedEvent },
+        { "event/player_volume_changed", &Heos::processPlayerVolumeChangedEvent },
+        { "event/repeat_mode_changed", &Heos::processRepeatModeChangedEvent },
+        { "event/shuffle_mode_changed", &Heos::processShuffleModeChangedEvent },
+        { "event/group_volume_changed", &Heos::processGroupVolumeChangedEvent },
+        { "event/user_changed", &Heos::processUserChangedEvent }
+    };
+    return handlers;
+}
+
+QHash<QString, QString> Heos::parseMessage(const QString &message)
+{
+    // The message field is formatted like a URL query, i.e. "pid=1&cur_pos=1000&duration=2000".
+    // Flags like "signed_in" or "command under process" come without a value.
+    QHash<QString, QString> arguments;
+    foreach (const QStringRef &item, message.splitRef('&')) {
+        if (item.isEmpty())
+            continue;
+
+        int separator = item.indexOf('=');
+        if (separator < 0) {
+            arguments.insert(item.toString(), QString());
+            continue;
         }
-        QVariantMap dataMap = jsonDoc.toVariant().toMap();
-        if (dataMap.contains("heos")) {
-            QString command = dataMap.value("heos").toMap().value("command").toString();
-            QUrlQuery message(dataMap.value("heos").toMap().value("message").toString());
-            bool success = false;
-            if(dataMap.value("heos").toMap().contains("result")) {
-                //If the message doesn't contain result it is an event message
-                success = dataMap.value("heos").toMap().value("result").toString().contains("success");
-                if (!success) {
-                    qCWarning(dcDenon()) << "Command:" << command << "was not successfull. Message:" << message.toString();
-                    if (command == "system/sign_in") {
-                        emit userChanged(false, "");
-                    }
-                }
-            }
-            /*
-             * 4.1 System Commands
-             *  4.1.1 Register for Change Events
-             *  4.1.2 HEOS Account Check
-             *  4.1.3 HEOS Account Sign In
-             *  4.1.4 HEOS Account Sign Out
-             *  4.1.5 HEOS System Heart Beat
-             *  4.1.6 HEOS Speaker Reboot
-             *  4.1.7 Prettify JSON response
-            */
-            if (command.startsWith("system")) {
-                if (command.contains("register_for_change_events")) {
-                    QString enabled = message.queryItemValue("enabled");
-                    if (enabled.contains("off")) {
-                        qDebug(dcDenon) << "Events are disabled";
-                        m_eventRegistered = false;
-                        emit systemEventsEnabled(false);
-                    } else {
-                        qDebug(dcDenon) << "Events are enabled";
-                        m_eventRegistered = true;
-                        emit systemEventsEnabled(true);
-                    }
-
-                } else if (command.contains("check_account")) {
-
-                    qDebug(dcDenon()) << "System command check_account:" << message.toString();
-                    bool signedIn;
-                    QString username = "";
-                    if (message.hasQueryItem("signed_in")){
-                        signedIn = true;
-                        username = message.queryItemValue("un");
-                    } else {
-                        signedIn = false;
-                    }
-                    emit userChanged(signedIn, username);
-
-                } else if (command.contains("sign_in")) {
-
-                    qDebug(dcDenon()) << "System command sign_in:" << message.toString();
-
-                    if (message.hasQueryItem("signed_in")) {
-                        QString username = message.queryItemValue("un");
-                        emit userChanged(true, username);
-
-                    } // otherwise it will be command under process and we will wait for the event
-                } else if (command.contains("sign_out")) {
-
-                    qDebug(dcDenon()) << "System command sign_out:" << message.toString();
-                    emit userChanged(false, "");
-
-                } else if (command.contains("heart_beat")) {
-
-                } else if (command.contains("reboot")) {
-
-                } else if (command.contains("prettify_json_response")) {
-
-                }  else {
-                    qDebug(dcDenon) << "Unhandled Heos system command" << command;
-                }
-                /* 4.2 Player Commands
-             *  4.2.1 Get Players
-             *  4.2.2 Get Player Info
-             *  4.2.3 Get Play State
-             *  4.2.4 Set Play State
-             *  4.2.5 Get Now Playing Media
-             *  4.2.6 Get Volume
-             *  4.2.7 Set Volume
-             *  4.2.8 Volume Up
-             *  4.2.9 Volume Down
-             *  4.2.10 Get Mute
-             *  4.2.11 Set Mute
-             *  4.2.12 Toggle Mute
-             *  4.2.13 Get Play Mode
-             *  4.2.14 Set Play Mode
-             *  4.2.15 Get Queue
-             *  4.2.16 Play Queue Item
-             *  4.2.17 Remove Item(s) from Queue
-             *  4.2.18 Save Queue as Playlist
-             *  4.2.19 Clear Queue
-             *  4.2.20 Move Queue
-             *  4.2.21 Play Next
-             *  4.2.22 Play Previous
-             *  4.2.23 Set QuickSelect [LS AVR Only]
-             *  4.2.24 Play QuickSelect [LS AVR Only]
-             *  4.2.25 Get QuickSelects [LS AVR Only]
-             *  4.2.26 Check for Firmware Update
-             */
-            } else if (command.startsWith("player")) {
-                int playerId = 0;
-                if (message.hasQueryItem("pid")) {
-                    playerId = message.queryItemValue("pid").toInt();
-                }
-
-                if (command.contains("get_players")) {
-                    QVariantList payloadVariantList = jsonDoc.toVariant().toMap().value("payload").toList();
-                    QList<HeosPlayer *> players;
-                    foreach (const QVariant &payloadEntryVariant, payloadVariantList) {
-                        HeosPlayer *player = new HeosPlayer(payloadEntryVariant.toMap().value("pid").toInt());
-                        player->setSerialNumber(payloadEntryVariant.toMap().value("serial").toString());
-                        player->setName(payloadEntryVariant.toMap().value("name").toString());
-                        getPlayerInfo(player->playerId());
-                        players.append(player);
-                    }
-                    emit playersRecieved(players);
-
-                } else if (command.contains("get_player_info")) {
-                    //update heos player info
-                    int pid = dataMap.value("payload").toMap().value("pid").toInt();
-                    HeosPlayer *player = new HeosPlayer(pid);
-                    player->setName(dataMap.value("payload").toMap().value("name").toString());
-                    if (dataMap.value("payload").toMap().contains("gid")) {
-                        player->setGroupId(dataMap.value("payload").toMap().value("gid").toInt());
-                    } else {
-                        player->setGroupId(-1); //no group assigned
-                    }
-                    player->setPlayerModel(dataMap.value("payload").toMap().value("model").toString());
-                    player->setPlayerVersion(dataMap.value("payload").toMap().value("version").toString());
-                    player->setLineOut(dataMap.value("payload").toMap().value("lineout").toString());
-                    player->setControl(dataMap.value("payload").toMap().value("control").toString());
-                    player->setSerialNumber(dataMap.value("payload").toMap().value("serial").toString());
-                    player->setNetwork(dataMap.value("payload").toMap().value("network").toString());
-                    emit playerInfoRecieved(player);
-
-                } else if (command.contains("get_now_playing_media")) {
-
-                    QString artist = dataMap.value("payload").toMap().value("artist").toString();
-                    QString song = dataMap.value("payload").toMap().value("song").toString();
-                    QString artwork = dataMap.value("payload").toMap().value("image_url").toString();
-                    QString album = dataMap.value("payload").toMap().value("album").toString();
-                    QString sourceId = dataMap.value("payload").toMap().value("sid").toString();
-                    qDebug(dcDenon) << "Now playing" << playerId << sourceId << artist << album << song;
-                    emit nowPlayingMediaStatusReceived(playerId, sourceId, artist, album, song, artwork);
-
-                } else if (command.contains("get_play_state") || command.contains("set_play_state")) {
-                    if (message.hasQueryItem("state")) {
-                        PLAYER_STATE playState =  PLAYER_STATE_STOP;
-                        if (message.queryItemValue("state").contains("play")) {
-                            playState =  PLAYER_STATE_PLAY;
-                        } else if (message.queryItemValue("state").contains("pause")) {
-                            playState = PLAYER_STATE_PAUSE;
-                        } else if (message.queryItemValue("state").contains("stop")) {
-                            playState =  PLAYER_STATE_STOP;
-                        }
-                        emit playerPlayStateReceived(playerId, playState);
-                    }
-                } else if (command.contains("get_volume") || command.contains("set_volume")) {
-                    if (message.hasQueryItem("level")) {
-                        int volume = message.queryItemValue("level").toInt();
-                        emit playerVolumeReceived(playerId, volume);
-                    }
-                } else if (command.contains("get_mute") || command.contains("set_mute")) {
-                    if (message.hasQueryItem("state")) {
-                        QString state = message.queryItemValue("state");
-                        if (state.contains("on")) {
-                            emit playerMuteStatusReceived(playerId, true);
-                        } else {
-                            emit playerMuteStatusReceived(playerId, false);
-                        }
-                    }
-                } else if (command.contains("get_play_mode") || command.contains("set_play_mode")) {
-                    if (message.hasQueryItem("shuffle") && message.hasQueryItem("repeat")) {
-                        bool shuffle;
-                        if (message.queryItemValue("shuffle").contains("on")){
-                            shuffle = true;
-                        } else {
-                            shuffle = false;
-                        }
-                        emit playerShuffleModeReceived(playerId, shuffle);
-
-                        REPEAT_MODE repeatMode = REPEAT_MODE_OFF;
-                        if (message.queryItemValue("repeat").contains("on_all")){
-                            repeatMode = REPEAT_MODE_ALL;
-                        } else if (message.queryItemValue("repeat").contains("on_one")){
-                            repeatMode = REPEAT_MODE_ONE;
-                        } else  if (message.queryItemValue("repeat").contains("off")){
-                            repeatMode = REPEAT_MODE_OFF;
-                        }
-                        emit playerRepeatModeReceived(playerId, repeatMode);
-                    }
-                } else if (command.contains("check_update")) {
-                    QVariantMap payloadVariantMap = jsonDoc.toVariant().toMap().value("payload").toMap();
-                    bool updateExist = payloadVariantMap.value("update").toString().contains("exist");
-                    emit playerUpdateAvailable(playerId, updateExist);
-                } else {
-                    qDebug(dcDenon) << "Unhandled Heos group command" << command;
-                }
-                /*
-             * 4.3 Group Commands
-             *  4.3.1 Get Groups
-             *  4.3.2 Get Group Info
-             *  4.3.3 Set Group
-             *  4.3.4 Get Group Volume
-             *  4.3.5 Set Group Volume
-             *  4.2.6 Group Volume Up
-             *  4.2.7 Group Volume Down
-             *  4.3.8 Get Group Mute
-             *  4.3.9 Set Group Mute
-             *  4.3.10 Toggle Group Mute
-             */
-            } else if (command.startsWith("group")) {
-                int groupId = 0;
-                if (message.hasQueryItem("gid")) {
-                    qDebug(dcDenon) << "Group id" << message.queryItemValue("gid");
-                    groupId = message.queryItemValue("gid").toInt();
-                }
-                if (command.contains("get_groups")) {
-                    QVariantList payloadVariantList = jsonDoc.toVariant().toMap().value("payload").toList();
-                    QList<GroupObject> groups;
-                    foreach (const QVariant &payloadEntryVariant, payloadVariantList) {
-                        GroupObject group;
-                        group.groupId = payloadEntryVariant.toMap().value("gid").toInt();
-                        group.name = payloadEntryVariant.toMap().value("name").toString();
-                        if (!payloadEntryVariant.toMap().value("players").toList().isEmpty()) {
-                            QVariantList playerlist = payloadEntryVariant.toMap().value("players").toList();
-                            foreach (const QVariant &playerVariant, playerlist) {
-                                PlayerObject player;
-                                player.name = playerVariant.toMap().value("name").toString();
-                                player.playerId = playerVariant.toMap().value("pid").toInt();
-                                group.players.append(player);
-                            }
-                        }
-                        groups.append(group);
-                    }
-                    emit groupsReceived(groups);
-                } else if (command.contains("get_group_info")) {
-                    QVariantMap payloadVariantMap = jsonDoc.toVariant().toMap().value("payload").toMap();
-                    GroupObject group;
-                    group.groupId = payloadVariantMap.value("gid").toInt();
-                    group.name = payloadVariantMap.value("name").toString();
-                    if (!payloadVariantMap.value("players").toList().isEmpty()) {
-                        QVariantList playerlist = payloadVariantMap.value("players").toList();
-                        foreach (const QVariant &playerVariant, playerlist) {
-                            PlayerObject player;
-                            player.name = playerVariant.toMap().value("name").toString();
-                            player.playerId = playerVariant.toMap().value("pid").toInt();
-                            group.players.append(player);
-                        }
-                    }
-                    emit groupInfoReceived(group);
-
-                } else if (command.contains("set_group")) {
-                    if (message.hasQueryItem("gid")) {
-
-                        int groupId = message.queryItemValue("gid").toInt();
-                        QString groupName = message.queryItemValue("name");
-                        emit setGroupReceived(groupId, groupName);
-                    } else {
-                        //No group Id so it must have been an ungoup request
-                        int playerId = message.queryItemValue("pid").toInt();
-                        emit deleteGroupReceived(playerId);
-                    }
-
-                } else if (command.contains("get_volume") || command.contains("set_volume")) {
-
-                    if (message.hasQueryItem("level")) {
-                        int volume = message.queryItemValue("level").toInt();
-                        emit groupVolumeReceived(groupId, volume);
-                    }
-
-                } else if (command.contains("volume_up") || command.contains("volume_down")) {
-
-                } else if (command.contains("get_mute") || command.contains("set_mute")) {
-
-                    if (message.hasQueryItem("state")) {
-                        QString state = message.queryItemValue("state");
-                        if (state.contains("on")) {
-                            emit playerMuteStatusReceived(groupId, true);
-                        } else {
-                            emit playerMuteStatusReceived(groupId, false);
-                        }
-                    }
-                } else if (command.contains("toggle_mute")) {
-
-                } else {
-                    qDebug(dcDenon) << "Unhandled Heos group command" << command;
-                }
-
-
-                /* 4.4 Browse Commands
-                                                  *  4.4.1 Get Music Sources                         - "command": "browse/get_music_sources"
-                                                  *  4.4.2 Get Source Info                           - "command": "browse/get_source_info"
-                                                  *  4.4.3 Browse Source                             - "command": "browse/browse",
-                                                  *  4.4.4 Browse Source Containers                  - "command": "browse/browse",
-                                                  *  4.4.5 Get Source Search Criteria                - "command": "browse/get_search_criteria"
-                                                  *  4.4.6 Search                                    - "command": "browse/search"
-                                                  *  4.4.7 Play Station                              - "command": "browse/play_stream"
-                                                  *  4.4.8 Play Preset Station                       - "command": "browse/play_preset"
-                                                  *  4.4.9 Play Input source                         - "command": "browse/play_input"
-                                                  *  4.4.10 Play URL                                 - "command": "browse/play_stream "
-                                                  *  4.4.11 Add Container to Queue with Options      - "command": "browse/add_to_queue"
-                                                  *  4.4.12 Add Track to Queue with Options          - "command": "browse/add_to_queue"
-                                                  *  4.4.14 Rename HEOS Playlist                     - "command": "browse/rename_playlist"
-                                                  *  4.4.15 Delete HEOS Playlist                     - "command": "browse/delete_playlist "
-                                                  *  4.4.17 Retrieve Album Metadata                  - "command": "browse/retrieve_metadata",
-                                                 */
-            } else if (command.startsWith("browse") || command.startsWith(" browse")) {
-
-                quint32 sequenceNumber = 0;
-                if (message.hasQueryItem("SEQUENCE")) {
-                    qDebug(dcDenon) << "Sequence number" << message.queryItemValue("SEQUENCE");
-                    sequenceNumber = message.queryItemValue("SEQUENCE").toUInt();
-                }
-
-                if (command.contains("get_music_sources") || command.contains("get_source_info")) {
-                    qDebug(dcDenon()) << "Get music source request response received" << command;
-                    QVariantList payloadVariantList = jsonDoc.toVariant().toMap().value("payload").toList();
-                    QList<MusicSourceObject> musicSources;
-                    if (success) {
-                        foreach (const QVariant &payloadEntryVariant, payloadVariantList) {
-                            MusicSourceObject source;
-                            source.name = payloadEntryVariant.toMap().value("name").toString();
-                            source.image_url = payloadEntryVariant.toMap().value("image_url").toString();
-                            source.type = payloadEntryVariant.toMap().value("type").toString();
-                            source.sourceId = payloadEntryVariant.toMap().value("sid").toInt();
-                            source.available = payloadEntryVariant.toMap().value("available").toString().contains("true");
-                            source.serviceUsername = payloadEntryVariant.toMap().value("service_username").toString();
-                            musicSources.append(source);
-                        }
-                        emit musicSourcesReceived(sequenceNumber, musicSources);
-                    }
-
-                } else if (command.contains("browse/browse")) {
-                    qDebug(dcDenon()) << "Browse response:"  << jsonDoc.toVariant().toMap().value("payload");
-                    QVariantList payloadVariantList = jsonDoc.toVariant().toMap().value("payload").toList();
-                    QString sourceId;
-                    QString containerId;
-                    if (message.hasQueryItem("sid")) {
-                        sourceId = message.queryItemValue("sid");
-                    }
-                    if (message.hasQueryItem("cid")) {
-                        containerId = message.queryItemValue("cid");
-                    }
-
-                    if (message.toString().contains("command under process")){
-                        qDebug(dcDenon()) << "Browse command is beeing processed";
-                        return;
-                    }
-                    if (success) {
-                        QList<MusicSourceObject> musicSources;
-                        QList<MediaObject> mediaItems;
-                        foreach (const QVariant &payloadEntryVariant, payloadVariantList) {
-                            QString type = payloadEntryVariant.toMap().value("type").toString();
-                            if (type == "source") {
-                                MusicSourceObject source;
-                                source.name = payloadEntryVariant.toMap().value("name").toString();
-                                source.image_url = payloadEntryVariant.toMap().value("image_url").toString();
-                                source.type = payloadEntryVariant.toMap().value("type").toString();
-                                source.sourceId = payloadEntryVariant.toMap().value("sid").toInt();
-                                qDebug(dcDenon()) << "Source" << source.name << source.type << source.sourceId << payloadEntryVariant.toMap().value("sid");
-                                //source.available = payloadEntryVariant.toMap().value("available").toString().contains("true");
-                                //source.serviceUsername = payloadEntryVariant.toMap().value("service_username").toString();
-                                musicSources.append(source);
-                            } else {
-                                MediaObject media;
-                                qDebug(dcDenon()) << "Media Item" << payloadEntryVariant.toMap().value("mid").toString() << payloadEntryVariant.toMap().value("cid").toString();
-                                media.name = payloadEntryVariant.toMap().value("name").toString();
-                                if (payloadEntryVariant.toMap().contains("cid")) {
-                                    media.containerId = payloadEntryVariant.toMap().value("cid").toString();
-                                } else {
-                                    media.containerId = message.queryItemValue("cid");
-                                }
-                                media.mediaId = payloadEntryVariant.toMap().value("mid").toString();
-                                media.imageUrl = payloadEntryVariant.toMap().value("image_url").toString();
-                                media.isPlayable = payloadEntryVariant.toMap().value("playable").toString().contains("yes");
-                                media.isContainer = payloadEntryVariant.toMap().value("container").toString().contains("yes");
-                                media.sourceId = sourceId;
-                                if (type == "artist") {
-                                    media.mediaType = MEDIA_TYPE_ARTIST;
-                                } else if (type == "song") {
-                                    media.mediaType = MEDIA_TYPE_SONG;
-                                } else if (type == "genre") {
-                                    media.mediaType = MEDIA_TYPE_GENRE;
-                                } else if (type == "station") {
-                                    media.mediaType = MEDIA_TYPE_STATION;
-                                } else if (type == "album") {
-                                    media.mediaType = MEDIA_TYPE_ALBUM;
-                                } else if (type == "container") {
-                                    media.mediaType = MEDIA_TYPE_CONTAINER;
-                                }
-                                mediaItems.append(media);
-                            }
-                        }
-                        emit browseRequestReceived(sequenceNumber, sourceId, containerId, musicSources, mediaItems);
-                    }
-                    else {
-                        int errorId = message.queryItemValue("eid").toInt();
-                        QString text = message.queryItemValue("text");
-                        emit browseErrorReceived(sourceId, containerId, errorId, text);
-                    }
-                } else if (command.contains("play_preset")) {
-
-                } else if (command.contains("play_input")) {
-                    qCDebug(dcDenon()) << "Command play input";
-
-                } else if (command.contains("add_to_queue")) {
-
-                } else if (command.contains("rename_playlist")) {
-
-                } else if (command.contains("delete_playlist")) {
-
-                } else if (command.contains("retrieve_metadata")) {
-
-                } else {
-                    qDebug(dcDenon) << "Unhandled Heos browse command" << command;
-                }
-
-
-                /*
-             * 5. Change Events (Unsolicited Responses) 5.1 Sources Changed
-             * 5.2 Players Changed
-             * 5.3 Group Changed
-             * 5.4 Player State Changed
-             * 5.5 Player Now Playing Changed
-             * 5.6 Player Now Playing Progress
-             * 5.7 Player Playback Error
-             * 5.8 Player Queue Changed
-             * 5.9 Player Volume Changed
-             * 5.10 Player Repeat Mode Changed
-             * 5.11 Player Shuffle Mode Changed
-             * 5.12 Group Volume Changed
-             * 5.13 User Changed
-             */
-            } else if (command.startsWith("event")) {
-                if (command.contains("sources_changed")) {
-                    emit sourcesChanged();
-
-                } else if (command.contains("players_changed")) {
-                    emit playersChanged();
-
-                } else if (command.contains("groups_changed")) {
-                    emit groupsChanged();
-
-                } else if (command.contains("player_state_changed")) {
-                    qDebug(dcDenon()) << "Player state changed";
-                    if (message.hasQueryItem("pid")) {
-                        int playerId = message.queryItemValue("pid").toInt();
-                        if (message.hasQueryItem("state")) {
-                            PLAYER_STATE playState = PLAYER_STATE_STOP;
-                            if (message.queryItemValue("state").contains("play")) {
-                                playState = PLAYER_STATE_PLAY;
-                            } else if (message.queryItemValue("state").contains("pause")) {
-                                playState = PLAYER_STATE_PAUSE;
-                            } else if (message.queryItemValue("state").contains("stop")) {
-                                playState = PLAYER_STATE_STOP;
-                            }
-                            emit playerPlayStateReceived(playerId, playState);
-                        }
-                    }
-                } else if (command.contains("player_now_playing_changed")) {
-                    qDebug(dcDenon()) << "Player now playing changed, player id:" << message.queryItemValue("pid").toInt();
-                    if (message.hasQueryItem("pid")) {
-                        int playerId = message.queryItemValue("pid").toInt();
-                        emit playerNowPlayingChanged(playerId);
-                    }
-                } else if (command.contains("player_now_playing_progress")) {
-                    //qDebug(dcDenon()) << "Player now playing progress";
-                    if (message.hasQueryItem("pid")) {
-                        int playerId = message.queryItemValue("pid").toInt();
-                        int currentPossition = message.queryItemValue("cur_pos").toInt();
-                        int duration = message.queryItemValue("duration").toInt();
-                        emit playerNowPlayingProgressReceived(playerId, currentPossition, duration);
-                    }
-                } else if (command.contains("player_playback_error")) {
-                    qDebug(dcDenon) << "Player playback error";
-                    int playerId = 0;
-                    if (message.hasQueryItem("pid")) {
-                        playerId = message.queryItemValue("pid").toInt();
-                        QString errorMessage = message.queryItemValue("error");
-                        emit playerPlaybackErrorReceived(playerId, errorMessage);
-                    }
-                } else if (command.contains("player_queue_changed")) {
-                    qDebug(dcDenon()) << "Player queue Changed";
-                    int playerId = 0;
-                    if (message.hasQueryItem("pid")) {
-                        playerId = message.queryItemValue("pid").toInt();
-                        emit playerQueueChanged(playerId);
-                    }
-                } else if (command.contains("player_volume_changed")) {
-                    qDebug(dcDenon()) << "Event player volume Changed";
-                    int playerId = 0;
-                    if (message.hasQueryItem("pid")) {
-                        playerId = message.queryItemValue("pid").toInt();
-
-                        if (message.hasQueryItem("level")) {
-                            int volume = message.queryItemValue("level").toInt();
-                            emit playerVolumeReceived(playerId, volume);
-                        }
-                        if (message.hasQueryItem("mute")) {
-                            bool mute;
-                            if (message.queryItemValue("mute").contains("on")) {
-                                mute = true;
-                            } else {
-                                mute = false;
-                            }
-                            emit playerMuteStatusReceived(playerId, mute);
-                        }
-                    }
-                } else if (command.contains("repeat_mode_changed")) {
-                    qDebug(dcDenon()) << "Repeat mode Changed";
-                    int playerId = 0;
-                    if (message.hasQueryItem("pid")) {
-                        playerId = message.queryItemValue("pid").toInt();
-
-                        if (message.hasQueryItem("repeat")) {
-                            REPEAT_MODE repeatMode = REPEAT_MODE_OFF;
-                            if (message.queryItemValue("repeat").contains("on_all")){
-                                repeatMode = REPEAT_MODE_ALL;
-                            } else if (message.queryItemValue("repeat").contains("on_one")){
-                                repeatMode = REPEAT_MODE_ONE;
-                            } else  if (message.queryItemValue("repeat").contains("off")){
-                                repeatMode = REPEAT_MODE_OFF;
-                            }
-                            emit playerRepeatModeReceived(playerId, repeatMode);
-                        }
-                    }
-                } else if (command.contains("shuffle_mode_changed")) {
-                    qDebug(dcDenon()) << "Shuffle mode Changed";
-                    int playerId = 0;
-                    if (message.hasQueryItem("pid")) {
-                        playerId = message.queryItemValue("pid").toInt();
-
-                        if (message.hasQueryItem("shuffle")) {
-                            bool shuffle;
-                            if (message.queryItemValue("shuffle").contains("on")){
-                                shuffle = true;
-                            } else {
-                                shuffle = false;
-                            }
-                            emit playerShuffleModeReceived(playerId, shuffle);
-                        }
-                    }
-                } else if (command.contains("group_volume_changed")) {
-                    qDebug(dcDenon()) << "Event group volume Changed";
-                    int playerId = 0;
-                    if (message.hasQueryItem("gid")) {
-                        playerId = message.queryItemValue("gid").toInt();
-
-                        if (message.hasQueryItem("level")) {
-                            int volume = message.queryItemValue("level").toInt();
-                            emit groupVolumeReceived(playerId, volume);
-                        }
-                        if (message.hasQueryItem("mute")) {
-                            bool mute;
-                            if (message.queryItemValue("mute").contains("on")) {
-                                mute = true;
-                            } else {
-                                mute = false;
-                            }
-                            emit groupMuteStatusReceived(playerId, mute);
-                        }
-                    }
-                } else if (command.contains("user_changed")) {
-
-                    qDebug(dcDenon()) << "Event user changed" << message.toString();
-                    bool signedIn;
-                    QString username;
-                    if (message.hasQueryItem("signed_out")){
-                        signedIn = false;
-                    } else {
-                        signedIn = true;
-                        username = message.queryItemValue("un");
-                    }
-                    emit userChanged(signedIn, username);
-                } else {
-                    qDebug(dcDenon) << "Unhandled Heos event";
-                }
-            } else {
-                qDebug(dcDenon) << "Unhandled Heos category" << command;
+
+        QStringRef value = item.mid(separator + 1);
+        if (value.contains('%')) {
+            arguments.insert(item.left(separator).toString(), QUrl::fromPercentEncoding(value.toUtf8()));
+        } else {
+            arguments.insert(item.left(separator).toString(), value.toString());
+        }
+    }
+    return arguments;
+}
+
+void Heos::processLine(const QByteArray &line)
+{
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(line, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qCWarning(dcDenon) << "failed to parse json :" << error.errorString();
+        return;
+    }
+
+    QJsonObject rootObject = jsonDoc.object();
+    QJsonObject heosObject = rootObject.value("heos").toObject();
+    if (heosObject.isEmpty())
+        return;
+
+    Response response;
+    // Note: some firmware versions send the command with a leading space
+    response.command = heosObject.value("command").toString().trimmed();
+    response.rawMessage = heosObject.value("message").toString();
+    response.message = parseMessage(response.rawMessage);
+    response.payload = rootObject.value("payload");
+
+    // If the message doesn't contain result it is an event message
+    QJsonValue result = heosObject.value("result");
+    if (!result.isUndefined()) {
+        response.success = result.toString().contains("success");
+        if (!response.success) {
+            qCWarning(dcDenon()) << "Command:" << response.command << "was not successfull. Message:" << response.rawMessage;
+            if (response.command == "system/sign_in") {
+                emit userChanged(false, "");
             }
         }
     }
+
+    const QHash<QString, ResponseHandler> &handlers = responseHandlers();
+    QHash<QString, ResponseHandler>::const_iterator handler = handlers.constFind(response.command);
+    if (handler == handlers.constEnd()) {
+        qCDebug(dcDenon) << "Unhandled Heos command" << response.command;
+        return;
+    }
+
+    if (handler.value()) {
+        (this->*handler.value())(response);
+    }
+}
+
+static int jsonInt(const QJsonValue &value)
+{
+    // Ids are sent as numbers or as strings depending on the firmware
+    if (value.isString())
+        return value.toString().toInt();
+
+    return value.toInt();
+}
+
+static PLAYER_STATE parsePlayerState(const QString &state)
+{
+    if (state.contains("play")) {
+        return PLAYER_STATE_PLAY;
+    } else if (state.contains("pause")) {
+        return PLAYER_STATE_PAUSE;
+    }
+    return PLAYER_STATE_STOP;
+}
+
+static REPEAT_MODE parseRepeatMode(const QString &repeat)
+{
+    if (repeat.contains("on_all")) {
+        return REPEAT_MODE_ALL;
+    } else if (repeat.contains("on_one")) {
+        return REPEAT_MODE_ONE;
+    }
+    return REPEAT_MODE_OFF;
+}
+
+static QList<PlayerObject> parseGroupPlayers(const QJsonArray &playerList)
+{
+    QList<PlayerObject> players;
+    foreach (const QJsonValue &playerValue, playerList) {
+        QJsonObject playerObject = playerValue.toObject();
+        PlayerObject player;
+        player.name = playerObject.value("name").toString();
+        player.playerId = jsonInt(playerObject.value("pid"));
+        players.append(player);
+    }
+    return players;
+}
+
+static MusicSourceObject parseMusicSource(const QJsonObject &sourceObject)
+{
+    MusicSourceObject source;
+    source.name = sourceObject.value("name").toString();
+    source.image_url = sourceObject.value("image_url").toString();
+    source.type = sourceObject.value("type").toString();
+    source.sourceId = jsonInt(sourceObject.value("sid"));
+    source.available = sourceObject.value("available").toString().contains("true");
+    source.serviceUsername = sourceObject.value("service_username").toString();
+    return source;
+}
+
+void Heos::processRegisterForChangeEvents(const Response &response)
+{
+    if (response.message.value("enabled").contains("off")) {
+        qCDebug(dcDenon) << "Events are disabled";
+        m_eventRegistered = false;
+        emit systemEventsEnabled(false);
+    } else {
+        qCDebug(dcDenon) << "Events are enabled";
+        m_eventRegistered = true;
+        emit systemEventsEnabled(true);
+    }
+}
+
+void Heos::processCheckAccount(const Response &response)
+{
+    qCDebug(dcDenon()) << "System command check_account:" << response.rawMessage;
+    if (response.message.contains("signed_in")) {
+        emit userChanged(true, response.message.value("un"));
+    } else {
+        emit userChanged(false, "");
+    }
+}
+
+void Heos::processSignIn(const Response &response)
+{
+    qCDebug(dcDenon()) << "System command sign_in:" << response.rawMessage;
+    // Otherwise it will be command under process and we will wait for the event
+    if (response.message.contains("signed_in")) {
+        emit userChanged(true, response.message.value("un"));
+    }
+}
+
+void Heos::processSignOut(const Response &response)
+{
+    qCDebug(dcDenon()) << "System command sign_out:" << response.rawMessage;
+    emit userChanged(false, "");
+}
+
+void Heos::processGetPlayers(const Response &response)
+{
+    QList<HeosPlayer *> players;
+    foreach (const QJsonValue &payloadEntry, response.payload.toArray()) {
+        QJsonObject playerObject = payloadEntry.toObject();
+        HeosPlayer *player = new HeosPlayer(jsonInt(playerObject.value("pid")));
+        player->setSerialNumber(playerObject.value("serial").toString());
+        player->setName(playerObject.value("name").toString());
+        getPlayerInfo(player->playerId());
+        players.append(player);
+    }
+    emit playersRecieved(players);
+}
+
+void Heos::processGetPlayerInfo(const Response &response)
+{
+    QJsonObject payload = response.payload.toObject();
+    HeosPlayer *player = new HeosPlayer(jsonInt(payload.value("pid")));
+    player->setName(payload.value("name").toString());
+    if (payload.contains("gid")) {
+        player->setGroupId(jsonInt(payload.value("gid")));
+    } else {
+        player->setGroupId(-1); //no group assigned
+    }
+    player->setPlayerModel(payload.value("model").toString());
+    player->setPlayerVersion(payload.value("version").toString());
+    player->setLineOut(payload.value("lineout").toVariant().toString());
+    player->setControl(payload.value("control").toVariant().toString());
+    player->setSerialNumber(payload.value("serial").toString());
+    player->setNetwork(payload.value("network").toString());
+    emit playerInfoRecieved(player);
+}
+
+void Heos::processNowPlayingMedia(const Response &response)
+{
+    int playerId = response.message.value("pid").toInt();
+    QJsonObject payload = response.payload.toObject();
+    QString artist = payload.value("artist").toString();
+    QString song = payload.value("song").toString();
+    QString artwork = payload.value("image_url").toString();
+    QString album = payload.value("album").toString();
+    QString sourceId = payload.value("sid").toVariant().toString();
+    qCDebug(dcDenon) << "Now playing" << playerId << sourceId << artist << album << song;
+    emit nowPlayingMediaStatusReceived(playerId, sourceId, artist, album, song, artwork);
+}
+
+void Heos::processPlayState(const Response &response)
+{
+    if (response.message.contains("state")) {
+        emit playerPlayStateReceived(response.message.value("pid").toInt(), parsePlayerState(response.message.value("state")));
+    }
+}
+
+void Heos::processVolume(const Response &response)
+{
+    if (response.message.contains("level")) {
+        emit playerVolumeReceived(response.message.value("pid").toInt(), response.message.value("level").toInt());
+    }
+}
+
+void Heos::processMute(const Response &response)
+{
+    if (response.message.contains("state")) {
+        emit playerMuteStatusReceived(response.message.value("pid").toInt(), response.message.value("state").contains("on"));
+    }
+}
+
+void Heos::processPlayMode(const Response &response)
+{
+    if (response.message.contains("shuffle") && response.message.contains("repeat")) {
+        int playerId = response.message.value("pid").toInt();
+        emit playerShuffleModeReceived(playerId, response.message.value("shuffle").contains("on"));
+        emit playerRepeatModeReceived(playerId, parseRepeatMode(response.message.value("repeat")));
+    }
+}
+
+void Heos::processCheckUpdate(const Response &response)
+{
+    bool updateExist = response.payload.toObject().value("update").toString().contains("exist");
+    emit playerUpdateAvailable(response.message.value("pid").toInt(), updateExist);
+}
+
+void Heos::processGetGroups(const Response &response)
+{
+    QList<GroupObject> groups;
+    foreach (const QJsonValue &payloadEntry, response.payload.toArray()) {
+        QJsonObject groupObject = payloadEntry.toObject();
+        GroupObject group;
+        group.groupId = jsonInt(groupObject.value("gid"));
+        group.name = groupObject.value("name").toString();
+        group.players = parseGroupPlayers(groupObject.value("players").toArray());
+        groups.append(group);
+    }
+    emit groupsReceived(groups);
+}
+
+void Heos::processGetGroupInfo(const Response &response)
+{
+    QJsonObject payload = response.payload.toObject();
+    GroupObject group;
+    group.groupId = jsonInt(payload.value("gid"));
+    group.name = payload.value("name").toString();
+    group.players = parseGroupPlayers(payload.value("players").toArray());
+    emit groupInfoReceived(group);
+}
+
+void Heos::processSetGroup(const Response &response)
+{
+    if (response.message.contains("gid")) {
+        emit setGroupReceived(response.message.value("gid").toInt(), response.message.value("name"));
+    } else {
+        //No group Id so it must have been an ungoup request
+        emit deleteGroupReceived(response.message.value("pid").toInt());
+    }
+}
+
+void Heos::processGroupVolume(const Response &response)
+{
+    if (response.message.contains("level")) {
+        emit groupVolumeReceived(response.message.value("gid").toInt(), response.message.value("level").toInt());
+    }
+}
+
+void Heos::processGroupMute(const Response &response)
+{
+    if (response.message.contains("state")) {
+        emit playerMuteStatusReceived(response.message.value("gid").toInt(), response.message.value("state").contains("on"));
+    }
+}
+
+void Heos::processMusicSources(const Response &response)
+{
+    qCDebug(dcDenon()) << "Get music source request response received" << response.command;
+    if (!response.success)
+        return;
+
+    QList<MusicSourceObject> musicSources;
+    foreach (const QJsonValue &payloadEntry, response.payload.toArray()) {
+        musicSources.append(parseMusicSource(payloadEntry.toObject()));
+    }
+    emit musicSourcesReceived(response.message.value("SEQUENCE").toUInt(), musicSources);
+}
+
+void Heos::processBrowse(const Response &response)
+{
+    QString sourceId = response.message.value("sid");
+    QString containerId = response.message.value("cid");
+
+    if (response.rawMessage.contains("command under process")) {
+        qCDebug(dcDenon()) << "Browse command is beeing processed";
+        return;
+    }
+
+    if (!response.success) {
+        int errorId = response.message.value("eid").toInt();
+        QString text = response.message.value("text");
+        emit browseErrorReceived(sourceId, containerId, errorId, text);
+        return;
+    }
+
+    QList<MusicSourceObject> musicSources;
+    QList<MediaObject> mediaItems;
+    foreach (const QJsonValue &payloadEntry, response.payload.toArray()) {
+        QJsonObject entryObject = payloadEntry.toObject();
+        QString type = entryObject.value("type").toString();
+        if (type == "source") {
+            musicSources.append(parseMusicSource(entryObject));
+            continue;
+        }
+
+        MediaObject media;
+        media.name = entryObject.value("name").toString();
+        if (entryObject.contains("cid")) {
+            media.containerId = entryObject.value("cid").toString();
+        } else {
+            media.containerId = containerId;
+        }
+        media.mediaId = entryObject.value("mid").toString();
+        media.imageUrl = entryObject.value("image_url").toString();
+        media.isPlayable = entryObject.value("playable").toString().contains("yes");
+        media.isContainer = entryObject.value("container").toString().contains("yes");
+        media.sourceId = sourceId;
+        if (type == "artist") {
+            media.mediaType = MEDIA_TYPE_ARTIST;
+        } else if (type == "song") {
+            media.mediaType = MEDIA_TYPE_SONG;
+        } else if (type == "genre") {
+            media.mediaType = MEDIA_TYPE_GENRE;
+        } else if (type == "station") {
+            media.mediaType = MEDIA_TYPE_STATION;
+        } else if (type == "album") {
+            media.mediaType = MEDIA_TYPE_ALBUM;
+        } else if (type == "container") {
+            media.mediaType = MEDIA_TYPE_CONTAINER;
+        }
+        mediaItems.append(media);
+    }
+    emit browseRequestReceived(response.message.value("SEQUENCE").toUInt(), sourceId, containerId, musicSources, mediaItems);
+}
+
+void Heos::processSourcesChangedEvent(const Response &response)
+{
+    Q_UNUSED(response)
+    emit sourcesChanged();
+}
+
+void Heos::processPlayersChangedEvent(const Response &response)
+{
+    Q_UNUSED(response)
+    emit playersChanged();
+}
+
+void Heos::processGroupsChangedEvent(const Response &response)
+{
+    Q_UNUSED(response)
+    emit groupsChanged();
+}
+
+void Heos::processPlayerStateChangedEvent(const Response &response)
+{
+    qCDebug(dcDenon()) << "Player state changed";
+    if (response.message.contains("pid") && response.message.contains("state")) {
+        emit playerPlayStateReceived(response.message.value("pid").toInt(), parsePlayerState(response.message.value("state")));
+    }
+}
+
+void Heos::processNowPlayingChangedEvent(const Response &response)
+{
+    qCDebug(dcDenon()) << "Player now playing changed, player id:" << response.message.value("pid");
+    if (response.message.contains("pid")) {
+        emit playerNowPlayingChanged(response.message.value("pid").toInt());
+    }
+}
+
+void Heos::processNowPlayingProgressEvent(const Response &response)
+{
+    if (response.message.contains("pid")) {
+        int playerId = response.message.value("pid").toInt();
+        int currentPosition = response.message.value("cur_pos").toInt();
+        int duration = response.message.value("duration").toInt();
+        emit playerNowPlayingProgressReceived(playerId, currentPosition, duration);
+    }
+}
+
+void Heos::processPlaybackErrorEvent(const Response &response)
+{
+    qCDebug(dcDenon) << "Player playback error";
+    if (response.message.contains("pid")) {
+        emit playerPlaybackErrorReceived(response.message.value("pid").toInt(), response.message.value("error"));
+    }
+}
+
+void Heos::processQueueChangedEvent(const Response &response)
+{
+    qCDebug(dcDenon()) << "Player queue Changed";
+    if (response.message.contains("pid")) {
+        emit playerQueueChanged(response.message.value("pid").toInt());
+    }
+}
+
+void Heos::processPlayerVolumeChangedEvent(const Response &response)
+{
+    qCDebug(dcDenon()) << "Event player volume Changed";
+    if (!response.message.contains("pid"))
+        return;
+
+    int playerId = response.message.value("pid").toInt();
+    if (response.message.contains("level")) {
+        emit playerVolumeReceived(playerId, response.message.value("level").toInt());
+    }
+    if (response.message.contains("mute")) {
+        emit playerMuteStatusReceived(playerId, response.message.value("mute").contains("on"));
+    }
+}
+
+void Heos::processRepeatModeChangedEvent(const Response &response)
+{
+    qCDebug(dcDenon()) << "Repeat mode Changed";
+    if (response.message.contains("pid") && response.message.contains("repeat")) {
+        emit playerRepeatModeReceived(response.message.value("pid").toInt(), parseRepeatMode(response.message.value("repeat")));
+    }
+}
+
+void Heos::processShuffleModeChangedEvent(const Response &response)
+{
+    qCDebug(dcDenon()) << "Shuffle mode Changed";
+    if (response.message.contains("pid") && response.message.contains("shuffle")) {
+        emit playerShuffleModeReceived(response.message.value("pid").toInt(), response.message.value("shuffle").contains("on"));
+    }
+}
+
+void Heos::processGroupVolumeChangedEvent(const Response &response)
+{
+    qCDebug(dcDenon()) << "Event group volume Changed";
+    if (!response.message.contains("gid"))
+        return;
+
+    int groupId = response.message.value("gid").toInt();
+    if (response.message.contains("level")) {
+        emit groupVolumeReceived(groupId, response.message.value("level").toInt());
+    }
+    if (response.message.contains("mute")) {
+        emit groupMuteStatusReceived(groupId, response.message.value("mute").contains("on"));
+    }
+}
+
+void Heos::processUserChangedEvent(const Response &response)
+{
+    qCDebug(dcDenon()) << "Event user changed" << response.rawMessage;
+    if (response.message.contains("signed_out")) {
+        emit userChanged(false, QString());
+    } else {
+        emit userChanged(true, response.message.value("un"));
+    }
 }
 
 quint32 Heos::createRandomNumber()
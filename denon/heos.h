@@ -35,6 +35,8 @@
 #include <QHostAddress>
 #include <QTcpSocket>
 #include <QTimer>
+#include <QHash>
+#include <QJsonValue>
 
 #include "heosplayer.h"
 #include "heostypes.h"
@@ -128,6 +130,64 @@ private:
     QTimer *m_reconnectTimer = nullptr;
     void setConnected(const bool &connected);
 
+    // A parsed response or event line
+    struct Response {
+        QString command;
+        QString rawMessage;
+        QHash<QString, QString> message;
+        QJsonValue payload;
+        bool success = false;
+    };
+
+    // Response handlers by exact command, a nullptr entry is a known command without data of interest
+    typedef void (Heos::*ResponseHandler)(const Response &response);
+    static const QHash<QString, ResponseHandler> &responseHandlers();
+    static QHash<QString, QString> parseMessage(const QString &message);
+
+    void processLine(const QByteArray &line);
+
+    // System commands
+    void processRegisterForChangeEvents(const Response &response);
+    void processCheckAccount(const Response &response);
+    void processSignIn(const Response &response);
+    void processSignOut(const Response &response);
+
+    // Player commands
+    void processGetPlayers(const Response &response);
+    void processGetPlayerInfo(const Response &response);
+    void processNowPlayingMedia(const Response &response);
+    void processPlayState(const Response &response);
+    void processVolume(const Response &response);
+    void processMute(const Response &response);
+    void processPlayMode(const Response &response);
+    void processCheckUpdate(const Response &response);
+
+    // Group commands
+    void processGetGroups(const Response &response);
+    void processGetGroupInfo(const Response &response);
+    void processSetGroup(const Response &response);
+    void processGroupVolume(const Response &response);
+    void processGroupMute(const Response &response);
+
+    // Browse commands
+    void processMusicSources(const Response &response);
+    void processBrowse(const Response &response);
+
+    // Change events
+    void processSourcesChangedEvent(const Response &response);
+    void processPlayersChangedEvent(const Response &response);
+    void processGroupsChangedEvent(const Response &response);
+    void processPlayerStateChangedEvent(const Response &response);
+    void processNowPlayingChangedEvent(const Response &response);
+    void processNowPlayingProgressEvent(const Response &response);
+    void processPlaybackErrorEvent(const Response &response);
+    void processQueueChangedEvent(const Response &response);
+    void processPlayerVolumeChangedEvent(const Response &response);
+    void processRepeatModeChangedEvent(const Response &response);
+    void processShuffleModeChangedEvent(const Response &response);
+    void processGroupVolumeChangedEvent(const Response &response);
+    void processUserChangedEvent(const Response &response);
+
 signals:
     void connectionStatusChanged(bool status);
     void systemEventsEnabled(bool status);
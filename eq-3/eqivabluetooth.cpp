@@ -331,8 +331,11 @@ void EqivaBluetooth::controllerStateChanged(const QLowEnergyController::Controll
     connect(m_eqivaService, &QLowEnergyService::characteristicWritten, this, [this](const QLowEnergyCharacteristic &info, const QByteArray &value){
         Q_UNUSED(info) // We're only writing one...
         Q_UNUSED(value)
-        qCDebug(dcEQ3()) << m_name << "Command sent:" << m_currentCommand.id << m_currentCommand.name;
+        qCDebug(dcEQ3()) << m_name << "Command sent:" << m_currentCommand.id << m_currentCommand.name << "after" << m_currentCommand.queueTime.elapsed() << "ms";
         m_commandTimeout.stop();
+        foreach (qint32 replacedId, m_currentCommand.replacedIds) {
+            emit commandResult(replacedId, true);
+        }
         emit commandResult(m_currentCommand.id, true);
         m_currentCommand.id = -1;
         processCommandQueue();
@@ -480,16 +483,42 @@ void EqivaBluetooth::sendDate()
     stream << static_cast<quint8>(now.time().second());
 
     // Example: 03130117172315 -> 03YYMMDDHHMMSS
-    enqueue("SetDate", data);
+    enqueue("SetDate", data, false);
 }
 
-int EqivaBluetooth::enqueue(const QString &name, const QByteArray &data)
+int EqivaBluetooth::enqueue(const QString &name, const QByteArray &data, bool userCommand)
 {
     Command cmd;
     cmd.name = name;
     cmd.id = m_nextCommandId++;
     cmd.data = data;
-    m_commandQueue.append(cmd);
+    cmd.userCommand = userCommand;
+    cmd.queueTime.start();
+
+    // A queued command of the same type is outdated now. Its result will be reported along with this one.
+    for (int i = 0; i < m_commandQueue.count(); i++) {
+        const Command &queued = m_commandQueue.at(i);
+        if (queued.data.at(0) == data.at(0)) {
+            qCDebug(dcEQ3()) << m_name << "Replacing queued command" << queued.id << queued.name << "with" << cmd.id;
+            cmd.replacedIds = queued.replacedIds;
+            cmd.replacedIds.append(queued.id);
+            cmd.queueTime = queued.queueTime;
+            cmd.userCommand = cmd.userCommand || queued.userCommand;
+            m_commandQueue.removeAt(i);
+            break;
+        }
+    }
+
+    int index = m_commandQueue.count();
+    if (cmd.userCommand) {
+        for (index = 0; index < m_commandQueue.count(); index++) {
+            if (!m_commandQueue.at(index).userCommand) {
+                break;
+            }
+        }
+    }
+    m_commandQueue.insert(index, cmd);
+
     processCommandQueue();
     return cmd.id;
 }
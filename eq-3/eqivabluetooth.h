@@ -32,6 +32,7 @@
 #define EQIVABLUETOOTH_H
 
 #include <QObject>
+#include <QElapsedTimer>
 
 #include "hardware/bluetoothlowenergy/bluetoothlowenergymanager.h"
 
@@ -94,7 +95,7 @@ private slots:
     void sendDate();
 
     // Name parameter used for debugging purposes
-    int enqueue(const QString &name, const QByteArray &data);
+    int enqueue(const QString &name, const QByteArray &data, bool userCommand = true);
     void processCommandQueue();
 
 private:
@@ -117,10 +118,15 @@ private:
     QTimer m_reconnectTimer;
     int m_reconnectAttempt = 0;
 
+    // Commands of the same type replace each other while queued, only the latest value gets sent.
+    // User commands are sent before periodic ones (like setting the date).
     struct Command {
         QString name; // For debug prints
         QByteArray data;
         qint32 id = -1;
+        bool userCommand = true;
+        QList<qint32> replacedIds; // Finished along with this command
+        QElapsedTimer queueTime;
     };
     QList<Command> m_commandQueue;
     Command m_currentCommand;
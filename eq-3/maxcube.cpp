@@ -31,6 +31,11 @@
 #include "maxcube.h"
 #include "extern-plugininfo.h"
 
+static inline quint8 byteAt(const QByteArray &data, int index)
+{
+    return static_cast<quint8>(data.at(index));
+}
+
 MaxCube::MaxCube(QObject *parent, QString serialNumber, QHostAddress hostAdress, quint16 port):
     QTcpSocket(parent), m_serialNumber(serialNumber), m_hostAddress(hostAdress), m_port(port)
 {
@@ -159,6 +164,10 @@ bool MaxCube::isInitialized()
 void MaxCube::decodeHelloMessage(QByteArray data)
 {
     QList<QByteArray> list = data.split(',');
+    if(list.count() < 11){
+        qCWarning(dcEQ3) << "Invalid HELLO message:" << data;
+        return;
+    }
     m_cubeDateTime = calculateDateTime(list.at(7),list.at(8));
 
     m_rfAddress = list.at(1);
@@ -178,26 +187,55 @@ void MaxCube::decodeHelloMessage(QByteArray data)
 
 void MaxCube::decodeMetadataMessage(QByteArray data)
 {
-    QList<QByteArray> list = data.left(data.length()-2).split(',');
-    QByteArray dataDecoded = QByteArray::fromBase64(list.at(2));
+    // M:<index>,<count>,<base64 data>, large metadata gets split into several lines
+    int firstComma = data.indexOf(',');
+    int secondComma = data.indexOf(',', firstComma + 1);
+    if(firstComma < 0 || secondComma < 0){
+        qCWarning(dcEQ3) << "Invalid METADATA message:" << data;
+        return;
+    }
+    int index = data.left(firstComma).toInt(0,16);
+    int count = data.mid(firstComma + 1, secondComma - firstComma - 1).toInt(0,16);
+    if(index == 0){
+        m_metadataBuffer.clear();
+    }
+    m_metadataBuffer.append(data.mid(secondComma + 1));
+    if(index + 1 < count){
+        return;
+    }
+
+    QByteArray dataDecoded = QByteArray::fromBase64(m_metadataBuffer);
+    m_metadataBuffer.clear();
+
     qCDebug(dcEQ3) << "====================================================";
     qCDebug(dcEQ3) << "               METADATA message:";
     qCDebug(dcEQ3) << "====================================================";
 
     // parse room list
-    int roomCount = dataDecoded.toHex().mid(4,2).toInt(0,16);
-
-    QByteArray roomRawData = dataDecoded.toHex();
-    roomRawData = roomRawData.right(roomRawData.length()-6);
+    int position = 2;
+    if(dataDecoded.length() < position + 1){
+        qCWarning(dcEQ3) << "METADATA message too short";
+        return;
+    }
+    int roomCount = byteAt(dataDecoded, position++);
 
     for(int i = 0; i < roomCount; i++){
+        if(dataDecoded.length() < position + 2){
+            qCWarning(dcEQ3) << "METADATA message truncated in room list";
+            return;
+        }
+        int roomId = byteAt(dataDecoded, position);
+        int roomNameLength = byteAt(dataDecoded, position + 1);
+        if(dataDecoded.length() < position + 5 + roomNameLength){
+            qCWarning(dcEQ3) << "METADATA message truncated in room list";
+            return;
+        }
         Room *room = new Room(this);
-        room->setRoomId(roomRawData.left(2).toInt(0,16));
-        int roomNameLength = roomRawData.mid(2,2).toInt(0,16);
-        room->setRoomName(QByteArray::fromHex(roomRawData.mid(4,roomNameLength*2)));
-        room->setGroupRfAddress(roomRawData.mid(roomNameLength*2 + 4, 6));
+        room->setRoomId(roomId);
+        room->setRoomName(dataDecoded.mid(position + 2, roomNameLength));
+        room->setGroupRfAddress(dataDecoded.mid(position + 2 + roomNameLength, 3).toHex());
         m_roomList.append(room);
-        roomRawData = roomRawData.right(roomRawData.length() - ((roomNameLength*2) + 10));
+        position += roomNameLength + 5;
     }
     qCDebug(dcEQ3) << "-------------------------|-------------------------";
     qCDebug(dcEQ3) << "found " << m_roomList.count() << "rooms";
@@ -211,25 +249,42 @@ void MaxCube::decodeMetadataMessage(QByteArray data)
     }
 
     // parse thing list
-    int deviceCount = roomRawData.left(2).toInt(0,16);
-    QByteArray deviceRawData = roomRawData.right(roomRawData.length() - 2);
+    if(dataDecoded.length() < position + 1){
+        qCWarning(dcEQ3) << "METADATA message truncated before device list";
+        return;
+    }
+    int deviceCount = byteAt(dataDecoded, position++);
 
     qCDebug(dcEQ3) << "-------------------------|-------------------------";
     qCDebug(dcEQ3) << "found " << deviceCount << "devices";
     qCDebug(dcEQ3) << "-------------------------|-------------------------";
 
     for(int i = 0; i < deviceCount; i++){
-        int deviceType = deviceRawData.left(2).toInt(0,16);
+        // type (1), RF address (3), serial number (10), name length (1), name, room id (1)
+        if(dataDecoded.length() < position + 15){
+            qCWarning(dcEQ3) << "METADATA message truncated in device list";
+            break;
+        }
+        int deviceType = byteAt(dataDecoded, position);
+        int deviceNameLength = byteAt(dataDecoded, position + 14);
+        if(dataDecoded.length() < position + 16 + deviceNameLength){
+            qCWarning(dcEQ3) << "METADATA message truncated in device list";
+            break;
+        }
+        QByteArray rfAddress = dataDecoded.mid(position + 1, 3).toHex();
+        QByteArray serialNumber = dataDecoded.mid(position + 4, 10);
+        QByteArray deviceName = dataDecoded.mid(position + 15, deviceNameLength);
+        int roomId = byteAt(dataDecoded, position + 15 + deviceNameLength);
+        position += 16 + deviceNameLength;
+
         switch (deviceType) {
         case MaxDevice::DeviceRadiatorThermostat:{
             RadiatorThermostat* thing = new RadiatorThermostat(this);
             thing->setDeviceType(deviceType);
-            thing->setRfAddress(deviceRawData.mid(2,6));
-            thing->setSerialNumber(QByteArray::fromHex(deviceRawData.mid(8,20)));
-            int deviceNameLenght = deviceRawData.mid(28,2).toInt(0,16);
-            thing->setDeviceName(QByteArray::fromHex(deviceRawData.mid(30,deviceNameLenght*2)));
-            thing->setRoomId(deviceRawData.mid(30 + deviceNameLenght*2,2).toInt(0,16));
-            deviceRawData = deviceRawData.right(deviceRawData.length() - (32 + deviceNameLenght*2));
+            thing->setRfAddress(rfAddress);
+            thing->setSerialNumber(serialNumber);
+            thing->setDeviceName(deviceName);
+            thing->setRoomId(roomId);
 
             // set room data for each thing
             foreach (Room * room, m_roomList) {
@@ -251,12 +306,10 @@ void MaxCube::decodeMetadataMessage(QByteArray data)
         case MaxDevice::DeviceWallThermostat:{
             WallThermostat* thing = new WallThermostat(this);
             thing->setDeviceType(deviceType);
-            thing->setRfAddress(deviceRawData.mid(2,6));
-            thing->setSerialNumber(QByteArray::fromHex(deviceRawData.mid(8,20)));
-            int deviceNameLenght = deviceRawData.mid(28,2).toInt(0,16);
-            thing->setDeviceName(QByteArray::fromHex(deviceRawData.mid(30,deviceNameLenght*2)));
-            thing->setRoomId(deviceRawData.mid(30 + deviceNameLenght*2,2).toInt(0,16));
-            deviceRawData = deviceRawData.right(deviceRawData.length() - (32 + deviceNameLenght*2));
+            thing->setRfAddress(rfAddress);
+            thing->setSerialNumber(serialNumber);
+            thing->setDeviceName(deviceName);
+            thing->setRoomId(roomId);
 
             // set room data for each thing
             foreach (Room * room, m_roomList) {
@@ -285,20 +338,26 @@ void MaxCube::decodeMetadataMessage(QByteArray data)
 
 void MaxCube::decodeConfigMessage(QByteArray data)
 {
-    QList<QByteArray> list = data.split(',');
-    if(list.count() < 2){
+    int comma = data.indexOf(',');
+    if(comma < 0){
         return;
     }
-    QByteArray rfAddress = list.at(0);
-    QByteArray dataRaw = QByteArray::fromBase64(list.at(1)).toHex();
-    int lengthData = dataRaw.left(2).toInt(0,16);
-    if(rfAddress != dataRaw.mid(2,6)){
+    QByteArray rfAddress = data.left(comma);
+    QByteArray dataRaw = QByteArray::fromBase64(data.mid(comma + 1));
+
+    // length (1), RF address (3), type (1), room id (1), firmware (1), test result (1), serial number (10)
+    if(dataRaw.length() < 18){
+        qCWarning(dcEQ3) << "CONFIG message too short for" << rfAddress;
+        return;
+    }
+    int lengthData = byteAt(dataRaw, 0);
+    if(rfAddress != dataRaw.mid(1,3).toHex()){
         qCWarning(dcEQ3) << "RF addresses not equal!";
     }
-    int deviceType = dataRaw.mid(8,2).toInt(0,16);
-    //QByteArray unknown = dataRaw.mid(12,6);
+    int deviceType = byteAt(dataRaw, 4);
+    int firmware = byteAt(dataRaw, 6);
 
-    QByteArray serialNumber = QByteArray::fromHex(dataRaw.mid(16,20));
+    QByteArray serialNumber = dataRaw.mid(8,10);
     qCDebug(dcEQ3) << "====================================================";
     qCDebug(dcEQ3) << "               CONFIG message:";
     qCDebug(dcEQ3) << "====================================================";
@@ -310,41 +369,46 @@ void MaxCube::decodeConfigMessage(QByteArray data)
 
     switch (deviceType) {
     case MaxDevice::DeviceCube:{
-
-        m_portalEnabeld = (bool)dataRaw.mid(36,2).toInt(0,16);
+        if(dataRaw.length() < 230){
+            qCWarning(dcEQ3) << "CONFIG message of the cube too short";
+            return;
+        }
+        m_portalEnabeld = (bool)byteAt(dataRaw, 18);
 
         qCDebug(dcEQ3) << "          portal enabled | " << m_portalEnabeld;
-        qCDebug(dcEQ3) << "              portal URL | " << QString(QByteArray::fromHex(dataRaw.mid(170,68)));
-        qCDebug(dcEQ3) << "               time zone | " << QString(QByteArray::fromHex(dataRaw.mid(428,6)));
-        qCDebug(dcEQ3) << "      summer/winter time | " << QString(QByteArray::fromHex(dataRaw.mid(452,8)));
+        qCDebug(dcEQ3) << "              portal URL | " << QString(dataRaw.mid(85,34));
+        qCDebug(dcEQ3) << "               time zone | " << QString(dataRaw.mid(214,3));
+        qCDebug(dcEQ3) << "      summer/winter time | " << QString(dataRaw.mid(226,4));
         emit cubeConfigReady();
         break;
     }
     case MaxDevice::DeviceRadiatorThermostat:{
+        if(dataRaw.length() < 29){
+            qCWarning(dcEQ3) << "CONFIG message of radiator thermostat too short" << rfAddress;
+            return;
+        }
         foreach (RadiatorThermostat* thing, m_radiatorThermostatList) {
             if(thing->rfAddress() == rfAddress){
 
-                //int roomId = dataRaw.mid(10,2).toInt(0,16);
-                int firmware = dataRaw.mid(12,2).toInt(0,16);
-                thing->setComfortTemp((double)dataRaw.mid(36,2).toInt(0,16) / 2.0);
-                thing->setEcoTemp((double)dataRaw.mid(38,2).toInt(0,16) / 2.0);
-                thing->setMaxSetPointTemp((double)dataRaw.mid(40,2).toInt(0,16) / 2.0);
-                thing->setMinSetPointTemp((double)dataRaw.mid(42,2).toInt(0,16) / 2.0);
-                thing->setOffsetTemp((double)(dataRaw.mid(44,2).toInt(0,16) / 2.0 ) - 3.5);
-                thing->setWindowOpenTemp((double)dataRaw.mid(46,2).toInt(0,16)/2.0);
-                thing->setWindowOpenDuration(dataRaw.mid(48,2).toInt(0,16));
-                // boost code
-                QByteArray boostDurationCode = fillBin(QByteArray::number(dataRaw.mid(50,2).toInt(0,16),2),8);
-                thing->setBoostDuration(boostDurationCode.left(3).toInt(0,2) * 5);
-                thing->setBoostValveValue(boostDurationCode.right(5).toInt(0,2) * 5);
-
-                // day of week an time
-                QByteArray dowTime = fillBin(QByteArray::number(dataRaw.mid(52,2).toInt(0,16),2),8);
-                thing->setDiscalcingWeekDay(weekDayString(dowTime.left(3).toInt(0,2)));
-                thing->setDiscalcingTime(QTime(dowTime.right(5).toInt(0,2),0));
-
-                thing->setValveMaximumSettings((double)dataRaw.mid(54,2).toInt(0,16)*(double)100.0/255.0);
-                thing->setValveOffset((double)dataRaw.mid(56,2).toInt(0,16)*100.0/255.0);
+                thing->setComfortTemp(byteAt(dataRaw, 18) / 2.0);
+                thing->setEcoTemp(byteAt(dataRaw, 19) / 2.0);
+                thing->setMaxSetPointTemp(byteAt(dataRaw, 20) / 2.0);
+                thing->setMinSetPointTemp(byteAt(dataRaw, 21) / 2.0);
+                thing->setOffsetTemp((byteAt(dataRaw, 22) / 2.0) - 3.5);
+                thing->setWindowOpenTemp(byteAt(dataRaw, 23) / 2.0);
+                thing->setWindowOpenDuration(byteAt(dataRaw, 24));
+                // boost code: duration (3 bit), valve value (5 bit)
+                quint8 boostDurationCode = byteAt(dataRaw, 25);
+                thing->setBoostDuration((boostDurationCode >> 5) * 5);
+                thing->setBoostValveValue((boostDurationCode & 0x1f) * 5);
+
+                // day of week (3 bit) and hour (5 bit)
+                quint8 dowTime = byteAt(dataRaw, 26);
+                thing->setDiscalcingWeekDay(weekDayString(dowTime >> 5));
+                thing->setDiscalcingTime(QTime(dowTime & 0x1f, 0));
+
+                thing->setValveMaximumSettings(byteAt(dataRaw, 27) * 100.0 / 255.0);
+                thing->setValveOffset(byteAt(dataRaw, 28) * 100.0 / 255.0);
 
                 qCDebug(dcEQ3) << "                 Room ID | " << thing->roomId();
                 qCDebug(dcEQ3) << "                firmware | " << firmware;
@@ -361,7 +425,7 @@ void MaxCube::decodeConfigMessage(QByteArray data)
                 qCDebug(dcEQ3) << "    disclaiming run time | " << thing->discalcingTime().toString("HH:mm");
                 qCDebug(dcEQ3) << "  Valve Maximum Settings | " << thing->valveMaximumSettings() << "%";
                 qCDebug(dcEQ3) << "            Valve Offset | " << thing->valveOffset() << "%";
-                parseWeeklyProgram(dataRaw.right(dataRaw.length() - 58));
+                parseWeeklyProgram(dataRaw.mid(29));
                 emit radiatorThermostatFound();
             }
         }
@@ -370,14 +434,16 @@ void MaxCube::decodeConfigMessage(QByteArray data)
     case MaxDevice::DeviceRadiatorThermostatPlus:
         break;
     case MaxDevice::DeviceWallThermostat:{
+        if(dataRaw.length() < 22){
+            qCWarning(dcEQ3) << "CONFIG message of wall thermostat too short" << rfAddress;
+            return;
+        }
         foreach (WallThermostat* thing, m_wallThermostatList) {
             if(thing->rfAddress() == rfAddress){
-                //int roomId = dataRaw.mid(10,2).toInt(0,16);
-                int firmware = dataRaw.mid(12,2).toInt(0,16);
-                thing->setComfortTemp((double)dataRaw.mid(36,2).toInt(0,16) / 2.0);
-                thing->setEcoTemp((double)dataRaw.mid(38,2).toInt(0,16)/2.0);
-                thing->setMaxSetPointTemp((double)dataRaw.mid(40,2).toInt(0,16)/2.0);
-                thing->setMinSetPointTemp((double)dataRaw.mid(42,2).toInt(0,16)/2.0);
+                thing->setComfortTemp(byteAt(dataRaw, 18) / 2.0);
+                thing->setEcoTemp(byteAt(dataRaw, 19) / 2.0);
+                thing->setMaxSetPointTemp(byteAt(dataRaw, 20) / 2.0);
+                thing->setMinSetPointTemp(byteAt(dataRaw, 21) / 2.0);
 
                 qCDebug(dcEQ3) << "                 Room ID | " << thing->roomId();
                 qCDebug(dcEQ3) << "                firmware | " << firmware;
@@ -386,7 +452,7 @@ void MaxCube::decodeConfigMessage(QByteArray data)
                 qCDebug(dcEQ3) << "    Max. Set Point Temp. | " << thing->maxSetPointTemp();
                 qCDebug(dcEQ3) << "    Min. Set Point Temp. | " << thing->minSetPointTemp();
 
-                parseWeeklyProgram(dataRaw.right(dataRaw.length() - 44));
+                parseWeeklyProgram(dataRaw.mid(22));
                 emit wallThermostatFound();
             }
         }
@@ -408,45 +474,62 @@ void MaxCube::decodeDevicelistMessage(QByteArray data)
     qCDebug(dcEQ3) << "               LIVE message:";
     qCDebug(dcEQ3) << "====================================================";
 
-    QByteArray rawDataAll = QByteArray::fromBase64(data).toHex();
-    QList<QByteArray> deviceMessageList = splitMessage(rawDataAll);
+    QByteArray rawDataAll = QByteArray::fromBase64(data);
+
+    // The message is a sequence of device records, each prefixed with its length
+    int position = 0;
+    while(position < rawDataAll.length()){
+        int length = byteAt(rawDataAll, position);
+        if(position + 1 + length > rawDataAll.length()){
+            qCWarning(dcEQ3) << "LIVE message truncated";
+            break;
+        }
+        QByteArray rawData = QByteArray::fromRawData(rawDataAll.constData() + position + 1, length);
+        position += length + 1;
 
-    foreach (QByteArray rawData, deviceMessageList) {
+        // RF address (3), unknown (1), init code (1), status (1), valve position (1), temperature (1)
+        if(rawData.length() < 6){
+            continue;
+        }
 
-        QByteArray rfAddress = rawData.mid(0,6);
+        QByteArray rfAddress = rawData.left(3).toHex();
         int deviceType = deviceTypeFromRFAddress(rfAddress);
 
         switch (deviceType) {
         case MaxDevice::DeviceWallThermostat:{
+            if(rawData.length() < 12){
+                qCWarning(dcEQ3) << "LIVE record of wall thermostat too short" << rfAddress;
+                break;
+            }
             foreach (WallThermostat *thing, m_wallThermostatList) {
                 if(thing->rfAddress() == rfAddress){
 
                     // init/valid code
-                    QByteArray initCode = fillBin(QByteArray::number(rawData.mid(8,2).toInt(0,16),2),8);
-                    thing->setInformationValid((bool)initCode.mid(3,1).toInt());
-                    thing->setErrorOccurred((bool)initCode.mid(4,1).toInt());
-                    thing->setIsAnswereToCommand((bool)initCode.mid(5,1).toInt());
-                    thing->setInitialized((bool)initCode.mid(6,1).toInt());
+                    quint8 initCode = byteAt(rawData, 4);
+                    thing->setInformationValid(initCode & 0x10);
+                    thing->setErrorOccurred(initCode & 0x08);
+                    thing->setIsAnswereToCommand(initCode & 0x04);
+                    thing->setInitialized(initCode & 0x02);
 
                     // status code
-                    QByteArray statusCode = fillBin(QByteArray::number(rawData.mid(10,2).toInt(0,16),2),8);
-                    thing->setBatteryLow((bool)statusCode.mid(0,1).toInt());
-                    thing->setLinkStatusOK(!(bool)statusCode.mid(1,1).toInt());
-                    thing->setPanelLocked((bool)statusCode.mid(2,1).toInt());
-                    thing->setGatewayKnown((bool)statusCode.mid(3,1).toInt());
-                    thing->setDtsActive((bool)statusCode.mid(4,1).toInt());
-                    thing->setDeviceMode(statusCode.right(2).toInt(0,2));
+                    quint8 statusCode = byteAt(rawData, 5);
+                    thing->setBatteryLow(statusCode & 0x80);
+                    thing->setLinkStatusOK(!(statusCode & 0x40));
+                    thing->setPanelLocked(statusCode & 0x20);
+                    thing->setGatewayKnown(statusCode & 0x10);
+                    thing->setDtsActive(statusCode & 0x08);
+                    thing->setDeviceMode(statusCode & 0x03);
 
                     // calculate current temperature and setpoint temperature
-                    QByteArray tempCode = fillBin(QByteArray::number(rawData.mid(14,2).toInt(0,16),2),8);
-                    thing->setSetpointTemperatre((double)tempCode.right(6).toInt(0,2) / 2.0);
-                    if(tempCode.left(2) == "10"){
-                        thing->setCurrentTemperatre(((double)rawData.right(2).toInt(0,16) / 10.0) + 25.6);
+                    quint8 tempCode = byteAt(rawData, 7);
+                    thing->setSetpointTemperatre((tempCode & 0x3f) / 2.0);
+                    if((tempCode & 0xc0) == 0x80){
+                        thing->setCurrentTemperatre((byteAt(rawData, rawData.length() - 1) / 10.0) + 25.6);
                     }else{
-                        thing->setCurrentTemperatre((double)rawData.right(2).toInt(0,16) / 10.0);
+                        thing->setCurrentTemperatre(byteAt(rawData, rawData.length() - 1) / 10.0);
                     }
 
-                    qCDebug(dcEQ3) << "                raw data | " << rawData;
+                    qCDebug(dcEQ3) << "                raw data | " << rawData.toHex();
                     qCDebug(dcEQ3) << "             thing type | " << thing->deviceTypeString();
                     qCDebug(dcEQ3) << "             thing name | " << thing->deviceName();
                     qCDebug(dcEQ3) << "        RF address (hex) | " << thing->rfAddress();
@@ -471,25 +554,29 @@ void MaxCube::decodeDevicelistMessage(QByteArray data)
             break;
         }
         case MaxDevice::DeviceRadiatorThermostat:{
+            if(rawData.length() < 8){
+                qCWarning(dcEQ3) << "LIVE record of radiator thermostat too short" << rfAddress;
+                break;
+            }
             foreach (RadiatorThermostat* thing, m_radiatorThermostatList) {
                 if(thing->rfAddress() == rfAddress){
 
-                    QByteArray initCode = fillBin(QByteArray::number(rawData.mid(8,2).toInt(0,16),2),8);
-                    thing->setInformationValid((bool)initCode.mid(3,1).toInt());
-                    thing->setErrorOccurred((bool)initCode.mid(4,1).toInt());
-                    thing->setIsAnswereToCommand((bool)initCode.mid(5,1).toInt());
-                    thing->setInitialized((bool)initCode.mid(6,1).toInt());
+                    quint8 initCode = byteAt(rawData, 4);
+                    thing->setInformationValid(initCode & 0x10);
+                    thing->setErrorOccurred(initCode & 0x08);
+                    thing->setIsAnswereToCommand(initCode & 0x04);
+                    thing->setInitialized(initCode & 0x02);
 
-                    QByteArray statusCode = fillBin(QByteArray::number(rawData.mid(10,2).toInt(0,16),2),8);
-                    thing->setBatteryLow((bool)statusCode.mid(0,1).toInt());
-                    thing->setLinkStatusOK(!(bool)statusCode.mid(1,1).toInt());
-                    thing->setPanelLocked((bool)statusCode.mid(2,1).toInt());
-                    thing->setGatewayKnown((bool)statusCode.mid(3,1).toInt());
-                    thing->setDtsActive((bool)statusCode.mid(4,1).toInt());
-                    thing->setDeviceMode(statusCode.right(2).toInt(0,2));
+                    quint8 statusCode = byteAt(rawData, 5);
+                    thing->setBatteryLow(statusCode & 0x80);
+                    thing->setLinkStatusOK(!(statusCode & 0x40));
+                    thing->setPanelLocked(statusCode & 0x20);
+                    thing->setGatewayKnown(statusCode & 0x10);
+                    thing->setDtsActive(statusCode & 0x08);
+                    thing->setDeviceMode(statusCode & 0x03);
 
-                    thing->setValvePosition((double)rawData.mid(12,2).toInt(0,16));
-                    thing->setSetpointTemperatre((double)rawData.mid(14,2).toInt(0,16)/ 2.0);
+                    thing->setValvePosition(byteAt(rawData, 6));
+                    thing->setSetpointTemperatre(byteAt(rawData, 7) / 2.0);
 
                     qCDebug(dcEQ3) << "             thing type | " << thing->deviceTypeString();
                     qCDebug(dcEQ3) << "             thing name | " << thing->deviceName();
@@ -514,13 +601,11 @@ void MaxCube::decodeDevicelistMessage(QByteArray data)
             break;
         }
         case MaxDevice::DeviceWindowContact:{
-            //QByteArray windowOpenRawData = fillBin(QByteArray::number(rawData.mid(10,2).toInt(0,16),2),8);
-            //bool windowOpen = (bool)windowOpenRawData.mid(5,1).toInt();
+            //bool windowOpen = byteAt(rawData, 5) & 0x04;
 
-            //            qCDebug(dcEQ3) << "                raw data | " << rawData;
+            //            qCDebug(dcEQ3) << "                raw data | " << rawData.toHex();
             //            qCDebug(dcEQ3) << "        thing type name | " << "Window Contact";
             //            qCDebug(dcEQ3) << "        RF address (hex) | " << rfAddress;
-            //            qCDebug(dcEQ3) << "        window open code | " << windowOpenRawData;
             //            qCDebug(dcEQ3) << "             window open | " << windowOpen;
             //            qCDebug(dcEQ3) << "-------------------------|-------------------------";
             break;
@@ -535,7 +620,7 @@ void MaxCube::decodeCommandMessage(QByteArray data)
 {
     QList<QByteArray> list = data.split(',');
 
-    if(list.isEmpty()){
+    if(list.count() < 3){
         return;
     }
     bool succeeded = !(bool)list.at(2).toInt(0,10);
@@ -548,21 +633,22 @@ void MaxCube::decodeCommandMessage(QByteArray data)
 
 void MaxCube::parseWeeklyProgram(QByteArray data)
 {
-    for(int i=0; i < 7; i++){
-        QByteArray dayData = data.left(52);
-        //qCDebug(dcEQ3) << weekDayString(i);
-        for(int i = 0; i < 52; i+=4){
-            QByteArray element = fillBin(QByteArray::number(dayData.mid(i,4).toInt(0,16),2),16);
-            //int minutes = element.right(9).toInt(0,2) * 5;
+    // 7 days, 13 entries of 16 bit each: temperature (7 bit), end time in 5 minute steps (9 bit)
+    for(int day = 0; day < 7; day++){
+        //qCDebug(dcEQ3) << weekDayString(day);
+        for(int i = 0; i < 13; i++){
+            int offset = day * 26 + i * 2;
+            if(offset + 1 >= data.length()){
+                return;
+            }
+            quint16 element = (byteAt(data, offset) << 8) | byteAt(data, offset + 1);
+            Q_UNUSED(element)
+            //int minutes = (element & 0x1ff) * 5;
             //int hours = (minutes / 60) % 24;
             //minutes = minutes % 60;
             //QTime time = QTime(hours,minutes);
-            //qCDebug(dcEQ3) << (double)element.left(7).toInt(0,2) / 2 << "\t" << "deg. until" << "\t" << time.toString("HH:mm");
+            //qCDebug(dcEQ3) << (double)(element >> 9) / 2 << "\t" << "deg. until" << "\t" << time.toString("HH:mm");
         }
-        data = data.right(data.length() - 52);
-    }
-    if(!data.isEmpty()){
-        //qCDebug(dcEQ3) << "                       ? | " << data;
     }
 }
 
@@ -664,18 +750,6 @@ QByteArray MaxCube::fillBin(QByteArray data, int dataLength)
     return data;
 }
 
-QList<QByteArray> MaxCube::splitMessage(QByteArray data)
-{
-    QList<QByteArray> messageList;
-    while(!data.isEmpty()){
-        int length = data.left(2).toInt(0,16)*2;
-        messageList.append(data.mid(2,length));
-        data = data.right(data.length() - (length+2));
-    }
-    //qCDebug(dcEQ3) << messageList;
-    return messageList;
-}
-
 int MaxCube::deviceTypeFromRFAddress(QByteArray rfAddress)
 {
     foreach (WallThermostat* thing, m_wallThermostatList) {
@@ -707,6 +781,7 @@ void MaxCube::connectionStateChanged(const QAbstractSocket::SocketState &socketS
         break;
     case QAbstractSocket::UnconnectedState:
         m_cubeInitialized = false;
+        m_metadataBuffer.clear();
         qCDebug(dcEQ3) << "disconnected from cube " << m_serialNumber << m_hostAddress.toString();
         emit cubeConnectionStatusChanged(false);
         break;
@@ -723,59 +798,58 @@ void MaxCube::error(QAbstractSocket::SocketError error)
 
 void MaxCube::readData()
 {
-    QByteArray message;
+    // The socket buffers incomplete lines, every complete line is one message
     while(canReadLine()){
         QByteArray dataLine = readLine();
-        message.append(dataLine);
+        while(dataLine.endsWith('\n') || dataLine.endsWith('\r')){
+            dataLine.chop(1);
+        }
+        if(!dataLine.isEmpty()){
+            emit cubeDataAvailable(dataLine);
+        }
     }
-    emit cubeDataAvailable(message);
 }
 
 void MaxCube::processCubeData(const QByteArray &data)
 {
     //qCDebug(dcEQ3) << "data" << data;
-    if(data.startsWith("H")){
-        decodeHelloMessage(data.right(data.length() -2 ));
+    if(data.length() < 2 || data.at(1) != ':'){
+        qCWarning(dcEQ3) << "  -> unknown message!!!!!!! from cube:" << data;
         return;
     }
+    QByteArray payload = data.mid(2);
+
+    switch (data.at(0)) {
+    case 'H':
+        decodeHelloMessage(payload);
+        return;
     // METADATA message
-    if(data.startsWith("M")){
-        decodeMetadataMessage(data.right(data.length() -2 ));
+    case 'M':
+        decodeMetadataMessage(payload);
         return;
-    }
     // CONFIG message
-    if(data.startsWith("C")){
-        QList<QByteArray> dataList = data.split('\r');
-        foreach (QByteArray dataElement, dataList) {
-            if(dataElement.startsWith("C")){
-                decodeConfigMessage(dataElement.right(dataElement.length() -2 ));
-            }
-            if(dataElement.startsWith("\nC")){
-                decodeConfigMessage(dataElement.right(dataElement.length() -3 ));
-            }
-        }
+    case 'C':
+        decodeConfigMessage(payload);
         return;
-    }
     // LIVE message
-    if(data.startsWith("L")){
-        decodeDevicelistMessage(data.right(data.length() -2 ));
+    case 'L':
+        decodeDevicelistMessage(payload);
         return;
-    }
     // NEWDEVICEFOUND message
-    if(data.startsWith("N")){
-        decodeNewDeviceFoundMessage(data.right(data.length() -2));
+    case 'N':
+        decodeNewDeviceFoundMessage(payload);
         return;
-    }
     // COMMAND answere message
-    if(data.startsWith("S")){
-        decodeCommandMessage(data.right(data.length() -2));
+    case 'S':
+        decodeCommandMessage(payload);
         return;
-    }
     // ACK message
-    if(data.startsWith("A")){
+    case 'A':
         qCDebug(dcEQ3) << "cube ACK!";
         emit cubeACK();
         return;
+    default:
+        break;
     }
     qCWarning(dcEQ3) << "  -> unknown message!!!!!!! from cube:" << data;
 }
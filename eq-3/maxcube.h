@@ -143,6 +143,9 @@ private:
 
     bool m_cubeInitialized;
 
+    // Base64 data of a metadata message split over several lines
+    QByteArray m_metadataBuffer;
+
     void decodeHelloMessage(QByteArray data);
     void decodeMetadataMessage(QByteArray data);
     void decodeConfigMessage(QByteArray data);
@@ -156,7 +159,6 @@ private:
     QString weekDayString(int weekDay);
 
     QByteArray fillBin(QByteArray data, int dataLength);
-    QList<QByteArray> splitMessage(QByteArray data);
     int deviceTypeFromRFAddress(QByteArray rfAddress);
 
     struct Command {
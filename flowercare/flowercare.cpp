@@ -56,7 +56,7 @@ BluetoothLowEnergyDevice *FlowerCare::btDevice() const
 void FlowerCare::onConnectedChanged(bool connected)
 {
     qCDebug(dcFlowerCare()) << "Connection changed:" << connected;
-    if (!connected) {
+    if (!connected && m_sensorService) {
         m_sensorService->deleteLater();
         m_sensorService = nullptr;
     }
@@ -1,13 +1,15 @@
 include(../plugins.pri)
 
-QT += bluetooth
+QT += bluetooth dbus
 
 TARGET = $$qtLibraryTarget(nymea_integrationpluginflowercare)
 
 SOURCES += \
     integrationpluginflowercare.cpp \
-    flowercare.cpp
+    flowercare.cpp \
+    mibeaconlistener.cpp
 
 HEADERS += \
     integrationpluginflowercare.h \
-    flowercare.h
+    flowercare.h \
+    mibeaconlistener.h
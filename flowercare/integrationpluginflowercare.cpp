@@ -42,6 +42,12 @@
 #include "integrationpluginflowercare.h"
 #include "flowercare.h"
 
+// In passive mode the sensor values come from advertisements, the battery level still needs a connection
+static const int batteryRefreshMinutes = 360;
+
+// In passive mode a sensor without any advertisement or connection for this long is considered unreachable
+static const int passiveTimeoutMinutes = 30;
+
 IntegrationPluginFlowercare::IntegrationPluginFlowercare()
 {
 
@@ -56,6 +62,13 @@ IntegrationPluginFlowercare::~IntegrationPluginFlowercare()
 
 void IntegrationPluginFlowercare::init()
 {
+    m_beaconListener = new MiBeaconListener(this);
+    connect(m_beaconListener, &MiBeaconListener::measurementReceived, this, &IntegrationPluginFlowercare::onMeasurementReceived);
+
+    m_refreshTimeoutTimer = new QTimer(this);
+    m_refreshTimeoutTimer->setSingleShot(true);
+    m_refreshTimeoutTimer->setInterval(30000);
+    connect(m_refreshTimeoutTimer, &QTimer::timeout, this, &IntegrationPluginFlowercare::onRefreshTimeout);
 }
 
 void IntegrationPluginFlowercare::discoverThings(ThingDiscoveryInfo *info)
@@ -113,6 +126,7 @@ void IntegrationPluginFlowercare::setupThing(ThingSetupInfo *info)
     BluetoothLowEnergyDevice *bluetoothDevice = hardwareManager()->bluetoothLowEnergyManager()->registerDevice(deviceInfo, QLowEnergyController::PublicAddress);
     FlowerCare *flowerCare = new FlowerCare(bluetoothDevice, this);
     connect(flowerCare, &FlowerCare::finished, this, &IntegrationPluginFlowercare::onSensorDataReceived);
+    connect(flowerCare, &FlowerCare::failed, this, &IntegrationPluginFlowercare::onSensorRefreshFailed);
     m_list.insert(thing, flowerCare);
 
     m_refreshMinutes[flowerCare] = 0;
@@ -125,9 +139,9 @@ void IntegrationPluginFlowercare::setupThing(ThingSetupInfo *info)
     // Update refresh schedule when the refresh rate setting is changed
     connect(thing, &Thing::settingChanged, flowerCare, [this, thing] {
         FlowerCare *flowerCare = m_list.value(thing);
-        int refreshInterval = thing->setting(flowerCareSettingsRefreshRateParamTypeId).toInt();
-        if (m_refreshMinutes[flowerCare] > refreshInterval) {
-            m_refreshMinutes[flowerCare] = refreshInterval;
+        int interval = refreshInterval(thing);
+        if (m_refreshMinutes[flowerCare] > interval) {
+            m_refreshMinutes[flowerCare] = interval;
         }
     });
 
@@ -137,7 +151,7 @@ void IntegrationPluginFlowercare::setupThing(ThingSetupInfo *info)
 void IntegrationPluginFlowercare::postSetupThing(Thing *thing)
 {
     FlowerCare *flowerCare = m_list.value(thing);
-    flowerCare->refreshData();
+    enqueueRefresh(flowerCare);
 }
 
 void IntegrationPluginFlowercare::thingRemoved(Thing *thing)
@@ -147,38 +161,129 @@ void IntegrationPluginFlowercare::thingRemoved(Thing *thing)
         return;
     }
 
+    m_refreshMinutes.remove(flowerCare);
+    m_lastSeen.remove(thing);
+    m_refreshQueue.removeAll(flowerCare);
+    if (m_currentRefresh == flowerCare) {
+        m_refreshTimeoutTimer->stop();
+        m_currentRefresh = nullptr;
+    }
+
     hardwareManager()->bluetoothLowEnergyManager()->unregisterDevice(flowerCare->btDevice());
     flowerCare->deleteLater();
 
+    processRefreshQueue();
+
     if (m_list.isEmpty() && m_reconnectTimer) {
         hardwareManager()->pluginTimerManager()->unregisterTimer(m_reconnectTimer);
         m_reconnectTimer = nullptr;
     }
 }
 
-void IntegrationPluginFlowercare::onPluginTimer()
+bool IntegrationPluginFlowercare::passiveMode(Thing *thing) const
 {
+    return m_beaconListener->isValid() && thing->setting(flowerCareSettingsPassiveModeParamTypeId).toBool();
+}
 
-    foreach (FlowerCare *flowerCare, m_list) {
+int IntegrationPluginFlowercare::refreshInterval(Thing *thing) const
+{
+    if (passiveMode(thing)) {
+        return batteryRefreshMinutes;
+    }
+    return thing->setting(flowerCareSettingsRefreshRateParamTypeId).toInt();
+}
+
+void IntegrationPluginFlowercare::startScan()
+{
+    if (m_scanning || m_currentRefresh)
+        return;
+
+    if (!hardwareManager()->bluetoothLowEnergyManager()->available() || !hardwareManager()->bluetoothLowEnergyManager()->enabled())
+        return;
+
+    // Advertisements are picked up by the MiBeaconListener while the discovery is running
+    qCDebug(dcFlowerCare()) << "Scanning for advertisements";
+    m_scanning = true;
+    BluetoothDiscoveryReply *reply = hardwareManager()->bluetoothLowEnergyManager()->discoverDevices();
+    connect(reply, &BluetoothDiscoveryReply::finished, this, [this, reply](){
+        reply->deleteLater();
+        m_scanning = false;
+        if (reply->error() != BluetoothDiscoveryReply::BluetoothDiscoveryReplyErrorNoError) {
+            qCWarning(dcFlowerCare()) << "Bluetooth discovery error:" << reply->error();
+        }
+        processRefreshQueue();
+    });
+}
+
+void IntegrationPluginFlowercare::enqueueRefresh(FlowerCare *flowerCare)
+{
+    if (m_currentRefresh == flowerCare || m_refreshQueue.contains(flowerCare))
+        return;
+
+    m_refreshQueue.append(flowerCare);
+    processRefreshQueue();
+}
+
+void IntegrationPluginFlowercare::processRefreshQueue()
+{
+    if (m_currentRefresh || m_scanning || m_refreshQueue.isEmpty())
+        return;
+
+    m_currentRefresh = m_refreshQueue.takeFirst();
+    qCDebug(dcFlowerCare()) << "Refreshing" << m_currentRefresh->btDevice()->address();
+    m_refreshTimeoutTimer->start();
+    m_currentRefresh->refreshData();
+}
+
+void IntegrationPluginFlowercare::finishRefresh(FlowerCare *flowerCare)
+{
+    if (m_currentRefresh != flowerCare)
+        return;
+
+    m_refreshTimeoutTimer->stop();
+    m_currentRefresh = nullptr;
+    processRefreshQueue();
+}
+
+void IntegrationPluginFlowercare::onPluginTimer()
+{
+    bool scan = false;
+    foreach (Thing *thing, m_list.keys()) {
+        FlowerCare *flowerCare = m_list.value(thing);
         if (--m_refreshMinutes[flowerCare] <= 0) {
-            qCDebug(dcFlowerCare()) << "Refreshing" << flowerCare->btDevice()->address();
-            flowerCare->refreshData();
+            enqueueRefresh(flowerCare);
         } else {
             qCDebug(dcFlowerCare()) << "Not refreshing" << flowerCare->btDevice()->address() << " Next refresh in" << m_refreshMinutes[flowerCare] << "minutes";
         }
 
-        // If we had 2 or more failed connection attempts, mark it as disconnected
-        if (m_refreshMinutes[flowerCare] < -2) {
+        if (passiveMode(thing)) {
+            scan = true;
+            QDateTime lastSeen = m_lastSeen.value(thing);
+            // A sensor we never heard from is as stale as one that went silent
+            if (!lastSeen.isValid() || lastSeen.secsTo(QDateTime::currentDateTime()) > passiveTimeoutMinutes * 60) {
+                qCDebug(dcFlowerCare()) << "No data received for" << passiveTimeoutMinutes << "minutes. Marking as unreachable";
+                thing->setStateValue(flowerCareConnectedStateTypeId, false);
+            }
+        } else if (m_refreshMinutes[flowerCare] < -2) {
+            // If we had 2 or more failed connection attempts, mark it as disconnected
             qCDebug(dcFlowerCare()) << "Failed to refresh for"<< (m_refreshMinutes[flowerCare] * -1) << "minutes. Marking as unreachable";
-            m_list.key(flowerCare)->setStateValue(flowerCareConnectedStateTypeId, false);
+            thing->setStateValue(flowerCareConnectedStateTypeId, false);
         }
     }
+
+    if (scan) {
+        startScan();
+    }
 }
 
 void IntegrationPluginFlowercare::onSensorDataReceived(quint8 batteryLevel, double degreeCelsius, double lux, double moisture, double fertility)
 {
     FlowerCare *flowerCare = static_cast<FlowerCare*>(sender());
     Thing *thing = m_list.key(flowerCare);
+    finishRefresh(flowerCare);
+    if (!thing)
+        return;
+
     thing->setStateValue(flowerCareConnectedStateTypeId, true);
     thing->setStateValue(flowerCareBatteryLevelStateTypeId, batteryLevel);
     thing->setStateValue(flowerCareBatteryCriticalStateTypeId, batteryLevel <= 10);
@@ -187,5 +292,70 @@ void IntegrationPluginFlowercare::onSensorDataReceived(quint8 batteryLevel, doub
     thing->setStateValue(flowerCareMoistureStateTypeId, moisture);
     thing->setStateValue(flowerCareConductivityStateTypeId, fertility);
 
-    m_refreshMinutes[flowerCare] = thing->setting(flowerCareSettingsRefreshRateParamTypeId).toInt();
+    m_lastSeen[thing] = QDateTime::currentDateTime();
+    m_refreshMinutes[flowerCare] = refreshInterval(thing);
+}
+
+void IntegrationPluginFlowercare::onSensorRefreshFailed()
+{
+    FlowerCare *flowerCare = static_cast<FlowerCare*>(sender());
+    qCWarning(dcFlowerCare()) << "Refreshing" << flowerCare->btDevice()->address() << "failed";
+    abortRefresh(flowerCare);
+}
+
+void IntegrationPluginFlowercare::onRefreshTimeout()
+{
+    if (!m_currentRefresh)
+        return;
+
+    qCWarning(dcFlowerCare()) << "Refreshing" << m_currentRefresh->btDevice()->address() << "timed out";
+    abortRefresh(m_currentRefresh);
+}
+
+void IntegrationPluginFlowercare::abortRefresh(FlowerCare *flowerCare)
+{
+    flowerCare->btDevice()->disconnectDevice();
+    finishRefresh(flowerCare);
+
+    // In passive mode the values come from advertisements, don't retry the GATT refresh every minute
+    Thing *thing = m_list.key(flowerCare);
+    if (thing && passiveMode(thing)) {
+        m_refreshMinutes[flowerCare] = refreshInterval(thing);
+    }
+}
+
+void IntegrationPluginFlowercare::onMeasurementReceived(const QBluetoothAddress &address, MiBeaconListener::Measurement measurement, double value)
+{
+    Thing *thing = nullptr;
+    foreach (Thing *t, m_list.keys()) {
+        if (QBluetoothAddress(t->paramValue(flowerCareThingMacParamTypeId).toString()) == address) {
+            thing = t;
+            break;
+        }
+    }
+    if (!thing)
+        return;
+
+    qCDebug(dcFlowerCare()) << "Advertisement from" << thing->name() << measurement << value;
+    thing->setStateValue(flowerCareConnectedStateTypeId, true);
+    m_lastSeen[thing] = QDateTime::currentDateTime();
+
+    switch (measurement) {
+    case MiBeaconListener::MeasurementTemperature:
+        thing->setStateValue(flowerCareTemperatureStateTypeId, value);
+        break;
+    case MiBeaconListener::MeasurementMoisture:
+        thing->setStateValue(flowerCareMoistureStateTypeId, value);
+        break;
+    case MiBeaconListener::MeasurementLightIntensity:
+        thing->setStateValue(flowerCareLightIntensityStateTypeId, value);
+        break;
+    case MiBeaconListener::MeasurementConductivity:
+        thing->setStateValue(flowerCareConductivityStateTypeId, value);
+        break;
+    case MiBeaconListener::MeasurementBatteryLevel:
+        thing->setStateValue(flowerCareBatteryLevelStateTypeId, value);
+        thing->setStateValue(flowerCareBatteryCriticalStateTypeId, value <= 10);
+        break;
+    }
 }
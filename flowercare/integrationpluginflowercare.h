@@ -34,10 +34,14 @@
 
 #include <QPointer>
 #include <QHash>
+#include <QTimer>
+#include <QDateTime>
 #include "integrations/integrationplugin.h"
 #include "plugintimer.h"
 #include "hardware/bluetoothlowenergy/bluetoothlowenergydevice.h"
 
+#include "mibeaconlistener.h"
+
 class FlowerCare;
 
 class IntegrationPluginFlowercare : public IntegrationPlugin
@@ -60,10 +64,31 @@ private:
     PluginTimer *m_reconnectTimer = nullptr;
     QHash<Thing*, FlowerCare*> m_list;
     QHash<FlowerCare*, int> m_refreshMinutes;
+    QHash<Thing*, QDateTime> m_lastSeen;
+
+    MiBeaconListener *m_beaconListener = nullptr;
+    bool m_scanning = false;
+
+    // Only one sensor gets connected at a time, the adapter can't scan meanwhile
+    QList<FlowerCare*> m_refreshQueue;
+    FlowerCare *m_currentRefresh = nullptr;
+    QTimer *m_refreshTimeoutTimer = nullptr;
+
+    bool passiveMode(Thing *thing) const;
+    int refreshInterval(Thing *thing) const;
+
+    void startScan();
+    void enqueueRefresh(FlowerCare *flowerCare);
+    void processRefreshQueue();
+    void finishRefresh(FlowerCare *flowerCare);
+    void abortRefresh(FlowerCare *flowerCare);
 
 private slots:
     void onPluginTimer();
     void onSensorDataReceived(quint8 batteryLevel, double degreeCelsius, double lux, double moisture, double fertility);
+    void onSensorRefreshFailed();
+    void onRefreshTimeout();
+    void onMeasurementReceived(const QBluetoothAddress &address, MiBeaconListener::Measurement measurement, double value);
 
 };
 
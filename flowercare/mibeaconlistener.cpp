@@ -0,0 +1,171 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "mibeaconlistener.h"
+#include "extern-plugininfo.h"
+
+#include <QDBusConnection>
+#include <QDBusArgument>
+#include <QDBusVariant>
+
+static const QString miBeaconServiceUuid = "0000fe95-0000-1000-8000-00805f9b34fb";
+
+static inline quint8 byteAt(const QByteArray &data, int index)
+{
+    return static_cast<quint8>(data.at(index));
+}
+
+MiBeaconListener::MiBeaconListener(QObject *parent) :
+    QObject(parent)
+{
+    // Note: an empty object path matches all devices
+    m_valid = QDBusConnection::systemBus().connect("org.bluez", QString(), "org.freedesktop.DBus.Properties", "PropertiesChanged", this, SLOT(onPropertiesChanged(QDBusMessage)));
+    if (!m_valid) {
+        qCWarning(dcFlowerCare()) << "Could not listen for Bluetooth advertisements on the system bus:" << QDBusConnection::systemBus().lastError().message();
+    }
+}
+
+bool MiBeaconListener::isValid() const
+{
+    return m_valid;
+}
+
+void MiBeaconListener::onPropertiesChanged(const QDBusMessage &message)
+{
+    if (message.arguments().count() < 2 || message.arguments().at(0).toString() != "org.bluez.Device1")
+        return;
+
+    QVariantMap changedProperties = qdbus_cast<QVariantMap>(message.arguments().at(1));
+    if (!changedProperties.contains("ServiceData"))
+        return;
+
+    QVariantMap serviceData = qdbus_cast<QVariantMap>(changedProperties.value("ServiceData"));
+    if (!serviceData.contains(miBeaconServiceUuid))
+        return;
+
+    QVariant value = serviceData.value(miBeaconServiceUuid);
+    if (value.userType() == qMetaTypeId<QDBusVariant>()) {
+        value = value.value<QDBusVariant>().variant();
+    }
+    QByteArray data = value.userType() == qMetaTypeId<QDBusArgument>() ? qdbus_cast<QByteArray>(value) : value.toByteArray();
+
+    // The object path ends with the address: /org/bluez/hci0/dev_C4_7C_8D_6A_12_34
+    QString devicePath = message.path().section('/', -1);
+    if (!devicePath.startsWith("dev_"))
+        return;
+
+    QBluetoothAddress address(devicePath.mid(4).replace('_', ':'));
+    processServiceData(address, data);
+}
+
+void MiBeaconListener::processServiceData(const QBluetoothAddress &address, const QByteArray &data)
+{
+    // Frame control (2), product id (2), frame counter (1)
+    if (data.length() < 5)
+        return;
+
+    quint16 frameControl = byteAt(data, 0) | (byteAt(data, 1) << 8);
+    quint8 frameCounter = byteAt(data, 4);
+
+    QString key = address.toString();
+    if (m_frameCounters.contains(key) && m_frameCounters.value(key) == frameCounter)
+        return;
+
+    m_frameCounters.insert(key, frameCounter);
+
+    if (frameControl & 0x0008) {
+        qCDebug(dcFlowerCare()) << "Ignoring encrypted advertisement from" << key;
+        return;
+    }
+
+    int position = 5;
+    // Optional MAC address
+    if (frameControl & 0x0010)
+        position += 6;
+
+    // Optional capabilities, with an additional IO capability field
+    if (frameControl & 0x0020) {
+        if (position >= data.length())
+            return;
+
+        quint8 capability = byteAt(data, position);
+        position += (capability & 0x20) ? 3 : 1;
+    }
+
+    // Advertisements without a measurement object are only announcements
+    if (!(frameControl & 0x0040))
+        return;
+
+    // Objects: type (2), length (1), data
+    while (position + 3 <= data.length()) {
+        quint16 objectType = byteAt(data, position) | (byteAt(data, position + 1) << 8);
+        int length = byteAt(data, position + 2);
+        position += 3;
+        if (position + length > data.length()) {
+            qCDebug(dcFlowerCare()) << "Truncated advertisement object from" << key << data.toHex();
+            return;
+        }
+
+        switch (objectType) {
+        case 0x1004:
+            if (length >= 2) {
+                qint16 temperature = static_cast<qint16>(byteAt(data, position) | (byteAt(data, position + 1) << 8));
+                emit measurementReceived(address, MeasurementTemperature, temperature / 10.0);
+            }
+            break;
+        case 0x1007:
+            if (length >= 3) {
+                quint32 lux = byteAt(data, position) | (byteAt(data, position + 1) << 8) | (byteAt(data, position + 2) << 16);
+                emit measurementReceived(address, MeasurementLightIntensity, lux);
+            }
+            break;
+        case 0x1008:
+            if (length >= 1) {
+                emit measurementReceived(address, MeasurementMoisture, byteAt(data, position));
+            }
+            break;
+        case 0x1009:
+            if (length >= 2) {
+                quint16 conductivity = byteAt(data, position) | (byteAt(data, position + 1) << 8);
+                emit measurementReceived(address, MeasurementConductivity, conductivity);
+            }
+            break;
+        case 0x100a:
+            if (length >= 1) {
+                emit measurementReceived(address, MeasurementBatteryLevel, byteAt(data, position));
+            }
+            break;
+        default:
+            qCDebug(dcFlowerCare()) << "Unhandled advertisement object" << QString::number(objectType, 16) << "from" << key;
+            break;
+        }
+        position += length;
+    }
+}
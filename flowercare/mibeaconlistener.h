@@ -0,0 +1,74 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef MIBEACONLISTENER_H
+#define MIBEACONLISTENER_H
+
+#include <QObject>
+#include <QHash>
+#include <QDBusMessage>
+#include <QBluetoothAddress>
+
+// Listens for Xiaomi MiBeacon advertisements (service data of the 0xFE95 service)
+// which BlueZ publishes while a discovery is running. This allows reading the sensor
+// values without connecting to the device.
+class MiBeaconListener : public QObject
+{
+    Q_OBJECT
+public:
+    enum Measurement {
+        MeasurementTemperature,
+        MeasurementMoisture,
+        MeasurementLightIntensity,
+        MeasurementConductivity,
+        MeasurementBatteryLevel
+    };
+    Q_ENUM(Measurement)
+
+    explicit MiBeaconListener(QObject *parent = nullptr);
+
+    bool isValid() const;
+
+signals:
+    void measurementReceived(const QBluetoothAddress &address, Measurement measurement, double value);
+
+private slots:
+    void onPropertiesChanged(const QDBusMessage &message);
+
+private:
+    bool m_valid = false;
+
+    // The same advertisement is repeated several times, identified by the frame counter
+    QHash<QString, quint8> m_frameCounters;
+
+    void processServiceData(const QBluetoothAddress &address, const QByteArray &data);
+};
+
+#endif // MIBEACONLISTENER_H
@@ -58,119 +58,76 @@ bool FroniusSolarConnection::busy() const
 
 FroniusNetworkReply *FroniusSolarConnection::getVersion()
 {
-    QUrl requestUrl;
-    requestUrl.setScheme("http");
-    requestUrl.setHost(m_address.toString());
-    requestUrl.setPath("/solar_api/GetAPIVersion.cgi");
-
-    FroniusNetworkReply *reply = new FroniusNetworkReply(QNetworkRequest(requestUrl), this);
-    m_requestQueue.enqueue(reply);
-    sendNextRequest();
-    return reply;
+    return createRequest("/solar_api/GetAPIVersion.cgi");
 }
 
 FroniusNetworkReply *FroniusSolarConnection::getActiveDevices()
 {
-    QUrl requestUrl;
-    requestUrl.setScheme("http");
-    requestUrl.setHost(m_address.toString());
-    requestUrl.setPath("/solar_api/v1/GetActiveDeviceInfo.cgi");
-
     QUrlQuery query;
     query.addQueryItem("DeviceClass", "System");
-    requestUrl.setQuery(query);
-
-    FroniusNetworkReply *reply = new FroniusNetworkReply(QNetworkRequest(requestUrl), this);
-    m_requestQueue.enqueue(reply);
-
-    // Note: we use this request for detecting if the logger is available or not.
-    connect(reply, &FroniusNetworkReply::finished, this, [=](){
-        if (reply->networkReply()->error() == QNetworkReply::NoError) {
-            // Reply was successfully, we can communicate
-            if (!m_available) {
-                qCDebug(dcFronius()) << "Connection: the connection is now available";
-                m_available = true;
-                emit availableChanged(m_available);
-
-                // Destroy any pending requests
-                qDeleteAll(m_requestQueue);
-                m_requestQueue.clear();
-            }
-        } else {
-            // Ther have been errors, seems like we not available any more
-            if (m_available) {
-                qCDebug(dcFronius()) << "Connection: the connection is not available any more:" << reply->networkReply()->errorString();
-                m_available = false;
-                emit availableChanged(m_available);
-            }
-        }
-    });
-
-    sendNextRequest();
-    return reply;
+    return createRequest("/solar_api/v1/GetActiveDeviceInfo.cgi", query);
 }
 
 FroniusNetworkReply *FroniusSolarConnection::getPowerFlowRealtimeData()
 {
-    QUrl requestUrl;
-    requestUrl.setScheme("http");
-    requestUrl.setHost(m_address.toString());
-    requestUrl.setPath("/solar_api/v1/GetPowerFlowRealtimeData.fcgi");
-
-    FroniusNetworkReply *reply = new FroniusNetworkReply(QNetworkRequest(requestUrl), this);
-    m_requestQueue.enqueue(reply);
-    sendNextRequest();
-    return reply;
+    return createRequest("/solar_api/v1/GetPowerFlowRealtimeData.fcgi");
 }
 
 FroniusNetworkReply *FroniusSolarConnection::getInverterRealtimeData(int inverterId)
 {
-    QUrl requestUrl;
-    requestUrl.setScheme("http");
-    requestUrl.setHost(m_address.toString());
-    requestUrl.setPath("/solar_api/v1/GetInverterRealtimeData.cgi");
-
     QUrlQuery query;
     query.addQueryItem("Scope", "Device");
     query.addQueryItem("DeviceId", QString::number(inverterId));
     query.addQueryItem("DataCollection", "CommonInverterData");
-    requestUrl.setQuery(query);
-
-    FroniusNetworkReply *reply = new FroniusNetworkReply(QNetworkRequest(requestUrl), this);
-    m_requestQueue.enqueue(reply);
-    sendNextRequest();
-    return reply;
+    return createRequest("/solar_api/v1/GetInverterRealtimeData.cgi", query);
 }
 
 FroniusNetworkReply *FroniusSolarConnection::getMeterRealtimeData(int meterId)
 {
-    QUrl requestUrl;
-    requestUrl.setScheme("http");
-    requestUrl.setHost(m_address.toString());
-    requestUrl.setPath("/solar_api/v1/GetMeterRealtimeData.cgi");
+    QUrlQuery query;
+    query.addQueryItem("Scope", "Device");
+    query.addQueryItem("DeviceId", QString::number(meterId));
+    return createRequest("/solar_api/v1/GetMeterRealtimeData.cgi", query);
+}
 
+FroniusNetworkReply *FroniusSolarConnection::getStorageRealtimeData(int meterId)
+{
     QUrlQuery query;
     query.addQueryItem("Scope", "Device");
     query.addQueryItem("DeviceId", QString::number(meterId));
-    requestUrl.setQuery(query);
+    return createRequest("/solar_api/v1/GetStorageRealtimeData.cgi", query);
+}
 
-    FroniusNetworkReply *reply = new FroniusNetworkReply(QNetworkRequest(requestUrl), this);
-    m_requestQueue.enqueue(reply);
-    sendNextRequest();
-    return reply;
+FroniusNetworkReply *FroniusSolarConnection::getInverterRealtimeSystemData()
+{
+    QUrlQuery query;
+    query.addQueryItem("Scope", "System");
+    return createRequest("/solar_api/v1/GetInverterRealtimeData.cgi", query);
 }
 
-FroniusNetworkReply *FroniusSolarConnection::getStorageRealtimeData(int meterId)
+FroniusNetworkReply *FroniusSolarConnection::getMeterRealtimeSystemData()
+{
+    QUrlQuery query;
+    query.addQueryItem("Scope", "System");
+    return createRequest("/solar_api/v1/GetMeterRealtimeData.cgi", query);
+}
+
+FroniusNetworkReply *FroniusSolarConnection::getStorageRealtimeSystemData()
+{
+    QUrlQuery query;
+    query.addQueryItem("Scope", "System");
+    return createRequest("/solar_api/v1/GetStorageRealtimeData.cgi", query);
+}
+
+FroniusNetworkReply *FroniusSolarConnection::createRequest(const QString &path, const QUrlQuery &query)
 {
     QUrl requestUrl;
     requestUrl.setScheme("http");
     requestUrl.setHost(m_address.toString());
-    requestUrl.setPath("/solar_api/v1/GetStorageRealtimeData.cgi");
-
-    QUrlQuery query;
-    query.addQueryItem("Scope", "Device");
-    query.addQueryItem("DeviceId", QString::number(meterId));
-    requestUrl.setQuery(query);
+    requestUrl.setPath(path);
+    if (!query.isEmpty()) {
+        requestUrl.setQuery(query);
+    }
 
     FroniusNetworkReply *reply = new FroniusNetworkReply(QNetworkRequest(requestUrl), this);
     m_requestQueue.enqueue(reply);
@@ -192,7 +149,17 @@ void FroniusSolarConnection::sendNextRequest()
     m_currentReply->setNetworkReply(m_networkManager->get(m_currentReply->request()));
 
     connect(m_currentReply, &FroniusNetworkReply::finished, this, [=](){
-        qCDebug(dcFronius()) << "Connection: Request finished" << m_currentReply->networkReply()->error();
+        QNetworkReply::NetworkError error = m_currentReply->networkReply()->error();
+        qCDebug(dcFronius()) << "Connection: Request finished" << error;
+
+        // Note: every request is used for detecting if the logger is available or not.
+        // Content errors (i.e. an unsupported request) mean we can still communicate.
+        if (error == QNetworkReply::NoError || error >= QNetworkReply::ContentAccessDenied) {
+            setAvailable(true);
+        } else {
+            qCDebug(dcFronius()) << "Connection: Request failed:" << m_currentReply->networkReply()->errorString();
+            setAvailable(false);
+        }
 
         // Note: the network reply will be deleted in the destructor
         m_currentReply->deleteLater();
@@ -201,3 +168,13 @@ void FroniusSolarConnection::sendNextRequest()
         sendNextRequest();
     });
 }
+
+void FroniusSolarConnection::setAvailable(bool available)
+{
+    if (m_available == available)
+        return;
+
+    qCDebug(dcFronius()) << "Connection: the connection is" << (available ? "now available" : "not available any more");
+    m_available = available;
+    emit availableChanged(m_available);
+}
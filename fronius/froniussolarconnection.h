@@ -34,6 +34,7 @@
 #include <QObject>
 
 #include <QQueue>
+#include <QUrlQuery>
 #include <QHostAddress>
 
 #include <network/networkaccessmanager.h>
@@ -60,6 +61,11 @@ public:
     FroniusNetworkReply *getMeterRealtimeData(int meterId);
     FroniusNetworkReply *getStorageRealtimeData(int meterId);
 
+    // Scope=System: one request returns the data of all devices of the class
+    FroniusNetworkReply *getInverterRealtimeSystemData();
+    FroniusNetworkReply *getMeterRealtimeSystemData();
+    FroniusNetworkReply *getStorageRealtimeSystemData();
+
 signals:
     void availableChanged(bool available);
 
@@ -73,7 +79,9 @@ private:
     FroniusNetworkReply *m_currentReply = nullptr;
     QQueue<FroniusNetworkReply *> m_requestQueue;
 
+    FroniusNetworkReply *createRequest(const QString &path, const QUrlQuery &query = QUrlQuery());
     void sendNextRequest();
+    void setAvailable(bool available);
 
 };
 
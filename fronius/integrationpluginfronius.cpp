@@ -189,6 +189,14 @@ void IntegrationPluginFronius::setupThing(ThingSetupInfo *info)
             return;
         }
 
+        if (thing->thingClassId() == inverterThingClassId) {
+            m_inverterThings[parentThing->id()].insert(thing->paramValue(inverterThingIdParamTypeId).toString(), thing);
+        } else if (thing->thingClassId() == meterThingClassId) {
+            m_meterThings[parentThing->id()].insert(thing->paramValue(meterThingIdParamTypeId).toString(), thing);
+        } else {
+            m_storageThings[parentThing->id()].insert(thing->paramValue(storageThingIdParamTypeId).toString(), thing);
+        }
+
         info->finish(Thing::ThingErrorNoError);
 
     } else {
@@ -214,9 +222,22 @@ void IntegrationPluginFronius::postSetupThing(Thing *thing)
             m_connectionRefreshTimer->start();
         }
 
+        // New devices are searched on a slower schedule
+        if (!m_deviceDiscoveryTimer) {
+            m_deviceDiscoveryTimer = hardwareManager()->pluginTimerManager()->registerTimer(60);
+            connect(m_deviceDiscoveryTimer, &PluginTimer::timeout, this, [this]() {
+                foreach (FroniusSolarConnection *connection, m_froniusConnections.keys()) {
+                    discoverDevices(connection);
+                }
+            });
+
+            m_deviceDiscoveryTimer->start();
+        }
+
         // Refresh now
         FroniusSolarConnection *connection = m_froniusConnections.key(thing);
         if (connection) {
+            discoverDevices(connection);
             refreshConnection(connection);
         }
     }
@@ -228,11 +249,23 @@ void IntegrationPluginFronius::thingRemoved(Thing *thing)
         FroniusSolarConnection *connection = m_froniusConnections.key(thing);
         m_froniusConnections.remove(connection);
         connection->deleteLater();
+
+        m_inverterThings.remove(thing->id());
+        m_meterThings.remove(thing->id());
+        m_storageThings.remove(thing->id());
+    } else if (thing->thingClassId() == inverterThingClassId) {
+        m_inverterThings[thing->parentId()].remove(thing->paramValue(inverterThingIdParamTypeId).toString());
+    } else if (thing->thingClassId() == meterThingClassId) {
+        m_meterThings[thing->parentId()].remove(thing->paramValue(meterThingIdParamTypeId).toString());
+    } else if (thing->thingClassId() == storageThingClassId) {
+        m_storageThings[thing->parentId()].remove(thing->paramValue(storageThingIdParamTypeId).toString());
     }
 
     if (myThings().filterByThingClassId(connectionThingClassId).isEmpty()) {
         hardwareManager()->pluginTimerManager()->unregisterTimer(m_connectionRefreshTimer);
         m_connectionRefreshTimer = nullptr;
+        hardwareManager()->pluginTimerManager()->unregisterTimer(m_deviceDiscoveryTimer);
+        m_deviceDiscoveryTimer = nullptr;
     }
 }
 
@@ -249,7 +282,20 @@ void IntegrationPluginFronius::refreshConnection(FroniusSolarConnection *connect
         return;
     }
 
-    // Note: this call will be used to monitor the available state of the connection internally
+    // Note: every request is used to monitor the available state of the connection internally.
+    // While the logger is not reachable only the power flow is requested to detect when it comes back.
+    updatePowerFlow(connection);
+    if (!connection->available())
+        return;
+
+    // One request per device class with Scope=System
+    updateInverters(connection);
+    updateMeters(connection);
+    updateStorages(connection);
+}
+
+void IntegrationPluginFronius::discoverDevices(FroniusSolarConnection *connection)
+{
     FroniusNetworkReply *reply = connection->getActiveDevices();
     connect(reply, &FroniusNetworkReply::finished, this, [=]() {
         if (reply->networkReply()->error() != QNetworkReply::NoError) {
@@ -283,7 +329,7 @@ void IntegrationPluginFronius::refreshConnection(FroniusSolarConnection *connect
             const QString serialNumber = inverterInfo.value("Serial").toString();
 
             // Note: we use the id to identify for backwards compatibility
-            if (myThings().filterByParam(inverterThingIdParamTypeId, inverterId).isEmpty()) {
+            if (!m_inverterThings.value(connectionThing->id()).contains(inverterId)) {
                 QString thingDescription = connectionThing->name();
                 ThingDescriptor descriptor(inverterThingClassId, "Fronius Solar Inverter", thingDescription, connectionThing->id());
                 ParamList params;
@@ -298,7 +344,7 @@ void IntegrationPluginFronius::refreshConnection(FroniusSolarConnection *connect
         QVariantMap meterMap = bodyMap.value("Data").toMap().value("Meter").toMap();
         foreach (const QString &meterId, meterMap.keys()) {
             // Note: we use the id to identify for backwards compatibility
-            if (myThings().filterByParam(meterThingIdParamTypeId, meterId).isEmpty()) {
+            if (!m_meterThings.value(connectionThing->id()).contains(meterId)) {
                 // Get the meter realtime data for details
                 FroniusNetworkReply *realtimeDataReply = connection->getMeterRealtimeData(meterId.toInt());
                 connect(realtimeDataReply, &FroniusNetworkReply::finished, this, [=]() {
@@ -342,7 +388,7 @@ void IntegrationPluginFronius::refreshConnection(FroniusSolarConnection *connect
         QVariantMap storageMap = bodyMap.value("Data").toMap().value("Storage").toMap();
         foreach (const QString &storageId, storageMap.keys()) {
             // Note: we use the id to identify for backwards compatibility
-            if (myThings().filterByParam(storageThingIdParamTypeId, storageId).isEmpty()) {
+            if (!m_storageThings.value(connectionThing->id()).contains(storageId)) {
 
                 // Get the meter realtime data for details
                 FroniusNetworkReply *realtimeDataReply = connection->getStorageRealtimeData(storageId.toInt());
@@ -403,12 +449,6 @@ void IntegrationPluginFronius::refreshConnection(FroniusSolarConnection *connect
             emit autoThingsAppeared(thingDescriptors);
             thingDescriptors.clear();
         }
-
-        // All devices
-        updatePowerFlow(connection);
-        updateInverters(connection);
-        updateMeters(connection);
-        updateStorages(connection);
     });
 }
 
@@ -439,17 +479,17 @@ void IntegrationPluginFronius::updatePowerFlow(FroniusSolarConnection *connectio
         //qCDebug(dcFronius()) << "Power flow data" << qUtf8Printable(QJsonDocument::fromVariant(dataMap).toJson(QJsonDocument::Indented));
 
         // Find the inverter for this connection and set the total power
-        Things availableInverters = myThings().filterByParentId(parentThing->id()).filterByThingClassId(inverterThingClassId);
+        QHash<QString, Thing *> availableInverters = m_inverterThings.value(parentThing->id());
         if (availableInverters.count() == 1) {
-            Thing *inverterThing = availableInverters.first();
+            Thing *inverterThing = availableInverters.begin().value();
             double pvPower = dataMap.value("Site").toMap().value("P_PV").toDouble();
             inverterThing->setStateValue(inverterCurrentPowerStateTypeId, - pvPower);
         }
 
         // Find the storage for this connection and update the current power
-        Things availableStorages = myThings().filterByParentId(parentThing->id()).filterByThingClassId(storageThingClassId);
+        QHash<QString, Thing *> availableStorages = m_storageThings.value(parentThing->id());
         if (availableStorages.count() == 1) {
-            Thing *storageThing = availableStorages.first();
+            Thing *storageThing = availableStorages.begin().value();
             // Note: negative (charge), positiv (discharge)
             double akkuPower = - dataMap.value("Site").toMap().value("P_Akku").toDouble();
             storageThing->setStateValue(storageCurrentPowerStateTypeId, akkuPower);
@@ -469,207 +509,240 @@ void IntegrationPluginFronius::updatePowerFlow(FroniusSolarConnection *connectio
 void IntegrationPluginFronius::updateInverters(FroniusSolarConnection *connection)
 {
     Thing *parentThing = m_froniusConnections.value(connection);
-    foreach (Thing *inverterThing, myThings().filterByParentId(parentThing->id()).filterByThingClassId(inverterThingClassId)) {
-        int inverterId = inverterThing->paramValue(inverterThingIdParamTypeId).toInt();
-
-        // Get the inverter realtime data
-        FroniusNetworkReply *realtimeDataReply = connection->getInverterRealtimeData(inverterId);
-        connect(realtimeDataReply, &FroniusNetworkReply::finished, this, [=]() {
-            if (realtimeDataReply->networkReply()->error() != QNetworkReply::NoError) {
-                // Thing does not seem to be reachable
+    if (m_inverterThings.value(parentThing->id()).isEmpty())
+        return;
+
+    // Get the realtime data of all inverters
+    FroniusNetworkReply *realtimeDataReply = connection->getInverterRealtimeSystemData();
+    // Note: the connection thing is the context, so the reply is dropped if it gets removed in the meantime
+    connect(realtimeDataReply, &FroniusNetworkReply::finished, parentThing, [=]() {
+        QHash<QString, Thing *> inverterThings = m_inverterThings.value(parentThing->id());
+
+        if (realtimeDataReply->networkReply()->error() != QNetworkReply::NoError) {
+            // Things do not seem to be reachable
+            foreach (Thing *inverterThing, inverterThings) {
                 inverterThing->setStateValue("connected", false);
-                return;
             }
+            return;
+        }
 
-            QByteArray data = realtimeDataReply->networkReply()->readAll();
+        QByteArray data = realtimeDataReply->networkReply()->readAll();
 
-            QJsonParseError error;
-            QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
-            if (error.error != QJsonParseError::NoError) {
-                qCWarning(dcFronius()) << "Inverter: Failed to parse JSON data" << data << ":" << error.errorString();
+        QJsonParseError error;
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
+        if (error.error != QJsonParseError::NoError) {
+            qCWarning(dcFronius()) << "Inverter: Failed to parse JSON data" << data << ":" << error.errorString();
+            foreach (Thing *inverterThing, inverterThings) {
                 inverterThing->setStateValue("connected", false);
-                return;
             }
+            return;
+        }
 
-            // Parse the data and update the states of our device
-            QVariantMap dataMap = jsonDoc.toVariant().toMap().value("Body").toMap().value("Data").toMap();
-            //qCDebug(dcFronius()) << "Inverter data" << qUtf8Printable(QJsonDocument::fromVariant(dataMap).toJson(QJsonDocument::Indented));
-
-            // Note: this is the PV power after feeding the battery, we have to use the total PV production from the power flow
-            //if (dataMap.contains("PAC")) {
-            //    QVariantMap map = dataMap.value("PAC").toMap();
-            //    if (map.value("Unit") == "W") {
-            //        inverterThing->setStateValue(inverterCurrentPowerStateTypeId, - map.value("Value").toDouble());
-            //    }
-            //}
-
-            // Set the inverter device state
-            if (dataMap.contains("DAY_ENERGY")) {
-                QVariantMap map = dataMap.value("DAY_ENERGY").toMap();
-                if (map.value("Unit") == "Wh") {
-                    inverterThing->setStateValue(inverterEnergyDayStateTypeId, map.value("Value").toDouble() / 1000);
-                }
-            }
+        // Parse the data and update the states of our devices.
+        // In system scope every value contains the values of all inverters by id: {"Unit": "Wh", "Values": {"1": 1234}}
+        QVariantMap dataMap = jsonDoc.toVariant().toMap().value("Body").toMap().value("Data").toMap();
+        //qCDebug(dcFronius()) << "Inverter data" << qUtf8Printable(QJsonDocument::fromVariant(dataMap).toJson(QJsonDocument::Indented));
 
-            if (dataMap.contains("YEAR_ENERGY")) {
-                QVariantMap map = dataMap.value("YEAR_ENERGY").toMap();
-                if (map.value("Unit") == "Wh") {
-                    inverterThing->setStateValue(inverterEnergyYearStateTypeId, map.value("Value").toDouble() / 1000);
-                }
-            }
+        // Note: the PAC is the PV power after feeding the battery, we have to use the total PV production from the power flow
+        QHash<QString, StateTypeId> energyStateTypeIds;
+        energyStateTypeIds.insert("DAY_ENERGY", inverterEnergyDayStateTypeId);
+        energyStateTypeIds.insert("YEAR_ENERGY", inverterEnergyYearStateTypeId);
+        energyStateTypeIds.insert("TOTAL_ENERGY", inverterTotalEnergyProducedStateTypeId);
 
-            if (dataMap.contains("TOTAL_ENERGY")) {
-                QVariantMap map = dataMap.value("TOTAL_ENERGY").toMap();
-                if (map.value("Unit") == "Wh") {
-                    inverterThing->setStateValue(inverterTotalEnergyProducedStateTypeId, map.value("Value").toDouble() / 1000);
+        foreach (const QString &key, energyStateTypeIds.keys()) {
+            QVariantMap map = dataMap.value(key).toMap();
+            if (map.value("Unit") != "Wh")
+                continue;
+
+            QVariantMap values = map.value("Values").toMap();
+            foreach (const QString &inverterId, values.keys()) {
+                Thing *inverterThing = inverterThings.value(inverterId);
+                if (inverterThing) {
+                    inverterThing->setStateValue(energyStateTypeIds.value(key), values.value(inverterId).toDouble() / 1000);
                 }
             }
+        }
 
+        foreach (Thing *inverterThing, inverterThings) {
             inverterThing->setStateValue("connected", true);
-        });
-    }
+        }
+    });
 }
 
 void IntegrationPluginFronius::updateMeters(FroniusSolarConnection *connection)
 {
     Thing *parentThing = m_froniusConnections.value(connection);
-    foreach (Thing *meterThing, myThings().filterByParentId(parentThing->id()).filterByThingClassId(meterThingClassId)) {
-        int meterId = meterThing->paramValue(inverterThingIdParamTypeId).toInt();
-
-        // Get the inverter realtime data
-        FroniusNetworkReply *realtimeDataReply = connection->getMeterRealtimeData(meterId);
-        connect(realtimeDataReply, &FroniusNetworkReply::finished, this, [=]() {
-            if (realtimeDataReply->networkReply()->error() != QNetworkReply::NoError) {
-                // Thing does not seem to be reachable
-                meterThing->setStateValue("connected", false);
-                return;
-            }
+    if (m_meterThings.value(parentThing->id()).isEmpty())
+        return;
 
-            QByteArray data = realtimeDataReply->networkReply()->readAll();
+    // Get the realtime data of all meters
+    FroniusNetworkReply *realtimeDataReply = connection->getMeterRealtimeSystemData();
+    connect(realtimeDataReply, &FroniusNetworkReply::finished, parentThing, [=]() {
+        QHash<QString, Thing *> meterThings = m_meterThings.value(parentThing->id());
 
-            QJsonParseError error;
-            QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
-            if (error.error != QJsonParseError::NoError) {
-                qCWarning(dcFronius()) << "Meter: Failed to parse JSON data" << data << ":" << error.errorString();
+        if (realtimeDataReply->networkReply()->error() != QNetworkReply::NoError) {
+            // Things do not seem to be reachable
+            foreach (Thing *meterThing, meterThings) {
                 meterThing->setStateValue("connected", false);
-                return;
             }
+            return;
+        }
 
-            // Parse the data and update the states of our device
-            QVariantMap dataMap = jsonDoc.toVariant().toMap().value("Body").toMap().value("Data").toMap();
-            //qCDebug(dcFronius()) << "Meter data" << qUtf8Printable(QJsonDocument::fromVariant(dataMap).toJson(QJsonDocument::Indented));
+        QByteArray data = realtimeDataReply->networkReply()->readAll();
 
-            // Power
-            if (dataMap.contains("PowerReal_P_Sum")) {
-                meterThing->setStateValue(meterCurrentPowerStateTypeId, dataMap.value("PowerReal_P_Sum").toDouble());
+        QJsonParseError error;
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
+        if (error.error != QJsonParseError::NoError) {
+            qCWarning(dcFronius()) << "Meter: Failed to parse JSON data" << data << ":" << error.errorString();
+            foreach (Thing *meterThing, meterThings) {
+                meterThing->setStateValue("connected", false);
             }
+            return;
+        }
 
-            if (dataMap.contains("PowerReal_P_Phase_1")) {
-                meterThing->setStateValue(meterCurrentPowerPhaseAStateTypeId, dataMap.value("PowerReal_P_Phase_1").toDouble());
+        // In system scope the data of each meter is listed by its id
+        QVariantMap dataMap = jsonDoc.toVariant().toMap().value("Body").toMap().value("Data").toMap();
+        foreach (const QString &meterId, meterThings.keys()) {
+            Thing *meterThing = meterThings.value(meterId);
+            if (!dataMap.contains(meterId)) {
+                meterThing->setStateValue("connected", false);
+                continue;
             }
+            updateMeter(meterThing, dataMap.value(meterId).toMap());
+        }
+    });
+}
 
-            if (dataMap.contains("PowerReal_P_Phase_2")) {
-                meterThing->setStateValue(meterCurrentPowerPhaseBStateTypeId, dataMap.value("PowerReal_P_Phase_2").toDouble());
-            }
+void IntegrationPluginFronius::updateStorages(FroniusSolarConnection *connection)
+{
+    Thing *parentThing = m_froniusConnections.value(connection);
+    if (m_storageThings.value(parentThing->id()).isEmpty())
+        return;
 
-            if (dataMap.contains("PowerReal_P_Phase_3")) {
-                meterThing->setStateValue(meterCurrentPowerPhaseCStateTypeId, dataMap.value("PowerReal_P_Phase_3").toDouble());
-            }
+    // Get the realtime data of all storages
+    FroniusNetworkReply *realtimeDataReply = connection->getStorageRealtimeSystemData();
+    connect(realtimeDataReply, &FroniusNetworkReply::finished, parentThing, [=]() {
+        QHash<QString, Thing *> storageThings = m_storageThings.value(parentThing->id());
 
-            // Current
-            if (dataMap.contains("Current_AC_Phase_1")) {
-                meterThing->setStateValue(meterCurrentPhaseAStateTypeId, dataMap.value("Current_AC_Phase_1").toDouble());
+        if (realtimeDataReply->networkReply()->error() != QNetworkReply::NoError) {
+            // Things do not seem to be reachable
+            foreach (Thing *storageThing, storageThings) {
+                storageThing->setStateValue("connected", false);
             }
+            return;
+        }
 
-            if (dataMap.contains("Current_AC_Phase_2")) {
-                meterThing->setStateValue(meterCurrentPhaseBStateTypeId, dataMap.value("Current_AC_Phase_2").toDouble());
-            }
+        QByteArray data = realtimeDataReply->networkReply()->readAll();
 
-            if (dataMap.contains("Current_AC_Phase_3")) {
-                meterThing->setStateValue(meterCurrentPhaseCStateTypeId, dataMap.value("Current_AC_Phase_3").toDouble());
+        QJsonParseError error;
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
+        if (error.error != QJsonParseError::NoError) {
+            qCWarning(dcFronius()) << "Storage: Failed to parse JSON data" << data << ":" << error.errorString();
+            foreach (Thing *storageThing, storageThings) {
+                storageThing->setStateValue("connected", false);
             }
+            return;
+        }
 
-            // Voltage
-            if (dataMap.contains("Voltage_AC_Phase_1")) {
-                meterThing->setStateValue(meterVoltagePhaseAStateTypeId, dataMap.value("Voltage_AC_Phase_1").toDouble());
+        // In system scope the data of each storage is listed by its id
+        QVariantMap dataMap = jsonDoc.toVariant().toMap().value("Body").toMap().value("Data").toMap();
+        foreach (const QString &storageId, storageThings.keys()) {
+            Thing *storageThing = storageThings.value(storageId);
+            if (!dataMap.contains(storageId)) {
+                storageThing->setStateValue("connected", false);
+                continue;
             }
+            updateStorage(storageThing, dataMap.value(storageId).toMap());
+        }
+    });
+}
 
-            if (dataMap.contains("Voltage_AC_Phase_2")) {
-                meterThing->setStateValue(meterVoltagePhaseBStateTypeId, dataMap.value("Voltage_AC_Phase_2").toDouble());
-            }
+void IntegrationPluginFronius::updateMeter(Thing *meterThing, const QVariantMap &dataMap)
+{
+    //qCDebug(dcFronius()) << "Meter data" << qUtf8Printable(QJsonDocument::fromVariant(dataMap).toJson(QJsonDocument::Indented));
 
-            if (dataMap.contains("Voltage_AC_Phase_3")) {
-                meterThing->setStateValue(meterVoltagePhaseCStateTypeId, dataMap.value("Voltage_AC_Phase_3").toDouble());
-            }
+    // Power
+    if (dataMap.contains("PowerReal_P_Sum")) {
+        meterThing->setStateValue(meterCurrentPowerStateTypeId, dataMap.value("PowerReal_P_Sum").toDouble());
+    }
 
-            // Total energy
-            if (dataMap.contains("EnergyReal_WAC_Sum_Produced")) {
-                meterThing->setStateValue(meterTotalEnergyProducedStateTypeId, dataMap.value("EnergyReal_WAC_Sum_Produced").toInt()/1000.00);
-            }
+    if (dataMap.contains("PowerReal_P_Phase_1")) {
+        meterThing->setStateValue(meterCurrentPowerPhaseAStateTypeId, dataMap.value("PowerReal_P_Phase_1").toDouble());
+    }
 
-            if (dataMap.contains("EnergyReal_WAC_Sum_Consumed")) {
-                meterThing->setStateValue(meterTotalEnergyConsumedStateTypeId, dataMap.value("EnergyReal_WAC_Sum_Consumed").toInt()/1000.00);
-            }
+    if (dataMap.contains("PowerReal_P_Phase_2")) {
+        meterThing->setStateValue(meterCurrentPowerPhaseBStateTypeId, dataMap.value("PowerReal_P_Phase_2").toDouble());
+    }
 
-            // Frequency
-            if (dataMap.contains("Frequency_Phase_Average")) {
-                meterThing->setStateValue(meterFrequencyStateTypeId, dataMap.value("Frequency_Phase_Average").toDouble());
-            }
+    if (dataMap.contains("PowerReal_P_Phase_3")) {
+        meterThing->setStateValue(meterCurrentPowerPhaseCStateTypeId, dataMap.value("PowerReal_P_Phase_3").toDouble());
+    }
 
-            meterThing->setStateValue("connected", true);
-        });
+    // Current
+    if (dataMap.contains("Current_AC_Phase_1")) {
+        meterThing->setStateValue(meterCurrentPhaseAStateTypeId, dataMap.value("Current_AC_Phase_1").toDouble());
     }
-}
 
-void IntegrationPluginFronius::updateStorages(FroniusSolarConnection *connection)
-{
-    Thing *parentThing = m_froniusConnections.value(connection);
-    foreach (Thing *storageThing, myThings().filterByParentId(parentThing->id()).filterByThingClassId(storageThingClassId)) {
-        int storageId = storageThing->paramValue(storageThingIdParamTypeId).toInt();
-
-        // Get the storage realtime data
-        FroniusNetworkReply *realtimeDataReply = connection->getStorageRealtimeData(storageId);
-        connect(realtimeDataReply, &FroniusNetworkReply::finished, this, [=]() {
-            if (realtimeDataReply->networkReply()->error() != QNetworkReply::NoError) {
-                // Thing does not seem to be reachable
-                storageThing->setStateValue("connected", false);
-                return;
-            }
+    if (dataMap.contains("Current_AC_Phase_2")) {
+        meterThing->setStateValue(meterCurrentPhaseBStateTypeId, dataMap.value("Current_AC_Phase_2").toDouble());
+    }
+
+    if (dataMap.contains("Current_AC_Phase_3")) {
+        meterThing->setStateValue(meterCurrentPhaseCStateTypeId, dataMap.value("Current_AC_Phase_3").toDouble());
+    }
 
-            QByteArray data = realtimeDataReply->networkReply()->readAll();
+    // Voltage
+    if (dataMap.contains("Voltage_AC_Phase_1")) {
+        meterThing->setStateValue(meterVoltagePhaseAStateTypeId, dataMap.value("Voltage_AC_Phase_1").toDouble());
+    }
 
-            QJsonParseError error;
-            QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
-            if (error.error != QJsonParseError::NoError) {
-                qCWarning(dcFronius()) << "Meter: Failed to parse JSON data" << data << ":" << error.errorString();
-                storageThing->setStateValue("connected", false);
-                return;
-            }
+    if (dataMap.contains("Voltage_AC_Phase_2")) {
+        meterThing->setStateValue(meterVoltagePhaseBStateTypeId, dataMap.value("Voltage_AC_Phase_2").toDouble());
+    }
 
-            // Parse the data and update the states of our device
-            QVariantMap dataMap = jsonDoc.toVariant().toMap().value("Body").toMap().value("Data").toMap();
-            //qCDebug(dcFronius()) << "Storage data" << qUtf8Printable(QJsonDocument::fromVariant(dataMap).toJson(QJsonDocument::Indented));
+    if (dataMap.contains("Voltage_AC_Phase_3")) {
+        meterThing->setStateValue(meterVoltagePhaseCStateTypeId, dataMap.value("Voltage_AC_Phase_3").toDouble());
+    }
 
-            QVariantMap storageInfoMap = dataMap.value("Controller").toMap();
+    // Total energy
+    if (dataMap.contains("EnergyReal_WAC_Sum_Produced")) {
+        meterThing->setStateValue(meterTotalEnergyProducedStateTypeId, dataMap.value("EnergyReal_WAC_Sum_Produced").toInt()/1000.00);
+    }
 
-            // copy retrieved information to thing states
-            if (storageInfoMap.contains("StateOfCharge_Relative")) {
-                storageThing->setStateValue(storageBatteryLevelStateTypeId, storageInfoMap.value("StateOfCharge_Relative").toInt());
-                if (storageThing->stateValue(storageChargingStateStateTypeId).toString() == "charging" && (storageInfoMap.value("StateOfCharge_Relative").toInt() < 5)) {
-                    storageThing->setStateValue(storageBatteryCriticalStateTypeId, true);
-                } else {
-                    storageThing->setStateValue(storageBatteryCriticalStateTypeId, false);
-                }
-            }
+    if (dataMap.contains("EnergyReal_WAC_Sum_Consumed")) {
+        meterThing->setStateValue(meterTotalEnergyConsumedStateTypeId, dataMap.value("EnergyReal_WAC_Sum_Consumed").toInt()/1000.00);
+    }
+
+    // Frequency
+    if (dataMap.contains("Frequency_Phase_Average")) {
+        meterThing->setStateValue(meterFrequencyStateTypeId, dataMap.value("Frequency_Phase_Average").toDouble());
+    }
 
-            if (storageInfoMap.contains("Temperature_Cell"))
-                storageThing->setStateValue(storageCellTemperatureStateTypeId, storageInfoMap.value("Temperature_Cell").toDouble());
+    meterThing->setStateValue("connected", true);
+}
 
-            if (storageInfoMap.contains("Capacity_Maximum"))
-                storageThing->setStateValue(storageCapacityStateTypeId, storageInfoMap.value("Capacity_Maximum").toDouble());
+void IntegrationPluginFronius::updateStorage(Thing *storageThing, const QVariantMap &dataMap)
+{
+    //qCDebug(dcFronius()) << "Storage data" << qUtf8Printable(QJsonDocument::fromVariant(dataMap).toJson(QJsonDocument::Indented));
 
+    QVariantMap storageInfoMap = dataMap.value("Controller").toMap();
 
-            storageThing->setStateValue("connected", true);
-        });
+    // copy retrieved information to thing states
+    if (storageInfoMap.contains("StateOfCharge_Relative")) {
+        storageThing->setStateValue(storageBatteryLevelStateTypeId, storageInfoMap.value("StateOfCharge_Relative").toInt());
+        if (storageThing->stateValue(storageChargingStateStateTypeId).toString() == "charging" && (storageInfoMap.value("StateOfCharge_Relative").toInt() < 5)) {
+            storageThing->setStateValue(storageBatteryCriticalStateTypeId, true);
+        } else {
+            storageThing->setStateValue(storageBatteryCriticalStateTypeId, false);
+        }
     }
+
+    if (storageInfoMap.contains("Temperature_Cell"))
+        storageThing->setStateValue(storageCellTemperatureStateTypeId, storageInfoMap.value("Temperature_Cell").toDouble());
+
+    if (storageInfoMap.contains("Capacity_Maximum"))
+        storageThing->setStateValue(storageCapacityStateTypeId, storageInfoMap.value("Capacity_Maximum").toDouble());
+
+
+    storageThing->setStateValue("connected", true);
 }
@@ -58,16 +58,26 @@ public:
 
 private:
     PluginTimer *m_connectionRefreshTimer = nullptr;
+    PluginTimer *m_deviceDiscoveryTimer = nullptr;
 
     QHash<FroniusSolarConnection *, Thing *> m_froniusConnections;
 
+    // Child things of each connection thing by their Fronius device id
+    QHash<ThingId, QHash<QString, Thing *>> m_inverterThings;
+    QHash<ThingId, QHash<QString, Thing *>> m_meterThings;
+    QHash<ThingId, QHash<QString, Thing *>> m_storageThings;
+
     void refreshConnection(FroniusSolarConnection *connection);
+    void discoverDevices(FroniusSolarConnection *connection);
 
     void updatePowerFlow(FroniusSolarConnection *connection);
     void updateInverters(FroniusSolarConnection *connection);
     void updateMeters(FroniusSolarConnection *connection);
     void updateStorages(FroniusSolarConnection *connection);
 
+    void updateMeter(Thing *meterThing, const QVariantMap &dataMap);
+    void updateStorage(Thing *storageThing, const QVariantMap &dataMap);
+
 };
 
 #endif // INTEGRATIONPLUGINFRONIUS_H
@@ -752,10 +752,16 @@ void HomeConnect::connectEventStream()
     request.setRawHeader("Accept-Language", "en-US");
     request.setRawHeader("accept", "text/event-stream");
 
+    // Start with a clean parser, a previous stream might have ended within an event
+    m_eventStreamBuffer.clear();
+    m_eventStreamType.clear();
+    m_eventStreamData.clear();
+    m_eventStreamId.clear();
+
     QNetworkReply *reply = m_networkManager->get(request);
     connect(reply, &QNetworkReply::finished, reply, &QNetworkReply::deleteLater);
-    connect(reply, &QNetworkReply::finished, [reply, this] {
-        int reconnectTime = 5000; // Usual reconnect in 5 s
+    connect(reply, &QNetworkReply::finished, this, [reply, this] {
+        int reconnectTime = m_eventStreamRetryInterval; // Usual reconnect in 5 s, unless the server requested otherwise
         if (reply->error() != QNetworkReply::NetworkError::NoError) {
             qCDebug(dcHomeConnect()) << "Event stream error" << reply->errorString() << reply->readAll();
         }
@@ -773,81 +779,153 @@ void HomeConnect::connectEventStream()
     connect(reply, &QNetworkReply::readyRead, this, [this, reply]{
 
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-        if (status == 200) {
-            while (reply->canReadLine()) {
-                QJsonDocument data;
-                QString haId;
-                EventType eventType;
-
-                QByteArray eventTypeLine = reply->readLine();
-                if (eventTypeLine == "\n")
-                    continue;
-                if (eventTypeLine.startsWith("event")) {
-                    QString eventString = eventTypeLine.split(':').last().trimmed();
-                    if (eventString == "KEEP-ALIVE") {
-                        eventType = EventTypeKeepAlive;
-                    } else if (eventString == "STATUS") {
-                        eventType = EventTypeStatus;
-                    } else if (eventString == "EVENT") {
-                        eventType = EventTypeEvent;
-                    } else if (eventString == "NOTIFY") {
-                        eventType = EventTypeNotify;
-                    } else if (eventString == "DISCONNECTED") {
-                        eventType = EventTypeDisconnected;
-                    } else if (eventString == "CONNECTED") {
-                        eventType = EventTypeConnected;
-                    } else if (eventString == "PAIRED") {
-                        eventType = EventTypePaired;
-                    } else if (eventString == "DEPAIRED") {
-                        eventType = EventTypeDepaired;
-                    } else {
-                        qCWarning(dcHomeConnect()) << "Unhandled event type" << eventString;
-                        return;
-                    }
-                    QByteArray dataLine = reply->readLine();
-                    if (dataLine.startsWith("data")) {
-                        data = QJsonDocument::fromJson(dataLine.remove(0,6));
-
-                        QByteArray idLine = reply->readLine();
-                        if (idLine.startsWith("id")) {
-                            haId = idLine.split(':').last().trimmed();
-                        } else {
-                            qCWarning(dcHomeConnect()) << "Id line: Unexpected line" << eventTypeLine;
-                            continue;
-                        }
-                    } else {
-                        qCWarning(dcHomeConnect()) << "Data Line: Unexpected line" << eventTypeLine;
-                        continue;
-                    }
-                } else {
-                    qCWarning(dcHomeConnect()) << "Event type: Unexpected line" << eventTypeLine;
-                    continue;
-                }
+        if (status != 200)
+            return;
 
-                if (data.toVariant().toMap().contains("items")) {
-                    QList<Event> events;
-                    QVariantList itemsList = data.toVariant().toMap().value("items").toList();
-                    Q_FOREACH(QVariant item, itemsList) {
-                        QVariantMap map = item.toMap();
-                        Event event;
-                        event.key = map["key"].toString();
-                        event.uri = map["uri"].toString();
-                        event.name = map["uri"].toString();
-                        event.value  = map["value"];
-                        event.unit = map["unit"].toString();
-                        event.timestamp  = map["timestamp"].toInt();
-                        events.append(event);
-                    }
-                    if (!events.isEmpty())
-                        emit receivedEvents(eventType, haId, events);
-                } else if (data.toVariant().toMap().contains("error")) {
-                    qCWarning(dcHomeConnect()) << "Event stream error" << data.toVariant().toMap().value("error");
+        // Lines might be split across reads, only complete lines are processed and
+        // the remainder is kept for the next read.
+        m_eventStreamBuffer.append(reply->readAll());
+        int lineStart = 0;
+        for (int i = 0; i < m_eventStreamBuffer.size(); i++) {
+            char c = m_eventStreamBuffer.at(i);
+            if (c != '\n' && c != '\r')
+                continue;
+
+            // A "\r\n" line break must not end up as an additional empty line
+            if (c == '\r') {
+                if (i + 1 >= m_eventStreamBuffer.size())
+                    break; // Wait for the next read to decide
+
+                if (m_eventStreamBuffer.at(i + 1) == '\n') {
+                    processEventStreamLine(m_eventStreamBuffer.mid(lineStart, i - lineStart));
+                    i++;
+                    lineStart = i + 1;
+                    continue;
                 }
             }
+
+            processEventStreamLine(m_eventStreamBuffer.mid(lineStart, i - lineStart));
+            lineStart = i + 1;
+        }
+        m_eventStreamBuffer.remove(0, lineStart);
+
+        // Note: events are small, an incomplete line or event this size means the stream is broken
+        static const int maxBufferSize = 1024 * 1024;
+        if (m_eventStreamBuffer.size() + m_eventStreamData.size() > maxBufferSize) {
+            qCWarning(dcHomeConnect()) << "Event stream exceeded" << maxBufferSize << "bytes without an event. Reconnecting.";
+            m_eventStreamBuffer.clear();
+            m_eventStreamData.clear();
+            reply->abort();
         }
     });
 }
 
+void HomeConnect::processEventStreamLine(const QByteArray &line)
+{
+    // An empty line terminates the event
+    if (line.isEmpty()) {
+        dispatchStreamEvent();
+        return;
+    }
+
+    // Comment
+    if (line.startsWith(':'))
+        return;
+
+    QByteArray field = line;
+    QByteArray value;
+    int separator = line.indexOf(':');
+    if (separator >= 0) {
+        field = line.left(separator);
+        value = line.mid(separator + 1);
+        if (value.startsWith(' '))
+            value.remove(0, 1);
+    }
+
+    if (field == "event") {
+        m_eventStreamType = value;
+    } else if (field == "data") {
+        // Multiple data lines are joined with a line break
+        if (!m_eventStreamData.isEmpty())
+            m_eventStreamData.append('\n');
+
+        m_eventStreamData.append(value);
+    } else if (field == "id") {
+        m_eventStreamId = value;
+    } else if (field == "retry") {
+        bool ok = false;
+        int retryInterval = value.toInt(&ok);
+        if (ok) {
+            m_eventStreamRetryInterval = retryInterval;
+        }
+    } else {
+        qCDebug(dcHomeConnect()) << "Event stream: Unexpected line" << line;
+    }
+}
+
+void HomeConnect::dispatchStreamEvent()
+{
+    QByteArray eventString = m_eventStreamType;
+    QByteArray data = m_eventStreamData;
+    QString haId = m_eventStreamId;
+    m_eventStreamType.clear();
+    m_eventStreamData.clear();
+
+    if (eventString.isEmpty() && data.isEmpty())
+        return;
+
+    EventType eventType;
+    if (eventString == "KEEP-ALIVE") {
+        return;
+    } else if (eventString == "STATUS") {
+        eventType = EventTypeStatus;
+    } else if (eventString == "EVENT") {
+        eventType = EventTypeEvent;
+    } else if (eventString == "NOTIFY") {
+        eventType = EventTypeNotify;
+    } else if (eventString == "DISCONNECTED") {
+        eventType = EventTypeDisconnected;
+    } else if (eventString == "CONNECTED") {
+        eventType = EventTypeConnected;
+    } else if (eventString == "PAIRED") {
+        eventType = EventTypePaired;
+    } else if (eventString == "DEPAIRED") {
+        eventType = EventTypeDepaired;
+    } else {
+        qCWarning(dcHomeConnect()) << "Unhandled event type" << eventString;
+        return;
+    }
+
+    if (data.isEmpty())
+        return;
+
+    QJsonParseError error;
+    QJsonObject dataObject = QJsonDocument::fromJson(data, &error).object();
+    if (error.error != QJsonParseError::NoError) {
+        qCWarning(dcHomeConnect()) << "Event stream: Failed to parse data" << data << error.errorString();
+        return;
+    }
+
+    if (dataObject.contains("items")) {
+        QList<Event> events;
+        foreach (const QJsonValue &itemValue, dataObject.value("items").toArray()) {
+            QJsonObject item = itemValue.toObject();
+            Event event;
+            event.key = item.value("key").toString();
+            event.uri = item.value("uri").toString();
+            event.name = item.value("uri").toString();
+            event.value = item.value("value").toVariant();
+            event.unit = item.value("unit").toString();
+            event.timestamp = item.value("timestamp").toInt();
+            events.append(event);
+        }
+        if (!events.isEmpty())
+            emit receivedEvents(eventType, haId, events);
+    } else if (dataObject.contains("error")) {
+        qCWarning(dcHomeConnect()) << "Event stream error" << dataObject.value("error").toVariant();
+    }
+}
+
 QUuid HomeConnect::sendCommand(const QString &haid, const QString &command)
 {
     QUuid commandId = QUuid::createUuid();
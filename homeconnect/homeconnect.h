@@ -167,6 +167,16 @@ private:
 
     bool checkStatusCode(QNetworkReply *reply, const QByteArray &rawData);
 
+    // Server sent event stream parser state, kept across readyRead calls
+    QByteArray m_eventStreamBuffer;
+    QByteArray m_eventStreamType;
+    QByteArray m_eventStreamData;
+    QByteArray m_eventStreamId;
+    int m_eventStreamRetryInterval = 5000;
+
+    void processEventStreamLine(const QByteArray &line);
+    void dispatchStreamEvent();
+
 private slots:
     void onRefreshTimeout();
 
@@ -37,8 +37,9 @@
 #include <QDebug>
 #include <QDateTime>
 #include <QUrlQuery>
-#include <QRegExp>
-#include <QStringList>
+
+// Maximum size of the request line and headers
+static const int maximumHeaderSize = 16 * 1024;
 
 HttpSimpleServer::HttpSimpleServer(quint16 port, QObject *parent):
     QTcpServer(parent)
@@ -51,6 +52,16 @@ HttpSimpleServer::~HttpSimpleServer()
     close();
 }
 
+int HttpSimpleServer::maximumBodySize() const
+{
+    return m_maximumBodySize;
+}
+
+void HttpSimpleServer::setMaximumBodySize(int maximumBodySize)
+{
+    m_maximumBodySize = maximumBodySize;
+}
+
 void HttpSimpleServer::incomingConnection(qintptr socket)
 {
     // When a new client connects, the server constructs a QTcpSocket and all
@@ -62,50 +73,243 @@ void HttpSimpleServer::incomingConnection(qintptr socket)
     connect(tcpSocket, SIGNAL(disconnected()), this, SLOT(discardClient()));
     tcpSocket->setSocketDescriptor(socket);
 
+    // Idle keep-alive connections get closed after a while
+    Client client;
+    client.idleTimer = new QTimer(tcpSocket);
+    client.idleTimer->setSingleShot(true);
+    client.idleTimer->setInterval(30000);
+    connect(client.idleTimer, &QTimer::timeout, tcpSocket, &QTcpSocket::disconnectFromHost);
+    client.idleTimer->start();
+    m_clients.insert(tcpSocket, client);
 }
 
 void HttpSimpleServer::readClient()
 {
-    // This slot is called when the client sent data to the server. The
-    // server looks if it was a get request and sends a very simple HTML
-    // document back.
+    // This slot is called when the client sent data to the server. Every complete
+    // request gets answered right away, so pipelined requests are answered in order.
     QTcpSocket* tcpSocket = static_cast<QTcpSocket*>(sender());
-    if (tcpSocket->canReadLine()) {
+    if (!m_clients.contains(tcpSocket))
+        return;
 
-        QByteArray data = tcpSocket->readAll();
-        QStringList tokens = QString(data).split(QRegExp("[ \r\n][ \r\n]*"));
-        qCDebug(dcHttpCommander()) << "Http Request, type" << tokens[0] << "path" << tokens[1] << "body" << tokens.last();
+    Client &client = m_clients[tcpSocket];
+    client.idleTimer->start();
+    client.buffer.append(tcpSocket->readAll());
 
-        if ((tokens[0] == "GET")      ||
-                (tokens[0] == "PUT")  ||
-                (tokens[0] == "POST") ||
-                (tokens[0] == "DELETE")) {
+    QList<Request> requests;
+    processClient(tcpSocket, client, requests);
 
-            QTextStream os(tcpSocket);
-            os.setAutoDetectUnicode(true);
-            os << generateHeader();
-            tcpSocket->close();
-
-            if (tcpSocket->state() == QTcpSocket::UnconnectedState)
-                delete tcpSocket;
-
-            emit requestReceived(tokens[0], tokens[1], tokens.last());
-        }
+    // Note: emitted after parsing, receivers must not see a half processed client state
+    foreach (const Request &request, requests) {
+        qCDebug(dcHttpCommander()) << "Http Request, type" << request.method << "path" << request.path << "body" << request.body;
+        emit requestReceived(request.method, request.path, request.body);
     }
 }
 
 void HttpSimpleServer::discardClient()
 {
     QTcpSocket* socket = static_cast<QTcpSocket*>(sender());
+    m_clients.remove(socket);
     socket->deleteLater();
 }
 
-QString HttpSimpleServer::generateHeader()
+bool HttpSimpleServer::processClient(QTcpSocket *socket, Client &client, QList<Request> &requests)
+{
+    int position = 0;
+    while (position < client.buffer.size()) {
+        if (client.state == Client::StateBody || client.state == Client::StateChunkData) {
+            int length = static_cast<int>(qMin<qint64>(client.remaining, client.buffer.size() - position));
+            client.body.append(client.buffer.constData() + position, length);
+            position += length;
+            client.remaining -= length;
+            if (client.remaining > 0)
+                break;
+
+            if (client.state == Client::StateBody) {
+                finishRequest(socket, client, requests);
+            } else {
+                client.state = Client::StateChunkDataEnd;
+            }
+            continue;
+        }
+
+        int lineEnd = client.buffer.indexOf('\n', position);
+        if (lineEnd < 0) {
+            if (client.buffer.size() - position > maximumHeaderSize) {
+                rejectRequest(socket, client, "431 Request Header Fields Too Large");
+                return false;
+            }
+            break;
+        }
+
+        QByteArray line = client.buffer.mid(position, lineEnd - position);
+        if (line.endsWith('\r'))
+            line.chop(1);
+
+        position = lineEnd + 1;
+        if (!processLine(socket, client, line, requests))
+            return false;
+    }
+
+    client.buffer.remove(0, position);
+    return true;
+}
+
+bool HttpSimpleServer::processLine(QTcpSocket *socket, Client &client, const QByteArray &line, QList<Request> &requests)
+{
+    switch (client.state) {
+    case Client::StateRequestLine: {
+        // Empty lines before a request are allowed
+        if (line.isEmpty())
+            return true;
+
+        QList<QByteArray> tokens = line.split(' ');
+        if (tokens.count() != 3 || !tokens.at(2).startsWith("HTTP/1.")) {
+            rejectRequest(socket, client, "400 Bad Request");
+            return false;
+        }
+        client.method = tokens.at(0);
+        client.path = tokens.at(1);
+        client.keepAlive = (tokens.at(2) != "HTTP/1.0");
+        client.chunked = false;
+        client.remaining = 0;
+        client.headerSize = line.size();
+        client.body.clear();
+        client.state = Client::StateHeaders;
+        return true;
+    }
+    case Client::StateHeaders: {
+        client.headerSize += line.size();
+        if (client.headerSize > maximumHeaderSize) {
+            rejectRequest(socket, client, "431 Request Header Fields Too Large");
+            return false;
+        }
+
+        if (line.isEmpty()) {
+            // End of the header
+            if (client.chunked) {
+                client.state = Client::StateChunkSize;
+            } else if (client.remaining > 0) {
+                client.state = Client::StateBody;
+            } else {
+                finishRequest(socket, client, requests);
+            }
+            return true;
+        }
+
+        int separator = line.indexOf(':');
+        if (separator <= 0) {
+            rejectRequest(socket, client, "400 Bad Request");
+            return false;
+        }
+        QByteArray name = line.left(separator).trimmed().toLower();
+        QByteArray value = line.mid(separator + 1).trimmed();
+        if (name == "content-length") {
+            bool ok = false;
+            client.remaining = value.toLongLong(&ok);
+            if (!ok || client.remaining < 0) {
+                rejectRequest(socket, client, "400 Bad Request");
+                return false;
+            }
+            if (client.remaining > m_maximumBodySize) {
+                rejectRequest(socket, client, "413 Payload Too Large");
+                return false;
+            }
+        } else if (name == "transfer-encoding") {
+            client.chunked = value.toLower().contains("chunked");
+        } else if (name == "connection") {
+            if (value.toLower() == "close") {
+                client.keepAlive = false;
+            } else if (value.toLower() == "keep-alive") {
+                client.keepAlive = true;
+            }
+        }
+        return true;
+    }
+    case Client::StateChunkSize: {
+        // Chunk extensions are ignored
+        bool ok = false;
+        qint64 chunkSize = line.split(';').first().trimmed().toLongLong(&ok, 16);
+        if (!ok || chunkSize < 0) {
+            rejectRequest(socket, client, "400 Bad Request");
+            return false;
+        }
+        // Compared against the space left so huge chunk sizes can't overflow
+        if (chunkSize > m_maximumBodySize - client.body.size()) {
+            rejectRequest(socket, client, "413 Payload Too Large");
+            return false;
+        }
+        if (chunkSize == 0) {
+            client.state = Client::StateChunkTrailer;
+        } else {
+            client.remaining = chunkSize;
+            client.state = Client::StateChunkData;
+        }
+        return true;
+    }
+    case Client::StateChunkDataEnd:
+        if (!line.isEmpty()) {
+            rejectRequest(socket, client, "400 Bad Request");
+            return false;
+        }
+        client.state = Client::StateChunkSize;
+        return true;
+    case Client::StateChunkTrailer:
+        // Trailer fields are ignored, the empty line terminates the request
+        if (line.isEmpty()) {
+            finishRequest(socket, client, requests);
+        }
+        return true;
+    case Client::StateBody:
+    case Client::StateChunkData:
+        break;
+    }
+    return true;
+}
+
+void HttpSimpleServer::finishRequest(QTcpSocket *socket, Client &client, QList<Request> &requests)
+{
+    client.state = Client::StateRequestLine;
+
+    if ((client.method == "GET")      ||
+            (client.method == "PUT")  ||
+            (client.method == "POST") ||
+            (client.method == "DELETE")) {
+        sendResponse(socket, "200 Ok", client.keepAlive);
+
+        Request request;
+        request.method = QString::fromLatin1(client.method);
+        request.path = QString::fromUtf8(client.path);
+        request.body = QString::fromUtf8(client.body);
+        requests.append(request);
+    } else {
+        sendResponse(socket, "405 Method Not Allowed", client.keepAlive);
+    }
+    client.body.clear();
+
+    // Anything pipelined after a "Connection: close" request is dropped
+    if (!client.keepAlive)
+        client.buffer.clear();
+}
+
+void HttpSimpleServer::sendResponse(QTcpSocket *socket, const QByteArray &status, bool keepAlive)
+{
+    QByteArray response = "HTTP/1.1 " + status + "\r\n"
+            "Content-Type: text/html; charset=\"utf-8\"\r\n"
+            "Content-Length: 0\r\n";
+    response.append(keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
+    response.append("\r\n");
+    socket->write(response);
+
+    if (!keepAlive) {
+        socket->disconnectFromHost();
+    }
+}
+
+void HttpSimpleServer::rejectRequest(QTcpSocket *socket, Client &client, const QByteArray &status)
 {
-    QString contentHeader(
-                "HTTP/1.0 200 Ok\r\n"
-                "Content-Type: text/html; charset=\"utf-8\"\r\n"
-                "\r\n"
-                );
-    return contentHeader;
+    qCWarning(dcHttpCommander()) << "Rejecting http request from" << socket->peerAddress().toString() << status;
+    client.buffer.clear();
+    client.body.clear();
+    client.state = Client::StateRequestLine;
+    sendResponse(socket, status, false);
 }
@@ -34,6 +34,9 @@
 #include "typeutils.h"
 
 #include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QHash>
 #include <QUuid>
 #include <QDateTime>
 #include <QUrl>
@@ -50,6 +53,10 @@ public:
     ~HttpSimpleServer() override;
     void incomingConnection(qintptr socket) override;
 
+    // Requests with a larger body are rejected with "413 Payload Too Large"
+    int maximumBodySize() const;
+    void setMaximumBodySize(int maximumBodySize);
+
 signals:
     void disappear();
     void reconfigureAutodevice();
@@ -62,7 +69,45 @@ private slots:
     void discardClient();
 
 private:
-    QString generateHeader();
+    // Receive state of a client connection. Requests are parsed incrementally,
+    // the connection is kept open for further (pipelined) requests.
+    struct Client {
+        enum State {
+            StateRequestLine,
+            StateHeaders,
+            StateBody,
+            StateChunkSize,
+            StateChunkData,
+            StateChunkDataEnd,
+            StateChunkTrailer
+        };
+        State state = StateRequestLine;
+        QByteArray buffer;
+        QTimer *idleTimer = nullptr;
+
+        QByteArray method;
+        QByteArray path;
+        QByteArray body;
+        bool keepAlive = true;
+        bool chunked = false;
+        qint64 remaining = 0;
+        int headerSize = 0;
+    };
+
+    struct Request {
+        QString method;
+        QString path;
+        QString body;
+    };
+
+    QHash<QTcpSocket *, Client> m_clients;
+    int m_maximumBodySize = 1024 * 1024;
+
+    bool processClient(QTcpSocket *socket, Client &client, QList<Request> &requests);
+    bool processLine(QTcpSocket *socket, Client &client, const QByteArray &line, QList<Request> &requests);
+    void finishRequest(QTcpSocket *socket, Client &client, QList<Request> &requests);
+    void sendResponse(QTcpSocket *socket, const QByteArray &status, bool keepAlive);
+    void rejectRequest(QTcpSocket *socket, Client &client, const QByteArray &status);
 
 };
 
@@ -57,6 +57,7 @@ void IntegrationPluginHttpCommander::setupThing(ThingSetupInfo *info)
     if (thing->thingClassId() == httpServerThingClassId) {
         quint16 port = static_cast<uint16_t>(thing->paramValue(httpServerThingPortParamTypeId).toUInt());
         HttpSimpleServer *httpSimpleServer = new HttpSimpleServer(port, this);
+        httpSimpleServer->setMaximumBodySize(thing->paramValue(httpServerThingMaxBodySizeParamTypeId).toInt());
         connect(httpSimpleServer, &HttpSimpleServer::requestReceived, this, &IntegrationPluginHttpCommander::onHttpSimpleServerRequestReceived);
         m_httpSimpleServer.insert(thing, httpSimpleServer);
 
@@ -0,0 +1,104 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "adcdevice.h"
+#include "extern-plugininfo.h"
+
+ADCDevice::ADCDevice(const QString &portName, int address, int channelCount, QObject *parent):
+    I2CDevice(portName, address, parent),
+    m_channelCount(channelCount)
+{
+
+}
+
+int ADCDevice::sweepInterval() const
+{
+    return m_sweepInterval;
+}
+
+void ADCDevice::setSweepInterval(int msecs)
+{
+    m_sweepInterval = msecs;
+}
+
+int ADCDevice::pollInterval() const
+{
+    // Poll a few times per conversion so results are collected shortly after they're ready
+    return qMax(10, conversionTime() / 4);
+}
+
+QByteArray ADCDevice::readData(int fileDescriptor)
+{
+    if (!m_clock.isValid()) {
+        m_clock.start();
+    }
+    qint64 now = m_clock.elapsed();
+
+    if (m_convertingChannel < 0) {
+        if (now < m_nextSweep) {
+            return QByteArray();
+        }
+        m_nextSweep = now + m_sweepInterval;
+        if (!startConversion(fileDescriptor, 0)) {
+            // Try again on the next sweep
+            return QByteArray();
+        }
+        m_convertingChannel = 0;
+        m_resultReady = now + conversionTime();
+        return QByteArray();
+    }
+
+    if (now < m_resultReady) {
+        return QByteArray();
+    }
+
+    int channel = m_convertingChannel;
+    int nextChannel = channel + 1 < m_channelCount ? channel + 1 : -1;
+    double value = 0;
+    bool overvoltage = false;
+    bool success = nextChannel >= 0 ? readConversionAndStartNext(fileDescriptor, channel, nextChannel, &value, &overvoltage)
+                                    : readConversion(fileDescriptor, channel, &value, &overvoltage);
+    if (!success) {
+        // Abort this sweep, the next one starts over with the first channel
+        m_convertingChannel = -1;
+        return QByteArray();
+    }
+
+    emit sampleAvailable(channel, value, overvoltage);
+
+    m_convertingChannel = nextChannel;
+    m_resultReady = now + conversionTime();
+    return QByteArray();
+}
+
+bool ADCDevice::readConversionAndStartNext(int fileDescriptor, int channel, int nextChannel, double *value, bool *overvoltage)
+{
+    return readConversion(fileDescriptor, channel, value, overvoltage) && startConversion(fileDescriptor, nextChannel);
+}
@@ -0,0 +1,79 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef ADCDEVICE_H
+#define ADCDEVICE_H
+
+#include <QElapsedTimer>
+
+#include <hardware/i2c/i2cdevice.h>
+
+// Base class for multi channel ADCs. readData() never waits for a conversion:
+// it starts a conversion, returns, and collects the result on the first call
+// after the conversion time has passed. The device should therefore be polled
+// at pollInterval() while the channels are sampled every sweepInterval().
+class ADCDevice : public I2CDevice
+{
+    Q_OBJECT
+public:
+    explicit ADCDevice(const QString &portName, int address, int channelCount, QObject *parent = nullptr);
+
+    int sweepInterval() const;
+    void setSweepInterval(int msecs);
+
+    int pollInterval() const;
+
+    QByteArray readData(int fileDescriptor) override;
+
+signals:
+    // Emitted from the I2C reading thread
+    void sampleAvailable(int channel, double value, bool overvoltage);
+
+protected:
+    // Time in ms from starting a conversion until its result can be read
+    virtual int conversionTime() const = 0;
+
+    virtual bool startConversion(int fileDescriptor, int channel) = 0;
+    virtual bool readConversion(int fileDescriptor, int channel, double *value, bool *overvoltage) = 0;
+
+    // Chips which start the next conversion while the previous result is read out can do both at once
+    virtual bool readConversionAndStartNext(int fileDescriptor, int channel, int nextChannel, double *value, bool *overvoltage);
+
+private:
+    int m_channelCount = 0;
+    int m_sweepInterval = 5000;
+
+    QElapsedTimer m_clock;
+    qint64 m_nextSweep = 0;
+    qint64 m_resultReady = 0;
+    int m_convertingChannel = -1;
+};
+
+#endif // ADCDEVICE_H
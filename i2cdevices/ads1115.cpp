@@ -28,8 +28,9 @@
 *
 * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
-#include "ads1115channel.h"
+#include "ads1115.h"
 #include "extern-plugininfo.h"
+#include "i2ctransfer.h"
 
 #include <unistd.h>
 
@@ -40,58 +41,74 @@
 #define OPERATIONAL_STATE_CONVERSATION 0x80
 
 #define CONVERSION_MODE_CONTINUOUS 0x00
-#define CONVERSION_MODE_SINGLE     0x40
+#define CONVERSION_MODE_SINGLE     0x01
 
 #define CHANNEL_MODE_DIFFERENTIAL 0x00
-#define CHANNEL_MODE_SINGLE       0x01
+#define CHANNEL_MODE_SINGLE       0x40
 
-ADS1115Channel::ADS1115Channel(const QString &portName, int address, int channel, Gain gain, QObject *parent):
-    I2CDevice(portName, address, parent),
-    m_channel(channel),
-    m_gain(gain)
+#define COMPARATOR_CONFIG 0x05
+
+static const int samplesPerSecond[] = { 8, 16, 32, 64, 128, 250, 475, 860 };
+
+ADS1115::ADS1115(const QString &portName, int address, Gain gain, DataRate dataRate, bool continuousConversion, QObject *parent):
+    ADCDevice(portName, address, 4, parent),
+    m_gain(gain),
+    m_dataRate(dataRate),
+    m_continuousConversion(continuousConversion)
 {
 
 }
 
+ADS1115::DataRate ADS1115::dataRateFromSamplesPerSecond(int sps)
+{
+    for (int i = DataRate8; i <= DataRate860; i++) {
+        if (samplesPerSecond[i] >= sps) {
+            return static_cast<DataRate>(i);
+        }
+    }
+    return DataRate860;
+}
 
-QByteArray ADS1115Channel::readData(int fd)
+int ADS1115::conversionTime() const
 {
-    // Start a configuration conversation
+    // One sample period plus some margin for the internal oscillator tolerance
+    return 1000 / samplesPerSecond[m_dataRate] + 2;
+}
+
+bool ADS1115::startConversion(int fd, int channel)
+{
+    // In continuous mode the conversion restarts with the new input
     unsigned char writeBuf[3] = {0};
     writeBuf[0] = REGISTER_CONFIG; // Select config register
     writeBuf[1] |= OPERATIONAL_STATE_CONVERSATION; // Set conversation bit
     writeBuf[1] |= CHANNEL_MODE_SINGLE;
-    writeBuf[1] |= m_channel << 4;
+    writeBuf[1] |= channel << 4;
     writeBuf[1] |= m_gain << 1;
-    writeBuf[1] |= CONVERSION_MODE_SINGLE;
-    writeBuf[2] = 0x85; // 0b10000101: Data rate: 100, not using comparator
+    writeBuf[1] |= m_continuousConversion ? CONVERSION_MODE_CONTINUOUS : CONVERSION_MODE_SINGLE;
+    writeBuf[2] = (m_dataRate << 5) | COMPARATOR_CONFIG; // not using comparator
     if (write(fd, writeBuf, 3) != 3) {
         qCWarning(dcI2cDevices()) << "ADS1115: could not write config register";
-        return QByteArray();
+        return false;
     }
+    return true;
+}
 
-    // Wait for device to accept configuration (conversation bit is cleared)
-    char readBuf[2] = {0};
-    do {
-        if (read(fd, readBuf, 2) != 2) {
-            qCWarning(dcI2cDevices()) << "ADS1115: could not read ADC data";
-            return QByteArray();
-        }
-    } while (!(readBuf[0] & OPERATIONAL_STATE_CONVERSATION));
-
-    // Select conversation register
-    writeBuf[0] = REGISTER_CONVERSATION;
-    if (write(fd, writeBuf, 1) != 1) {
-        qCWarning(dcI2cDevices()) << "ADS1115: could not write select register";
-        return QByteArray();
-    }
+bool ADS1115::readConversion(int fd, int channel, double *value, bool *overvoltage)
+{
+    Q_UNUSED(channel)
 
-    // Read conversation register
-    if (read(fd, readBuf, 2) != 2) {
+    // Select and read the conversation register in one transaction
+    static const quint8 conversationRegister = REGISTER_CONVERSATION;
+    quint8 conversation[2] = {0};
+    if (!I2CTransfer::readRegisters(fd, address(), &conversationRegister, 1, 2, conversation)) {
         qCWarning(dcI2cDevices()) << "ADS1115: could not read ADC data";
-        return QByteArray();
+        return false;
     }
 
-    return QByteArray(readBuf, 2);
+    // The conversion result is signed, the ADC clips at full scale
+    const int max = 32768;
+    qint16 result = static_cast<qint16>((conversation[0] << 8) | conversation[1]);
+    *value = qMin(1.0 * result / max, 1.0);
+    *overvoltage = result == 0x7FFF;
+    return true;
 }
-
@@ -0,0 +1,76 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef ADS1115_H
+#define ADS1115_H
+
+#include "adcdevice.h"
+
+class ADS1115: public ADCDevice
+{
+    Q_OBJECT
+public:
+
+    enum Gain {
+        Gain_6_144 = 0,
+        Gain_4_096 = 1,
+        Gain_2_048 = 2,
+        Gain_1_024 = 3,
+        Gain_0_512 = 4,
+        Gain_0_256 = 5
+    };
+
+    enum DataRate {
+        DataRate8 = 0,
+        DataRate16 = 1,
+        DataRate32 = 2,
+        DataRate64 = 3,
+        DataRate128 = 4,
+        DataRate250 = 5,
+        DataRate475 = 6,
+        DataRate860 = 7
+    };
+
+    explicit ADS1115(const QString &portName, int address, Gain gain, DataRate dataRate, bool continuousConversion, QObject *parent = nullptr);
+
+    static DataRate dataRateFromSamplesPerSecond(int samplesPerSecond);
+
+protected:
+    int conversionTime() const override;
+    bool startConversion(int fd, int channel) override;
+    bool readConversion(int fd, int channel, double *value, bool *overvoltage) override;
+
+private:
+    Gain m_gain = Gain_4_096;
+    DataRate m_dataRate = DataRate128;
+    bool m_continuousConversion = false;
+};
+
+#endif // ADS1115_H
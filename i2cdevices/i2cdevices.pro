@@ -3,12 +3,16 @@ include(../plugins.pri)
 HEADERS += \
     ina219.h \
     integrationplugini2cdevices.h \
-    ads1115channel.h \
-    pi16adcchannel.h
+    adcdevice.h \
+    ads1115.h \
+    pi16adc.h \
+    i2ctransfer.h
 
 
 SOURCES += \
     ina219.cpp \
     integrationplugini2cdevices.cpp \
-    ads1115channel.cpp \
-    pi16adcchannel.cpp
+    adcdevice.cpp \
+    ads1115.cpp \
+    pi16adc.cpp \
+    i2ctransfer.cpp
@@ -0,0 +1,101 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "i2ctransfer.h"
+#include "extern-plugininfo.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+bool I2CTransfer::readRegisters(int fileDescriptor, int address, const quint8 *registers, int count, int length, quint8 *data)
+{
+    if (count <= 0 || count * 2 > I2C_RDWR_IOCTL_MAX_MSGS) {
+        return false;
+    }
+
+    // The message buffers must be writable
+    quint8 registerBuffer[I2C_RDWR_IOCTL_MAX_MSGS / 2];
+    struct i2c_msg messages[I2C_RDWR_IOCTL_MAX_MSGS];
+    for (int i = 0; i < count; i++) {
+        registerBuffer[i] = registers[i];
+
+        messages[i * 2].addr = static_cast<__u16>(address);
+        messages[i * 2].flags = 0;
+        messages[i * 2].len = 1;
+        messages[i * 2].buf = &registerBuffer[i];
+
+        messages[i * 2 + 1].addr = static_cast<__u16>(address);
+        messages[i * 2 + 1].flags = I2C_M_RD;
+        messages[i * 2 + 1].len = static_cast<__u16>(length);
+        messages[i * 2 + 1].buf = data + i * length;
+    }
+
+    struct i2c_rdwr_ioctl_data transfer;
+    transfer.msgs = messages;
+    transfer.nmsgs = static_cast<__u32>(count * 2);
+    if (ioctl(fileDescriptor, I2C_RDWR, &transfer) != count * 2) {
+        qCWarning(dcI2cDevices()) << "I2C transfer to address" << QString("0x%1").arg(address, 0, 16) << "failed:" << strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool I2CTransfer::writeRead(int fileDescriptor, int address, const quint8 *writeData, int writeLength, quint8 *readData, int readLength)
+{
+    // The message buffers must be writable
+    quint8 writeBuffer[32];
+    if (writeLength <= 0 || writeLength > static_cast<int>(sizeof(writeBuffer))) {
+        return false;
+    }
+    memcpy(writeBuffer, writeData, static_cast<size_t>(writeLength));
+
+    struct i2c_msg messages[2];
+    messages[0].addr = static_cast<__u16>(address);
+    messages[0].flags = 0;
+    messages[0].len = static_cast<__u16>(writeLength);
+    messages[0].buf = writeBuffer;
+
+    messages[1].addr = static_cast<__u16>(address);
+    messages[1].flags = I2C_M_RD;
+    messages[1].len = static_cast<__u16>(readLength);
+    messages[1].buf = readData;
+
+    struct i2c_rdwr_ioctl_data transfer;
+    transfer.msgs = messages;
+    transfer.nmsgs = 2;
+    if (ioctl(fileDescriptor, I2C_RDWR, &transfer) != 2) {
+        qCWarning(dcI2cDevices()) << "I2C transfer to address" << QString("0x%1").arg(address, 0, 16) << "failed:" << strerror(errno);
+        return false;
+    }
+    return true;
+}
@@ -28,36 +28,20 @@
 *
 * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
-#ifndef ADS1115_H
-#define ADS1115_H
+#ifndef I2CTRANSFER_H
+#define I2CTRANSFER_H
 
-#include <QThread>
-#include <QMutex>
+#include <QtGlobal>
 
-#include <hardware/i2c/i2cdevice.h>
-
-class ADS1115Channel: public I2CDevice
+class I2CTransfer
 {
-    Q_OBJECT
 public:
+    // Reads length bytes from each of the given registers using one I2C_RDWR
+    // transaction (register select and read joined by a repeated start).
+    static bool readRegisters(int fileDescriptor, int address, const quint8 *registers, int count, int length, quint8 *data);
 
-    enum Gain {
-        Gain_6_144 = 0,
-        Gain_4_096 = 1,
-        Gain_2_048 = 2,
-        Gain_1_024 = 3,
-        Gain_0_512 = 4,
-        Gain_0_256 = 5
-    };
-
-    explicit ADS1115Channel(const QString &portName, int address, int channel, Gain gain, QObject *parent = nullptr);
-
-    QByteArray readData(int fd) override;
-
-private:
-    int m_channel = 0;
-    Gain m_gain = Gain_4_096;
-
+    // Writes and reads in one I2C_RDWR transaction
+    static bool writeRead(int fileDescriptor, int address, const quint8 *writeData, int writeLength, quint8 *readData, int readLength);
 };
 
-#endif // ADS1115_H
+#endif // I2CTRANSFER_H
@@ -1,10 +1,10 @@
 #include "ina219.h"
+#include "i2ctransfer.h"
 
 #include <unistd.h>
 #include <QtDebug>
 #include <QThread>
 #include <QDebug>
-#include <QJsonDocument>
 
 #include "extern-plugininfo.h"
 
@@ -51,7 +51,7 @@ Ina219::Ina219(const QString &portName, int address, double shuntOhms, VoltageRa
     m_shuntOhms(shuntOhms),
     m_voltageRange(voltageRange)
 {
-
+    qRegisterMetaType<Ina219::Measurement>();
 }
 
 bool Ina219::writeData(int fileDescriptor, const QByteArray &data)
@@ -113,75 +113,39 @@ bool Ina219::writeData(int fileDescriptor, const QByteArray &data)
 
 QByteArray Ina219::readData(int fileDescriptor)
 {
-    char buf[2] = {0};
-
-    buf[0] = INA219_REGISTER_SHUNT_VOLTAGE;
-    int ret = write(fileDescriptor, buf, 1);
-    if (ret != 1) {
-        qCWarning(dcI2cDevices()) << "Failed to select shunt voltage register on INA219";
+    // All measurement registers are read in one transaction
+    static const quint8 registers[] = {
+        INA219_REGISTER_SHUNT_VOLTAGE,
+        INA219_REGISTER_BUS_VOLTAGE,
+        INA219_REGISTER_POWER,
+        INA219_REGISTER_CURRENT
+    };
+    quint8 buf[8] = {0};
+    if (!I2CTransfer::readRegisters(fileDescriptor, address(), registers, 4, 2, buf)) {
+        qCWarning(dcI2cDevices()) << "Failed to read measurement registers on INA219";
         return QByteArray();
     }
-    ret = read(fileDescriptor, buf, 2);
-    if (ret != 2) {
-        qCWarning(dcI2cDevices()) << "Failed to read shunt voltage register on INA219";
-        return QByteArray();
-    }
-    int shuntVoltageRaw = ((buf[0] << 8) | buf[1]);
-    double shuntVoltage = shuntVoltageRaw * SHUNT_MILLIVOLTS_LSB / 1000;
 
+    Measurement measurement;
 
-    buf[0] = INA219_REGISTER_BUS_VOLTAGE;
-    ret = write(fileDescriptor, buf, 1);
-    if (ret != 1) {
-        qCWarning(dcI2cDevices()) << "Failed to select bus voltage register on INA219";
-        return QByteArray();
-    }
-    ret = read(fileDescriptor, buf, 2);
-    if (ret != 2) {
-        qCWarning(dcI2cDevices()) << "Failed to read bus voltage register on INA219";
-        return QByteArray();
-    }
-    int busVoltageRaw = ((buf[0] << 8) | buf[1]);
-    bool overflow = (busVoltageRaw & OVERFLOW_VALUE) == 1;
+    // Shunt voltage and current are signed
+    qint16 shuntVoltageRaw = static_cast<qint16>((buf[0] << 8) | buf[1]);
+    measurement.shuntVoltage = shuntVoltageRaw * SHUNT_MILLIVOLTS_LSB / 1000;
+
+    quint16 busVoltageRaw = static_cast<quint16>((buf[2] << 8) | buf[3]);
+    measurement.overflow = (busVoltageRaw & OVERFLOW_VALUE) == 1;
     busVoltageRaw = busVoltageRaw >> 3; // Registers are not right_aligned
-    double busVoltage = 1.0 * busVoltageRaw * BUS_MILLIVOLTS_LSB / 1000;
+    measurement.busVoltage = 1.0 * busVoltageRaw * BUS_MILLIVOLTS_LSB / 1000;
 
-    buf[0] = INA219_REGISTER_POWER;
-    ret = write(fileDescriptor, buf, 1);
-    if (ret != 1) {
-        qCWarning(dcI2cDevices()) << "Failed to select power register on INA219";
-        return QByteArray();
-    }
-    ret = read(fileDescriptor, buf, 2);
-    if (ret != 2) {
-        qCWarning(dcI2cDevices()) << "Failed to read power register on INA219";
-        return QByteArray();
-    }
-    int powerRaw = ((buf[0] << 8) | buf[1]);
+    quint16 powerRaw = static_cast<quint16>((buf[4] << 8) | buf[5]);
     double powerLSB = m_currentLSB * 20;
-    double power = powerRaw * powerLSB;
+    measurement.power = powerRaw * powerLSB;
 
-    buf[0] = INA219_REGISTER_CURRENT;
-    ret = write(fileDescriptor, buf, 1);
-    if (ret != 1) {
-        qCWarning(dcI2cDevices()) << "Failed to select current register on INA219";
-        return QByteArray();
-    }
-    ret = read(fileDescriptor, buf, 2);
-    if (ret != 2) {
-        qCWarning(dcI2cDevices()) << "Failed to read current register on INA219";
-        return QByteArray();
-    }
-    int currentRaw = ((buf[0] << 8) | buf[1]);
-    double current = 1.0 * currentRaw * m_currentLSB;
-
-    qCDebug(dcI2cDevices()).nospace().noquote() << "INA219 Shunt voltage: " << shuntVoltage << "mV, Bus voltage: " << busVoltage << "V, Power: " << power << "W, Current: " << current << "A, Overflow: " << overflow;
-
-    QVariantMap readings;
-    readings.insert("shuntVoltage", shuntVoltage);
-    readings.insert("busVoltage", busVoltage);
-    readings.insert("power", power);
-    readings.insert("current", current);
-    readings.insert("overflow", overflow);
-    return QJsonDocument::fromVariant(readings).toJson(QJsonDocument::Compact);
+    qint16 currentRaw = static_cast<qint16>((buf[6] << 8) | buf[7]);
+    measurement.current = 1.0 * currentRaw * m_currentLSB;
+
+    qCDebug(dcI2cDevices()).nospace().noquote() << "INA219 Shunt voltage: " << measurement.shuntVoltage << "mV, Bus voltage: " << measurement.busVoltage << "V, Power: " << measurement.power << "W, Current: " << measurement.current << "A, Overflow: " << measurement.overflow;
+
+    emit measurementAvailable(measurement);
+    return QByteArray(reinterpret_cast<const char *>(buf), 8);
 }
@@ -42,13 +42,23 @@ public:
     };
     Q_ENUM(OperationMode)
 
+    class Measurement {
+    public:
+        double shuntVoltage = 0;
+        double busVoltage = 0;
+        double power = 0;
+        double current = 0;
+        bool overflow = false;
+    };
+
     explicit Ina219(const QString &portName, int address, double shuntOhms, VoltageRange voltageRange, QObject *parent = nullptr);
 
     bool writeData(int fileDescriptor, const QByteArray &data) override;
     QByteArray readData(int fileDescriptor) override;
 
 signals:
-    void measurementAvailable();
+    // Emitted from the I2C reading thread for every successful reading
+    void measurementAvailable(const Ina219::Measurement &measurement);
 
 private:
     double m_shuntOhms = 0.1;
@@ -61,4 +71,6 @@ private:
     double m_currentLSB = 0;
 };
 
+Q_DECLARE_METATYPE(Ina219::Measurement)
+
 #endif // INA219_H
@@ -31,14 +31,13 @@
 #include "integrationplugini2cdevices.h"
 #include "plugininfo.h"
 
-#include "pi16adcchannel.h"
-#include "ads1115channel.h"
+#include "pi16adc.h"
+#include "ads1115.h"
 #include "ina219.h"
 
 #include <hardware/i2c/i2cmanager.h>
 
 #include <QDebug>
-#include <QJsonDocument>
 
 IntegrationPluginI2CDevices::IntegrationPluginI2CDevices(): IntegrationPlugin()
 {
@@ -144,28 +143,19 @@ void IntegrationPluginI2CDevices::setupThing(ThingSetupInfo *info)
         int i2cAddress = info->thing()->paramValue(pi16ADCThingI2cAddressParamTypeId).toInt();
         Q_UNUSED(i2cAddress)
 
-        for (int i = 0; i < 16; i++) {
-            Pi16ADCChannel *pi16ADC = new Pi16ADCChannel(i2cPortName, i2cAddress, i, this);
-            if (!hardwareManager()->i2cManager()->open(pi16ADC)) {
-                delete pi16ADC;
-                info->finish(Thing::ThingErrorHardwareFailure, QT_TR_NOOP("Failed to open I2C port."));
-                return;
-            }
-            Thing *thing = info->thing();
-            connect(pi16ADC, &Pi16ADCChannel::readingAvailable, thing, [this, thing, i](const QByteArray &data){
-                if (data.length() != 3) {
-                    qCWarning(dcI2cDevices()) << "Error reading from" << thing->name();
-                    return;
-                }
-                int value = ((((data[0]&0x3F))<<16))+((data[1]<<8))+(((data[2]&0xE0)));
-                const int max = 8388608;
-                double transformedValue = 2.5 * value / max;
-                thing->setStateValue(m_pi16adcChannelMap.value(i), transformedValue);
-                thing->setStateValue(m_pi16adcOvervoltageMap.value(i), (data[0] & 0xC0));
-            });
-            hardwareManager()->i2cManager()->startReading(pi16ADC, 5000);
-            m_i2cDevices.insert(pi16ADC, thing);
+        Pi16ADC *pi16ADC = new Pi16ADC(i2cPortName, i2cAddress, this);
+        if (!hardwareManager()->i2cManager()->open(pi16ADC)) {
+            delete pi16ADC;
+            info->finish(Thing::ThingErrorHardwareFailure, QT_TR_NOOP("Failed to open I2C port."));
+            return;
         }
+        Thing *thing = info->thing();
+        connect(pi16ADC, &Pi16ADC::sampleAvailable, thing, [this, thing](int channel, double voltage, bool overvoltage){
+            thing->setStateValue(m_pi16adcChannelMap.value(channel), voltage);
+            thing->setStateValue(m_pi16adcOvervoltageMap.value(channel), overvoltage);
+        });
+        hardwareManager()->i2cManager()->startReading(pi16ADC, pi16ADC->pollInterval());
+        m_i2cDevices.insert(pi16ADC, thing);
 
         info->finish(Thing::ThingErrorNoError);
     }
@@ -174,44 +164,37 @@ void IntegrationPluginI2CDevices::setupThing(ThingSetupInfo *info)
         QString i2cPortName = info->thing()->paramValue(ads1115ThingI2cPortParamTypeId).toString();
         int i2cAddress = info->thing()->paramValue(ads1115ThingI2cAddressParamTypeId).toInt();
         double gainParam = info->thing()->paramValue(ads1115ThingInputGainParamTypeId).toDouble();
-        ADS1115Channel::Gain inputGain = ADS1115Channel::Gain_4_096;
+        ADS1115::Gain inputGain = ADS1115::Gain_4_096;
         if (qFuzzyCompare(gainParam, 6.144)) {
-            inputGain = ADS1115Channel::Gain_6_144;
+            inputGain = ADS1115::Gain_6_144;
         } else if (qFuzzyCompare(gainParam, 4.096)) {
-            inputGain = ADS1115Channel::Gain_4_096;
+            inputGain = ADS1115::Gain_4_096;
         } else if (qFuzzyCompare(gainParam, 2.048)) {
-            inputGain = ADS1115Channel::Gain_2_048;
+            inputGain = ADS1115::Gain_2_048;
         } else if (qFuzzyCompare(gainParam, 1.024)) {
-            inputGain = ADS1115Channel::Gain_1_024;
+            inputGain = ADS1115::Gain_1_024;
         } else if (qFuzzyCompare(gainParam, 0.512)) {
-            inputGain = ADS1115Channel::Gain_0_512;
+            inputGain = ADS1115::Gain_0_512;
         } else if (qFuzzyCompare(gainParam, 0.256)) {
-            inputGain = ADS1115Channel::Gain_0_256;
+            inputGain = ADS1115::Gain_0_256;
         }
+        ADS1115::DataRate dataRate = ADS1115::dataRateFromSamplesPerSecond(info->thing()->paramValue(ads1115ThingDataRateParamTypeId).toInt());
+        bool continuousConversion = info->thing()->paramValue(ads1115ThingContinuousConversionParamTypeId).toBool();
 
-        for (int i = 0; i < 4; i++) {
-            ADS1115Channel *ads1115 = new ADS1115Channel(i2cPortName, i2cAddress, i, inputGain, this);
-            if (!hardwareManager()->i2cManager()->open(ads1115)) {
-                delete ads1115;
-                info->finish(Thing::ThingErrorHardwareFailure, QT_TR_NOOP("Failed to open I2C port."));
-                return;
-            }
-
-            Thing *thing = info->thing();
-            connect(ads1115, &ADS1115Channel::readingAvailable, thing, [this, thing, i](const QByteArray &data){
-                if (data.length() != 2) {
-                    qCWarning(dcI2cDevices()) << "Error reading from" << thing;
-                    return;
-                }
-                const int max = 32768;
-                int value = static_cast<qint16>(data[0]) * 256 + static_cast<qint16>(data[1]);
-                double transformedValue = qMin(1.0 * value / max, 1.0);
-                thing->setStateValue(m_ads1115ChannelMap.value(i), transformedValue);
-                thing->setStateValue(m_ads1115OvervoltageMap.value(i), value > 32768);
-            });
-            hardwareManager()->i2cManager()->startReading(ads1115, 5000);
-            m_i2cDevices.insert(ads1115, thing);
+        ADS1115 *ads1115 = new ADS1115(i2cPortName, i2cAddress, inputGain, dataRate, continuousConversion, this);
+        if (!hardwareManager()->i2cManager()->open(ads1115)) {
+            delete ads1115;
+            info->finish(Thing::ThingErrorHardwareFailure, QT_TR_NOOP("Failed to open I2C port."));
+            return;
         }
+
+        Thing *thing = info->thing();
+        connect(ads1115, &ADS1115::sampleAvailable, thing, [this, thing](int channel, double value, bool overvoltage){
+            thing->setStateValue(m_ads1115ChannelMap.value(channel), value);
+            thing->setStateValue(m_ads1115OvervoltageMap.value(channel), overvoltage);
+        });
+        hardwareManager()->i2cManager()->startReading(ads1115, ads1115->pollInterval());
+        m_i2cDevices.insert(ads1115, thing);
         info->finish(Thing::ThingErrorNoError);
     }
 
@@ -229,25 +212,21 @@ void IntegrationPluginI2CDevices::setupThing(ThingSetupInfo *info)
         }
 
         Thing *thing = info->thing();
-        connect(ina219, &Ina219::readingAvailable, thing, [thing](const QByteArray &data){
-            QJsonParseError error;
-            QVariantMap values = QJsonDocument::fromJson(data, &error).toVariant().toMap();
-            if (error.error != QJsonParseError::NoError) {
-                qCWarning(dcI2cDevices()) << thing->name() << "Failed to read data from INA219";
-                return;
-            }
-            double currentPower = values.value("power").toDouble();
+        connect(ina219, &Ina219::measurementAvailable, thing, [thing](const Ina219::Measurement &measurement){
+            double currentPower = measurement.power;
             thing->setStateValue(ina219CurrentPowerStateTypeId, currentPower);
-            thing->setStateValue(ina219VoltagePhaseAStateTypeId, values.value("busVoltage").toDouble());
-            thing->setStateValue(ina219CurrentPhaseAStateTypeId, values.value("current").toDouble());
-            thing->setStateValue(ina219OverflowStateTypeId, values.value("overflow").toBool());
+            thing->setStateValue(ina219VoltagePhaseAStateTypeId, measurement.busVoltage);
+            thing->setStateValue(ina219CurrentPhaseAStateTypeId, measurement.current);
+            thing->setStateValue(ina219OverflowStateTypeId, measurement.overflow);
 
             // Calculate an estimate of totalEnergyConsumed
+            QDateTime now = QDateTime::currentDateTime();
             QDateTime lastUpdate = thing->property("lastUpdate").toDateTime();
             if (lastUpdate.isNull()) {
-                lastUpdate = QDateTime::currentDateTime();
+                lastUpdate = now;
             }
-            double hoursPassed = lastUpdate.msecsTo(QDateTime::currentDateTime()) / 1000 / 60 / 60;
+            thing->setProperty("lastUpdate", now);
+            double hoursPassed = lastUpdate.msecsTo(now) / 1000.0 / 60 / 60;
             if (currentPower >= 0) {
                 double totalEnergyConsumed = thing->stateValue(ina219TotalEnergyConsumedStateTypeId).toDouble();
                 totalEnergyConsumed += currentPower / 1000 * hoursPassed;
@@ -261,6 +240,7 @@ void IntegrationPluginI2CDevices::setupThing(ThingSetupInfo *info)
 
         hardwareManager()->i2cManager()->writeData(ina219, "init");
         hardwareManager()->i2cManager()->startReading(ina219, 5000);
+        m_i2cDevices.insert(ina219, thing);
 
         info->finish(Thing::ThingErrorNoError);
     }
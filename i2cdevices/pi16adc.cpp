@@ -28,14 +28,15 @@
 *
 * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
-#include "pi16adcchannel.h"
+#include "pi16adc.h"
 #include "extern-plugininfo.h"
+#include "i2ctransfer.h"
 
 #include <QDebug>
 
 #include <unistd.h>
 
-static QHash<int, char> channelMap = {
+static QHash<int, quint8> channelMap = {
     {0, 0xB0},
     {1, 0xB8},
     {2, 0xB1},
@@ -54,35 +55,61 @@ static QHash<int, char> channelMap = {
     {15, 0xBF}
 };
 
-Pi16ADCChannel::Pi16ADCChannel(const QString &portName, int address, int channel, QObject *parent):
-    I2CDevice(portName, address, parent),
-    m_channel(channel)
+Pi16ADC::Pi16ADC(const QString &portName, int address, QObject *parent):
+    ADCDevice(portName, address, 16, parent)
 {
 }
 
-QByteArray Pi16ADCChannel::readData(int fd)
+int Pi16ADC::conversionTime() const
 {
     // The chip requires a minimum of 200ms of wating between each call or it might just ignore it.
-    // Make sure to wait here long enough for any previous access having settled
-    QThread::msleep(200);
+    return 200;
+}
 
-    // Select the wanted channel
-    qint64 len = write(fd, &channelMap[m_channel], 1);
-    if (len != 1) {
+bool Pi16ADC::startConversion(int fd, int channel)
+{
+    // Select the wanted channel, the conversion starts right after
+    quint8 config = channelMap.value(channel);
+    if (write(fd, &config, 1) != 1) {
         qCWarning(dcI2cDevices()) << "Pi-16ADC: Error writing channel config to device";
-        return QByteArray();
+        return false;
     }
+    return true;
+}
 
-    // Wait for write the chip to settle
-    QThread::msleep(200);
+bool Pi16ADC::readConversion(int fd, int channel, double *value, bool *overvoltage)
+{
+    Q_UNUSED(channel)
 
-    // ready to read the value
-    char readBuf[3] = {0};
+    quint8 readBuf[3] = {0};
     if (read(fd, readBuf, 3) != 3) {
-        qCWarning(dcI2cDevices()) << "Pi-16ADC: could not read ADC data" << readBuf;
-        return QByteArray();
+        qCWarning(dcI2cDevices()) << "Pi-16ADC: could not read ADC data";
+        return false;
     }
+    decode(readBuf, value, overvoltage);
+    return true;
+}
 
-    return QByteArray(readBuf, 3);
+bool Pi16ADC::readConversionAndStartNext(int fd, int channel, int nextChannel, double *value, bool *overvoltage)
+{
+    Q_UNUSED(channel)
+
+    // The chip outputs the finished conversion while the next channel is selected
+    // in the same transaction, so every channel costs one access only.
+    quint8 config = channelMap.value(nextChannel);
+    quint8 readBuf[3] = {0};
+    if (!I2CTransfer::writeRead(fd, address(), &config, 1, readBuf, 3)) {
+        qCWarning(dcI2cDevices()) << "Pi-16ADC: could not read ADC data";
+        return false;
+    }
+    decode(readBuf, value, overvoltage);
+    return true;
 }
 
+void Pi16ADC::decode(const quint8 *data, double *value, bool *overvoltage) const
+{
+    int result = ((data[0] & 0x3F) << 16) + (data[1] << 8) + (data[2] & 0xE0);
+    const int max = 8388608;
+    *value = 2.5 * result / max;
+    *overvoltage = (data[0] & 0xC0) != 0;
+}
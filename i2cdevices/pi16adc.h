@@ -32,22 +32,24 @@
 #define PI16ADC_H
 
 #include <QObject>
-#include <QThread>
-#include <QMutex>
 #include <QHash>
 
-#include <hardware/i2c/i2cdevice.h>
+#include "adcdevice.h"
 
-class Pi16ADCChannel : public I2CDevice
+class Pi16ADC : public ADCDevice
 {
     Q_OBJECT
 public:
-    explicit Pi16ADCChannel(const QString &portName, int address, int channel, QObject *parent = nullptr);
+    explicit Pi16ADC(const QString &portName, int address, QObject *parent = nullptr);
 
-    QByteArray readData(int fileDescriptor) override;
+protected:
+    int conversionTime() const override;
+    bool startConversion(int fileDescriptor, int channel) override;
+    bool readConversion(int fileDescriptor, int channel, double *value, bool *overvoltage) override;
+    bool readConversionAndStartNext(int fileDescriptor, int channel, int nextChannel, double *value, bool *overvoltage) override;
 
 private:
-    int m_channel = 0;
+    void decode(const quint8 *data, double *value, bool *overvoltage) const;
 };
 
 #endif // PI16ADC_H
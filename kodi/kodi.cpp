@@ -316,7 +316,17 @@ void Kodi::disconnectKodi()
 
 void Kodi::browse(BrowseResult *result)
 {
-//    m_jsonHandler->sendData()
+    // Library listings are served from the cache until Kodi reports a library change
+    foreach (const QString &scope, m_libraryCache.keys()) {
+        if (m_libraryCache.value(scope).contains(result->itemId())) {
+            foreach (const BrowserItem &item, m_libraryCache.value(scope).value(result->itemId())) {
+                result->addItem(item);
+            }
+            result->finish(Thing::ThingErrorNoError);
+            return;
+        }
+    }
+
     VirtualFsNode *node = m_virtualFs->findNode(result->itemId());
 
     if (node) {
@@ -550,6 +560,8 @@ void Kodi::onConnectionStatusChanged()
     if (m_connection->connected()) {
         checkVersion();
     } else {
+        // The library might change while we are not listening for notifications
+        m_libraryCache.clear();
         emit connectionStatusChanged(false);
     }
 }
@@ -668,6 +680,19 @@ void Kodi::processNotification(const QString &method, const QVariantMap &params)
             method == "Player.OnAVChange") {
         update();
     }
+
+    if (method == "AudioLibrary.OnUpdate" ||
+            method == "AudioLibrary.OnRemove" ||
+            method == "AudioLibrary.OnScanFinished" ||
+            method == "AudioLibrary.OnCleanFinished" ||
+            method == "VideoLibrary.OnUpdate" ||
+            method == "VideoLibrary.OnRemove" ||
+            method == "VideoLibrary.OnScanFinished" ||
+            method == "VideoLibrary.OnCleanFinished") {
+        QString scope = method.left(method.indexOf('.'));
+        qCDebug(dcKodi()) << "Library changed. Invalidating cached" << scope << "listings";
+        m_libraryCache.remove(scope);
+    }
 }
 
 void Kodi::processResponse(int id, const QString &method, const QVariantMap &response)
@@ -751,6 +776,7 @@ void Kodi::processResponse(int id, const QString &method, const QVariantMap &res
             qCDebug(dcKodi()) << "Thumbnail" << item.thumbnail();
             result->addItem(item);
         }
+        cacheBrowseResult(method, response, result);
         result->finish(Thing::ThingErrorNoError);
         return;
     }
@@ -773,6 +799,7 @@ void Kodi::processResponse(int id, const QString &method, const QVariantMap &res
             item.setDescription(description.join(" - "));
             result->addItem(item);
         }
+        cacheBrowseResult(method, response, result);
         result->finish(Thing::ThingErrorNoError);
         return;
     }
@@ -807,6 +834,7 @@ void Kodi::processResponse(int id, const QString &method, const QVariantMap &res
             result->addItem(item);
             i++;
         }
+        cacheBrowseResult(method, response, result);
         result->finish(Thing::ThingErrorNoError);
         return;
     }
@@ -838,6 +866,7 @@ void Kodi::processResponse(int id, const QString &method, const QVariantMap &res
             item.setDescription(movie.value("year").toString() + " - " + duration + " - " + rating);
             result->addItem(item);
         }
+        cacheBrowseResult(method, response, result);
         result->finish(Thing::ThingErrorNoError);
         return;
     }
@@ -862,6 +891,7 @@ void Kodi::processResponse(int id, const QString &method, const QVariantMap &res
             item.setDescription(tvShow.value("year").toString() + " - " + tr("%1 seasons").arg(tvShow.value("season").toInt()) + " - " + rating);
             result->addItem(item);
         }
+        cacheBrowseResult(method, response, result);
         result->finish(Thing::ThingErrorNoError);
         return;
     }
@@ -878,6 +908,7 @@ void Kodi::processResponse(int id, const QString &method, const QVariantMap &res
             item.setDescription(season.value("showtitle").toString());
             result->addItem(item);
         }
+        cacheBrowseResult(method, response, result);
         result->finish(Thing::ThingErrorNoError);
         return;
     }
@@ -898,6 +929,7 @@ void Kodi::processResponse(int id, const QString &method, const QVariantMap &res
             }
             result->addItem(item);
         }
+        cacheBrowseResult(method, response, result);
         result->finish(Thing::ThingErrorNoError);
         return;
     }
@@ -913,6 +945,7 @@ void Kodi::processResponse(int id, const QString &method, const QVariantMap &res
             item.setThumbnail(prepareThumbnail(musicVideo.value("thumbnail").toString()));
             result->addItem(item);
         }
+        cacheBrowseResult(method, response, result);
         result->finish(Thing::ThingErrorNoError);
         return;
     }
@@ -1040,3 +1073,13 @@ QString Kodi::prepareThumbnail(const QString &thumbnail)
                 .arg(m_httpPort)
                 .arg(QString(thumbnail.toUtf8().toPercentEncoding()));
 }
+
+void Kodi::cacheBrowseResult(const QString &method, const QVariantMap &response, BrowseResult *result)
+{
+    // Only cache complete listings, errors will be requested again next time
+    if (response.contains("error"))
+        return;
+
+    QString scope = method.left(method.indexOf('.'));
+    m_libraryCache[scope].insert(result->itemId(), result->items());
+}
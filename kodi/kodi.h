@@ -112,6 +112,7 @@ private slots:
 
 private:
     QString prepareThumbnail(const QString &thumbnail);
+    void cacheBrowseResult(const QString &method, const QVariantMap &response, BrowseResult *result);
 
 private:
     KodiConnection *m_connection;
@@ -145,6 +146,9 @@ private:
     QHash<int, BrowseResult*> m_pendingBrowseRequests;
     QHash<int, BrowserItemResult*> m_pendingBrowserItemRequests;
 
+    // Library listings by item id, per scope ("AudioLibrary" or "VideoLibrary")
+    QHash<QString, QHash<QString, BrowserItems>> m_libraryCache;
+
 };
 
 #endif // KODI_H
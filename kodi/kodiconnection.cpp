@@ -86,6 +86,7 @@ void KodiConnection::onConnected()
 void KodiConnection::onDisconnected()
 {
     qCDebug(dcKodi) << "disconnected from" << hostAddress().toString() << port();
+    resetFraming();
     m_connected = false;
     emit connectionStatusChanged();
 }
@@ -99,22 +100,77 @@ void KodiConnection::onError(QAbstractSocket::SocketError socketError)
 
 void KodiConnection::readData()
 {
-    QByteArray data = m_socket->readAll();
+    m_buffer.append(m_socket->readAll());
 
-    QStringList commandList = QString(data).split("}{");
-    for(int i = 0; i < commandList.count(); ++i) {
-        QString command = commandList.at(i);
-        if(command.isEmpty()) {
+    int consumed = processBuffer(m_buffer);
+    if (consumed < 0)
+        return;
+
+    if (consumed > 0)
+        m_buffer.remove(0, consumed);
+
+    m_scanPosition = m_buffer.size();
+}
+
+int KodiConnection::processBuffer(const QByteArray buffer)
+{
+    // Kodi sends the JSON objects back to back without any delimiter. Track the nesting
+    // depth (ignoring braces within strings) and hand out each object once it is complete.
+    // The scan state is kept across reads, so every byte is only looked at once.
+    // Note: the buffer is a shallow copy on purpose, a receiver might close the connection
+    // and reset m_buffer while an object gets emitted.
+    const char *data = buffer.constData();
+    int objectStart = 0;
+    for (int i = m_scanPosition; i < buffer.size(); i++) {
+        const char c = data[i];
+        if (m_inString) {
+            if (m_escaped) {
+                m_escaped = false;
+            } else if (c == '\\') {
+                m_escaped = true;
+            } else if (c == '"') {
+                m_inString = false;
+            }
             continue;
         }
-        if(i < commandList.count() - 1) {
-            command.append("}");
-        }
-        if(i > 0) {
-            command.prepend("{");
+
+        if (c == '"') {
+            m_inString = true;
+        } else if (c == '{' || c == '[') {
+            if (m_depth == 0) {
+                objectStart = i;
+            }
+            m_depth++;
+        } else if (c == '}' || c == ']') {
+            if (m_depth == 0) {
+                qCWarning(dcKodi) << "unbalanced JSON data received from" << hostAddress().toString();
+                objectStart = i + 1;
+                continue;
+            }
+            m_depth--;
+            if (m_depth == 0) {
+                // Parse directly from the receive buffer without copying the object
+                emit dataReady(QByteArray::fromRawData(data + objectStart, i - objectStart + 1));
+                if (m_buffer.isEmpty())
+                    return -1;
+
+                objectStart = i + 1;
+            }
+        } else if (m_depth == 0) {
+            // Whitespace between objects
+            objectStart = i + 1;
         }
-        emit dataReady(command.toUtf8());
     }
+    return objectStart;
+}
+
+void KodiConnection::resetFraming()
+{
+    m_buffer.clear();
+    m_scanPosition = 0;
+    m_depth = 0;
+    m_inString = false;
+    m_escaped = false;
 }
 
 void KodiConnection::sendData(const QByteArray &message)
@@ -58,6 +58,16 @@ private:
     int m_port;
     bool m_connected;
 
+    // Incoming stream framing state
+    QByteArray m_buffer;
+    int m_scanPosition = 0;
+    int m_depth = 0;
+    bool m_inString = false;
+    bool m_escaped = false;
+
+    int processBuffer(const QByteArray buffer);
+    void resetFraming();
+
 private slots:
     void onConnected();
     void onDisconnected();
@@ -66,13 +76,12 @@ private slots:
 
 signals:
     void connectionStatusChanged();
+    // Carries exactly one complete JSON object, the data is only valid during the emission
     void dataReady(const QByteArray &data);
 
 public slots:
     void sendData(const QByteArray &message);
 
-
-
 };
 
 #endif // KODICONNECTION_H
@@ -58,7 +58,6 @@ private:
     KodiConnection *m_connection;
     int m_id;
     QHash<int, KodiReply> m_replys;
-    QByteArray m_dataBuffer;
 
 };
 
@@ -160,8 +160,9 @@ void IntegrationPluginNanoleaf::postSetupThing(Thing *thing)
          nanoleaf->registerForEvents();
     }
 
+    // State changes are pushed over the event stream, polling is only a slow consistency check
     if(!m_pluginTimer) {
-        m_pluginTimer = hardwareManager()->pluginTimerManager()->registerTimer(5);
+        m_pluginTimer = hardwareManager()->pluginTimerManager()->registerTimer(60);
         connect(m_pluginTimer, &PluginTimer::timeout, this, [this]() {
             foreach (Nanoleaf *nanoleaf, m_nanoleafConnections) {
                 nanoleaf->getControllerInfo();
@@ -42,7 +42,14 @@ Nanoleaf::Nanoleaf(NetworkAccessManager *networkManager, const QHostAddress &add
     m_address(address),
     m_port(port)
 {
+    m_eventStreamReconnectTimer = new QTimer(this);
+    m_eventStreamReconnectTimer->setSingleShot(true);
+    connect(m_eventStreamReconnectTimer, &QTimer::timeout, this, &Nanoleaf::connectEventStream);
+}
 
+Nanoleaf::~Nanoleaf()
+{
+    unregisterFromEvents();
 }
 
 void Nanoleaf::setIpAddress(const QHostAddress &address)
@@ -430,6 +437,35 @@ void Nanoleaf::getColorMode()
 }
 
 void Nanoleaf::registerForEvents()
+{
+    if (m_eventStreamReply || m_eventStreamReconnectTimer->isActive())
+        return;
+
+    m_eventStreamReconnectInterval = 0;
+    connectEventStream();
+}
+
+void Nanoleaf::unregisterFromEvents()
+{
+    m_eventStreamReconnectTimer->stop();
+    if (!m_eventStreamReply)
+        return;
+
+    // Detach first, so aborting does not schedule a reconnect
+    QNetworkReply *reply = m_eventStreamReply;
+    m_eventStreamReply = nullptr;
+    m_eventStreamConnected = false;
+    disconnect(reply, nullptr, this, nullptr);
+    reply->abort();
+    reply->deleteLater();
+}
+
+bool Nanoleaf::eventStreamConnected() const
+{
+    return m_eventStreamConnected;
+}
+
+void Nanoleaf::connectEventStream()
 {
     QUrl url;
     url.setHost(m_address.toString());
@@ -441,55 +477,113 @@ void Nanoleaf::registerForEvents()
     url.setQuery(query);
     QNetworkRequest request;
     request.setUrl(url);
+    request.setRawHeader("Accept", "text/event-stream");
     QNetworkReply *reply = m_networkManager->get(request);
+    m_eventStreamReply = reply;
+    m_eventStreamBuffer.clear();
 
     connect(reply, &QNetworkReply::readyRead, this, [reply, this] {
-        QJsonParseError error;
-        QJsonDocument data = QJsonDocument::fromJson(reply->readAll(), &error);
-        if (error.error != QJsonParseError::NoError) {
-            qDebug(dcNanoleaf()) << "Recieved invalide JSON object";
-            return;
-        }
-        qCDebug(dcNanoleaf()) << "On event stream" << data.toJson();
+        if (!m_eventStreamConnected) {
+            qCDebug(dcNanoleaf()) << "Event stream connected to" << m_address.toString();
+            m_eventStreamConnected = true;
+            m_eventStreamReconnectInterval = 0;
+        }
+        // Note: line endings are normalized to '\n', the server might use "\r\n"
+        m_eventStreamBuffer.append(reply->readAll().replace('\r', ""));
+        processEventStream();
     });
     connect(reply, &QNetworkReply::finished, this, [reply, this] {
         reply->deleteLater();
-        int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        m_eventStreamReply = nullptr;
+        m_eventStreamConnected = false;
 
+        int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
         if (status < 200 || status > 204 || reply->error() != QNetworkReply::NoError) {
-            qCWarning(dcNanoleaf()) << "Request error:" << status << reply->errorString();
-            emit connectionChanged(false);
-            return;
+            qCWarning(dcNanoleaf()) << "Event stream error:" << status << reply->errorString();
+            // The stream may drop while the device still answers requests. Let a REST request
+            // decide about the connected state instead of flapping it on every stream error.
+            getPower();
+        } else {
+            qCDebug(dcNanoleaf()) << "Event stream closed by" << m_address.toString();
         }
-        QJsonParseError error;
-        QJsonDocument data = QJsonDocument::fromJson(reply->readAll(), &error);
-        if (error.error != QJsonParseError::NoError) {
-            qDebug(dcNanoleaf()) << "Recieved invalide JSON object";
-            return;
+
+        // Reconnect with an exponential backoff, 1 s up to 60 s
+        m_eventStreamReconnectInterval = qBound(1000, m_eventStreamReconnectInterval * 2, 60000);
+        qCDebug(dcNanoleaf()) << "Reconnecting event stream in" << m_eventStreamReconnectInterval << "ms";
+        m_eventStreamReconnectTimer->start(m_eventStreamReconnectInterval);
+    });
+}
+
+void Nanoleaf::processEventStream()
+{
+    // Events are separated by an empty line, each line of an event is a "field: value" pair:
+    // id: 1
+    // data: {"events":[{"attr":2,"value":65}]}
+    int eventEnd;
+    while ((eventEnd = m_eventStreamBuffer.indexOf("\n\n")) >= 0) {
+        QByteArray event = m_eventStreamBuffer.left(eventEnd);
+        m_eventStreamBuffer.remove(0, eventEnd + 2);
+
+        int eventId = 0;
+        QByteArray data;
+        foreach (const QByteArray &line, event.split('\n')) {
+            if (line.startsWith("id:")) {
+                eventId = line.mid(3).trimmed().toInt();
+            } else if (line.startsWith("data:")) {
+                if (!data.isEmpty())
+                    data.append('\n');
+
+                data.append(line.mid(5).trimmed());
+            }
+        }
+
+        if (!data.isEmpty()) {
+            processEvent(eventId, data);
         }
-        qCDebug(dcNanoleaf()) << "Event received" << data.toJson();
-        QVariantList events = data.toVariant().toList();
+    }
+
+    // Note: events are small, an incomplete event this size means the stream is broken
+    static const int maxBufferSize = 1024 * 1024;
+    if (m_eventStreamBuffer.size() > maxBufferSize) {
+        qCWarning(dcNanoleaf()) << "Event stream of" << m_address.toString() << "exceeded" << maxBufferSize << "bytes without an event. Reconnecting.";
+        m_eventStreamBuffer.clear();
+        if (m_eventStreamReply)
+            m_eventStreamReply->abort();
+    }
+}
 
-        foreach (QVariant variant, events) {
-            QVariantMap event = variant.toMap();
-            switch (event["attr"].toInt()) {
+void Nanoleaf::processEvent(int eventId, const QByteArray &data)
+{
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qCWarning(dcNanoleaf()) << "Received invalid event data" << data << error.errorString();
+        return;
+    }
+
+    QJsonArray events = jsonDoc.object().value("events").toArray();
+    foreach (const QJsonValue &eventValue, events) {
+        QJsonObject event = eventValue.toObject();
+        switch (eventId) {
+        case 1: // State
+            switch (event.value("attr").toInt()) {
             case 1:  //ON
-                emit powerReceived(event["value"].toBool());
+                emit powerReceived(event.value("value").toBool());
                 break;
             case 2:  //Brightness
-                emit brightnessReceived(event["value"].toInt());
+                emit brightnessReceived(event.value("value").toInt());
                 break;
             case 3: //Hue
-                emit hueReceived(event["value"].toInt());
+                emit hueReceived(event.value("value").toInt());
                 break;
             case 4: //Saturation
-                emit saturationReceived(event["value"].toInt());
+                emit saturationReceived(event.value("value").toInt());
                 break;
             case 5: //Color Temperature
-                emit colorTemperatureReceived(event["value"].toInt());
+                emit colorTemperatureReceived(event.value("value").toInt());
                 break;
             case 6: { //colorMode
-                QString colorModeString = event["value"].toString();
+                QString colorModeString = event.value("value").toString();
                 if (colorModeString == "effect") {
                     emit colorModeReceived(ColorMode::EffectMode);
                 } else if (colorModeString == "hs") {
@@ -502,11 +596,24 @@ void Nanoleaf::registerForEvents()
                 break;
             }
             default:
-                qCWarning(dcNanoleaf()) << "Unrecognised Event received";
+                qCWarning(dcNanoleaf()) << "Unrecognised state event received" << event;
             }
-
-        }
-    });
+            break;
+        case 2: // Layout
+            qCDebug(dcNanoleaf()) << "Layout changed";
+            break;
+        case 3: // Effects, attribute 1 is the selected effect
+            if (event.value("attr").toInt() == 1) {
+                emit selectedEffectReceived(event.value("value").toString());
+            }
+            break;
+        case 4: // Touch
+            emit touchEventReceived(static_cast<GestureID>(event.value("gesture").toInt()));
+            break;
+        default:
+            qCWarning(dcNanoleaf()) << "Unrecognised event type" << eventId;
+        }
+    }
 }
 
 QUuid Nanoleaf::setPower(bool power)
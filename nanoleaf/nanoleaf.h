@@ -68,6 +68,7 @@ public:
     };
 
     explicit Nanoleaf(NetworkAccessManager *networkManager, const QHostAddress &address, int port = 16021, QObject *parent = nullptr);
+    ~Nanoleaf();
     void setIpAddress(const QHostAddress &address);
     QHostAddress ipAddress();
 
@@ -92,7 +93,11 @@ public:
     void getColorTemperature();
     void getColorMode();
 
+    // Keeps the server sent event stream open and reconnects it if it gets lost
     void registerForEvents();
+    void unregisterFromEvents();
+    bool eventStreamConnected() const;
+
     QUuid setPower(bool power);
     QUuid setColor(QColor color);
     QUuid setHue(int hue);
@@ -114,6 +119,16 @@ private:
     QHostAddress m_address;
     int m_port;
 
+    QNetworkReply *m_eventStreamReply = nullptr;
+    QByteArray m_eventStreamBuffer;
+    bool m_eventStreamConnected = false;
+    QTimer *m_eventStreamReconnectTimer = nullptr;
+    int m_eventStreamReconnectInterval = 0;
+
+    void connectEventStream();
+    void processEventStream();
+    void processEvent(int eventId, const QByteArray &data);
+
 signals:
     void connectionChanged(bool connected);
     void authenticationStatusChanged(bool authenticated);
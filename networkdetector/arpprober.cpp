@@ -0,0 +1,305 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "arpprober.h"
+#include "extern-plugininfo.h"
+
+#include <QNetworkInterface>
+#include <QtEndian>
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <net/ethernet.h>
+#include <net/if_arp.h>
+#include <netinet/if_ether.h>
+#include <linux/if_packet.h>
+
+// Requests sent per tick of the send timer
+static const int sendBatchSize = 16;
+static const int sendInterval = 5;
+
+// Networks larger than this are only scanned around our own address
+static const int minimumScanPrefixLength = 20;
+
+ArpProber::ArpProber(QObject *parent) : QObject(parent)
+{
+    m_sendTimer.setInterval(sendInterval);
+    connect(&m_sendTimer, &QTimer::timeout, this, &ArpProber::sendQueued);
+
+    m_probeTimer.setInterval(1000);
+    connect(&m_probeTimer, &QTimer::timeout, this, &ArpProber::retransmitProbes);
+
+    // Give late replies some time to arrive after the last request of a scan went out
+    m_scanTimer.setInterval(500);
+    m_scanTimer.setSingleShot(true);
+    connect(&m_scanTimer, &QTimer::timeout, this, [this](){
+        m_scanning = false;
+        qCDebug(dcNetworkDetector()) << "ARP network scan finished";
+        emit scanFinished();
+    });
+}
+
+ArpProber::~ArpProber()
+{
+    if (m_socket >= 0) {
+        close(m_socket);
+    }
+}
+
+bool ArpProber::initialize()
+{
+    if (m_socket >= 0)
+        return true;
+
+    m_socket = socket(AF_PACKET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, htons(ETH_P_ARP));
+    if (m_socket < 0) {
+        qCWarning(dcNetworkDetector()) << "Could not create ARP socket:" << strerror(errno);
+        return false;
+    }
+
+    m_notifier = new QSocketNotifier(m_socket, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &ArpProber::readReplies);
+
+    updateInterfaces();
+    qCDebug(dcNetworkDetector()) << "ARP prober initialized.";
+    return true;
+}
+
+bool ArpProber::initialized() const
+{
+    return m_socket >= 0;
+}
+
+bool ArpProber::probe(const QHostAddress &address, int attempts)
+{
+    bool ok = false;
+    quint32 target = address.toIPv4Address(&ok);
+    if (m_socket < 0 || !ok)
+        return false;
+
+    if (!interfaceFor(target)) {
+        // Interfaces might have changed since the last scan
+        updateInterfaces();
+        if (!interfaceFor(target)) {
+            return false;
+        }
+    }
+
+    m_pendingProbes.insert(target, attempts);
+    m_sendQueue.enqueue(target);
+    if (!m_sendTimer.isActive()) {
+        m_sendTimer.start();
+    }
+    if (!m_probeTimer.isActive()) {
+        m_probeTimer.start();
+    }
+    return true;
+}
+
+void ArpProber::scanNetworks()
+{
+    if (m_socket < 0 || m_scanning) {
+        return;
+    }
+
+    updateInterfaces();
+
+    foreach (const Interface &interface, m_interfaces) {
+        int prefixLength = qMax(interface.prefixLength, minimumScanPrefixLength);
+        quint32 netmask = prefixLength == 0 ? 0 : ~0u << (32 - prefixLength);
+        quint32 network = interface.address & netmask;
+        quint32 broadcast = network | ~netmask;
+        qCDebug(dcNetworkDetector()) << "Sending ARP requests on" << interface.name << QHostAddress(network).toString() + '/' + QString::number(prefixLength) << "...";
+        for (quint32 target = network + 1; target < broadcast; target++) {
+            if (target != interface.address) {
+                m_sendQueue.enqueue(target);
+            }
+        }
+    }
+
+    if (m_sendQueue.isEmpty()) {
+        qCWarning(dcNetworkDetector()) << "Could not find any suitable interface for an ARP scan";
+        emit scanFinished();
+        return;
+    }
+
+    m_scanning = true;
+    m_scanTimer.stop();
+    if (!m_sendTimer.isActive()) {
+        m_sendTimer.start();
+    }
+}
+
+void ArpProber::updateInterfaces()
+{
+    m_interfaces.clear();
+    foreach (const QNetworkInterface &networkInterface, QNetworkInterface::allInterfaces()) {
+        if (!networkInterface.flags().testFlag(QNetworkInterface::IsUp) || !networkInterface.flags().testFlag(QNetworkInterface::CanBroadcast) || networkInterface.flags().testFlag(QNetworkInterface::IsLoopBack)) {
+            continue;
+        }
+        QByteArray macAddress = QByteArray::fromHex(networkInterface.hardwareAddress().remove(':').toLatin1());
+        if (macAddress.length() != ETH_ALEN) {
+            continue;
+        }
+        foreach (const QNetworkAddressEntry &addressEntry, networkInterface.addressEntries()) {
+            if (addressEntry.ip().protocol() != QAbstractSocket::IPv4Protocol) {
+                continue;
+            }
+            Interface interface;
+            interface.index = networkInterface.index();
+            interface.name = networkInterface.name();
+            interface.macAddress = macAddress;
+            interface.address = addressEntry.ip().toIPv4Address();
+            interface.netmask = addressEntry.netmask().toIPv4Address();
+            interface.prefixLength = addressEntry.prefixLength();
+            m_interfaces.append(interface);
+        }
+    }
+}
+
+const ArpProber::Interface *ArpProber::interfaceFor(quint32 address) const
+{
+    for (int i = 0; i < m_interfaces.count(); i++) {
+        const Interface &interface = m_interfaces.at(i);
+        if ((address & interface.netmask) == (interface.address & interface.netmask)) {
+            return &interface;
+        }
+    }
+    return nullptr;
+}
+
+bool ArpProber::sendRequest(const Interface &interface, quint32 target)
+{
+    struct ether_arp request;
+    memset(&request, 0, sizeof(request));
+    request.arp_hrd = htons(ARPHRD_ETHER);
+    request.arp_pro = htons(ETHERTYPE_IP);
+    request.arp_hln = ETH_ALEN;
+    request.arp_pln = 4;
+    request.arp_op = htons(ARPOP_REQUEST);
+    memcpy(request.arp_sha, interface.macAddress.constData(), ETH_ALEN);
+    qToBigEndian<quint32>(interface.address, request.arp_spa);
+    qToBigEndian<quint32>(target, request.arp_tpa);
+
+    struct sockaddr_ll destination;
+    memset(&destination, 0, sizeof(destination));
+    destination.sll_family = AF_PACKET;
+    destination.sll_protocol = htons(ETH_P_ARP);
+    destination.sll_ifindex = interface.index;
+    destination.sll_halen = ETH_ALEN;
+    memset(destination.sll_addr, 0xff, ETH_ALEN);
+
+    if (sendto(m_socket, &request, sizeof(request), 0, reinterpret_cast<struct sockaddr *>(&destination), sizeof(destination)) < 0) {
+        return errno != EAGAIN && errno != EWOULDBLOCK;
+    }
+    return true;
+}
+
+void ArpProber::sendQueued()
+{
+    for (int i = 0; i < sendBatchSize && !m_sendQueue.isEmpty(); i++) {
+        quint32 target = m_sendQueue.head();
+        const Interface *interface = interfaceFor(target);
+        if (interface && !sendRequest(*interface, target)) {
+            // Socket buffer is full, try again on the next tick
+            return;
+        }
+        m_sendQueue.dequeue();
+    }
+
+    if (m_sendQueue.isEmpty()) {
+        m_sendTimer.stop();
+        if (m_scanning) {
+            m_scanTimer.start();
+        }
+    }
+}
+
+void ArpProber::retransmitProbes()
+{
+    QHash<quint32, int>::iterator it = m_pendingProbes.begin();
+    while (it != m_pendingProbes.end()) {
+        it.value()--;
+        if (it.value() > 0) {
+            m_sendQueue.enqueue(it.key());
+            ++it;
+            continue;
+        }
+
+        QHostAddress address(it.key());
+        it = m_pendingProbes.erase(it);
+        emit probeFinished(address, QString());
+    }
+
+    if (m_pendingProbes.isEmpty()) {
+        m_probeTimer.stop();
+    }
+    if (!m_sendQueue.isEmpty() && !m_sendTimer.isActive()) {
+        m_sendTimer.start();
+    }
+}
+
+void ArpProber::readReplies()
+{
+    struct ether_arp reply;
+    struct sockaddr_ll source;
+
+    forever {
+        socklen_t sourceLength = sizeof(source);
+        ssize_t received = recvfrom(m_socket, &reply, sizeof(reply), 0, reinterpret_cast<struct sockaddr *>(&source), &sourceLength);
+        if (received < 0) {
+            // Keep draining after a signal, otherwise queued replies wait for the next notification
+            if (errno == EINTR)
+                continue;
+
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                qCWarning(dcNetworkDetector()) << "Failed to read from ARP socket:" << strerror(errno);
+            }
+            return;
+        }
+
+        if (received < static_cast<ssize_t>(sizeof(reply)) || source.sll_pkttype == PACKET_OUTGOING)
+            continue;
+
+        if (ntohs(reply.arp_op) != ARPOP_REPLY || ntohs(reply.arp_hrd) != ARPHRD_ETHER || ntohs(reply.arp_pro) != ETHERTYPE_IP)
+            continue;
+
+        quint32 sender = qFromBigEndian<quint32>(reply.arp_spa);
+        QHostAddress address(sender);
+        QString macAddress = QByteArray(reinterpret_cast<const char *>(reply.arp_sha), ETH_ALEN).toHex(':');
+
+        emit replyReceived(address, macAddress);
+        if (m_pendingProbes.remove(sender) > 0) {
+            emit probeFinished(address, macAddress);
+        }
+    }
+}
@@ -0,0 +1,102 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef ARPPROBER_H
+#define ARPPROBER_H
+
+#include <QObject>
+#include <QHash>
+#include <QQueue>
+#include <QTimer>
+#include <QHostAddress>
+#include <QSocketNotifier>
+
+// Sends ARP requests from an AF_PACKET socket and matches the replies in the
+// event loop. Replaces spawning arping/fping for every probe.
+class ArpProber : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ArpProber(QObject *parent = nullptr);
+    ~ArpProber();
+
+    bool initialize();
+    bool initialized() const;
+
+    // Probe a single host once per second until it replies or the attempts are used up.
+    // Returns false if the address is not on any local network.
+    bool probe(const QHostAddress &address, int attempts = 30);
+
+    // Send one request to every host of all local IPv4 networks
+    void scanNetworks();
+
+signals:
+    void replyReceived(const QHostAddress &address, const QString &macAddress);
+    // macAddress is empty if the probe timed out
+    void probeFinished(const QHostAddress &address, const QString &macAddress);
+    void scanFinished();
+
+private:
+    class Interface {
+    public:
+        int index = 0;
+        QString name;
+        QByteArray macAddress;
+        quint32 address = 0;
+        quint32 netmask = 0;
+        int prefixLength = 0;
+    };
+
+    int m_socket = -1;
+    QSocketNotifier *m_notifier = nullptr;
+    QList<Interface> m_interfaces;
+
+    // Rate limited send queue of target addresses
+    QQueue<quint32> m_sendQueue;
+    QTimer m_sendTimer;
+
+    QHash<quint32, int> m_pendingProbes;
+    QTimer m_probeTimer;
+
+    bool m_scanning = false;
+    QTimer m_scanTimer;
+
+    void updateInterfaces();
+    const Interface *interfaceFor(quint32 address) const;
+    bool sendRequest(const Interface &interface, quint32 target);
+
+private slots:
+    void sendQueued();
+    void retransmitProbes();
+    void readReplies();
+
+};
+
+#endif // ARPPROBER_H
@@ -34,13 +34,21 @@
 #include <QNetworkInterface>
 #include <QProcess>
 
-BroadcastPing::BroadcastPing(QObject *parent) : QObject(parent)
+BroadcastPing::BroadcastPing(ArpProber *arpProber, QObject *parent) :
+    QObject(parent),
+    m_arpProber(arpProber)
 {
-
+    connect(m_arpProber, &ArpProber::scanFinished, this, &BroadcastPing::finished);
 }
 
 void BroadcastPing::run()
 {
+    if (m_arpProber->initialized()) {
+        m_arpProber->scanNetworks();
+        return;
+    }
+
+    // Fall back to fping if we're not allowed to open a packet socket
     qDeleteAll(m_runningPings.keys());
     m_runningPings.clear();
 
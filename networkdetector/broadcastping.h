@@ -36,11 +36,13 @@
 #include <QProcess>
 #include <QNetworkAddressEntry>
 
+#include "arpprober.h"
+
 class BroadcastPing : public QObject
 {
     Q_OBJECT
 public:
-    explicit BroadcastPing(QObject *parent = nullptr);
+    explicit BroadcastPing(ArpProber *arpProber, QObject *parent = nullptr);
 
 signals:
     void finished();
@@ -52,6 +54,7 @@ private slots:
     void broadcastPingFinished(int exitCode);
 
 private:
+    ArpProber *m_arpProber = nullptr;
     QHash<QProcess*, QNetworkAddressEntry> m_runningPings;
 };
 
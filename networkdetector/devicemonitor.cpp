@@ -32,31 +32,15 @@
 
 #include "extern-plugininfo.h"
 
-#include <QNetworkInterface>
-
-DeviceMonitor::DeviceMonitor(const QString &name, const QString &macAddress, const QString &ipAddress, bool initialState, QObject *parent):
+DeviceMonitor::DeviceMonitor(NeighbourCache *neighbourCache, ArpProber *arpProber, const QString &name, const QString &macAddress, const QString &ipAddress, bool initialState, QObject *parent):
     QObject(parent),
+    m_neighbourCache(neighbourCache),
+    m_arpProber(arpProber),
     m_name(name),
     m_macAddress(macAddress),
     m_ipAddress(ipAddress),
     m_reachable(initialState)
 {
-    m_arpLookupProcess = new QProcess(this);
-    connect(m_arpLookupProcess, SIGNAL(finished(int)), this, SLOT(arpLookupFinished(int)));
-
-    m_arpingProcess = new QProcess(this);
-    m_arpingProcess->setProcessChannelMode(QProcess::MergedChannels);
-#if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
-    // Actually we'd need this fix on older platforms too, but it's hard to figure this out without this API...
-    connect(m_arpingProcess, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
-        if (error == QProcess::FailedToStart) {
-            warn(QString("arping process failed to start. Falling back to ping. This plugin might not work properly on this system."));
-            ping();
-        }
-    });
-#endif
-    connect(m_arpingProcess, SIGNAL(finished(int)), this, SLOT(arpingFinished(int)));
-
     m_pingProcess = new QProcess(this);
     m_pingProcess->setProcessChannelMode(QProcess::MergedChannels);
     connect(m_pingProcess, SIGNAL(finished(int)), this, SLOT(pingFinished(int)));
@@ -72,81 +56,95 @@ void DeviceMonitor::setGracePeriod(int minutes)
     m_gracePeriod = minutes;
 }
 
+QString DeviceMonitor::macAddress() const
+{
+    return m_macAddress;
+}
+
 void DeviceMonitor::update()
 {
-    if (m_arpingProcess->state() != QProcess::NotRunning || m_pingProcess->state() != QProcess::NotRunning) {
+    if (m_probing || m_pingProcess->state() != QProcess::NotRunning) {
 //        log("Previous ping still running. Not updating.");
         return;
     }
-    lookupArpCache();
+    // Already answered the ARP scan of this cycle
+    if (m_lastSeenTime.isValid() && m_lastSeenTime.secsTo(QDateTime::currentDateTime()) < 10) {
+        return;
+    }
+    lookupNeighbourCache();
+}
+
+void DeviceMonitor::neighbourChanged(const NeighbourCache::Entry &entry)
+{
+    // Presence changes are pushed by the kernel, no need to wait for the next update cycle
+    if (entry.reachable()) {
+        log("Neighbour entry changed to REACHABLE (Cache IP: " + entry.ipAddress + ")");
+        setSeen(entry.ipAddress);
+    }
 }
 
-void DeviceMonitor::lookupArpCache()
+void DeviceMonitor::arpReplyReceived(const QString &ipAddress)
 {
-    m_arpLookupProcess->start("ip", {"-4", "-s", "neighbor", "list"});
+    log("ARP reply received (IP: " + ipAddress + ")");
+    setSeen(ipAddress);
 }
 
-void DeviceMonitor::arpLookupFinished(int exitCode)
+void DeviceMonitor::arpProbeFinished(const QString &ipAddress, const QString &macAddress)
 {
-    if (exitCode != 0) {
-        warn("Error looking up ARP cache.");
+    if (!m_probing || ipAddress != m_probeAddress) {
+        return;
+    }
+    m_probing = false;
+
+    if (macAddress.compare(m_macAddress, Qt::CaseInsensitive) == 0) {
+        // The reply has been handled in arpReplyReceived() already
+        log("ARP Ping successful.");
         return;
     }
 
-    QString data = QString::fromLatin1(m_arpLookupProcess->readAll());
+    if (!macAddress.isEmpty()) {
+        log("ARP Ping answered by a different device (" + macAddress + ").");
+    }
+    log("ARP Ping failed.");
+    checkGracePeriod();
+}
+
+void DeviceMonitor::lookupNeighbourCache()
+{
     bool found = false;
     bool needsPing = true;
     QString mostRecentIP = m_ipAddress;
-    qlonglong secsSinceLastSeen = -1;
-    foreach (QString line, data.split('\n')) {
-        line.replace(QRegExp("[ ]{1,}"), " ");
-        QStringList parts = line.split(" ");
-        int lladdrIndex = parts.indexOf("lladdr");
-        if (lladdrIndex == -1 || parts.count() <= lladdrIndex) {
-            continue;
+    qint64 secsSinceLastSeen = -1;
+    foreach (const NeighbourCache::Entry &entry, m_neighbourCache->entries(m_macAddress)) {
+        found = true;
+        if (entry.reachable()) {
+            log("Device found in ARP cache and claims to be REACHABLE (Cache IP: " + entry.ipAddress + ")");
+            setSeen(entry.ipAddress);
+            mostRecentIP = entry.ipAddress;
+            // If we have a reachable entry, stop processing here
+            needsPing = false;
+            break;
         }
-        QString entryIP = parts.first();
-        QString entryMAC = parts.at(lladdrIndex + 1);
-
-        if (entryMAC.toLower() == m_macAddress.toLower()) {
-            found = true;
-            QString entryIP = parts.first();
-            if (parts.last() == "REACHABLE") {
-                log("Device found in ARP cache and claims to be REACHABLE (Cache IP: " + entryIP + ")");
-                if (!m_reachable) {
-                    m_reachable = true;
-                    emit reachableChanged(true);
-                }
-                emit seen();
-                m_lastSeenTime = QDateTime::currentDateTime();
-                // Verify if IP address is still the same
-                if (entryIP != mostRecentIP) {
-                    mostRecentIP = entryIP;
-                }
-                // If we have a reachable entry, stop processing here
-                needsPing = false;
-                break;
-            } else {
-                // ARP claims the thing to be stale... Flagging thing to require a ping.
-                log("Device found in ARP cache but is marked as " + parts.last() + " (Cache IP: " + entryIP + ")");
 
-                int usedIndex = parts.indexOf("used");
-                if (usedIndex >= 0 && parts.count() > usedIndex + 1) {
-                    QString usedFields = parts.at(usedIndex + 1);
-                    qlonglong newSecsSinceLastSeen = usedFields.split("/").first().toInt();
-                    if (secsSinceLastSeen == -1 || newSecsSinceLastSeen < secsSinceLastSeen) {
-                        secsSinceLastSeen = newSecsSinceLastSeen;
-                        mostRecentIP = entryIP;
-                    }
-                }
-            }
-        } else if (entryIP == m_ipAddress) {
-            warn("There seems to be a thing with our IP but different MAC. Resetting IP config.");
-            if (mostRecentIP == m_ipAddress) {
-                mostRecentIP.clear();
+        // ARP claims the thing to be stale... Flagging thing to require a ping.
+        log("Device found in ARP cache but is marked as " + entry.stateName() + " (Cache IP: " + entry.ipAddress + ")");
+        if (entry.lastUsed.isValid()) {
+            qint64 newSecsSinceLastSeen = entry.lastUsed.secsTo(QDateTime::currentDateTime());
+            if (secsSinceLastSeen == -1 || newSecsSinceLastSeen < secsSinceLastSeen) {
+                secsSinceLastSeen = newSecsSinceLastSeen;
+                mostRecentIP = entry.ipAddress;
             }
         }
     }
+
+    QString ipOwner = m_neighbourCache->macAddress(m_ipAddress);
+    if (!ipOwner.isEmpty() && ipOwner != m_macAddress.toLower()) {
+        warn("There seems to be a thing with our IP but different MAC. Resetting IP config.");
+        if (mostRecentIP == m_ipAddress) {
+            mostRecentIP.clear();
+        }
+    }
+
     if (mostRecentIP != m_ipAddress) {
         log("Device has changed IP: " + m_ipAddress + " -> " + mostRecentIP + ")");
         m_ipAddress = mostRecentIP;
@@ -168,19 +166,30 @@ void DeviceMonitor::arpLookupFinished(int exitCode)
     }
 }
 
+void DeviceMonitor::setSeen(const QString &ipAddress)
+{
+    if (!m_reachable) {
+        m_reachable = true;
+        emit reachableChanged(true);
+    }
+    emit seen();
+    m_lastSeenTime = QDateTime::currentDateTime();
+
+    if (!ipAddress.isEmpty() && ipAddress != m_ipAddress) {
+        log("Device has changed IP: " + m_ipAddress + " -> " + ipAddress + ")");
+        m_ipAddress = ipAddress;
+        emit addressChanged(ipAddress);
+    }
+}
+
 void DeviceMonitor::arping()
 {
-    QNetworkInterface targetInterface;
-    foreach (const QNetworkInterface &interface, QNetworkInterface::allInterfaces()) {
-        foreach (const QNetworkAddressEntry &addressEntry, interface.addressEntries()) {
-            QHostAddress clientAddress(m_ipAddress);
-            if (clientAddress.isInSubnet(addressEntry.ip(), addressEntry.prefixLength())) {
-                targetInterface = interface;
-                break;
-            }
-        }
+    if (!m_arpProber->initialized()) {
+        ping();
+        return;
     }
-    if (!targetInterface.isValid()) {
+
+    if (!m_arpProber->probe(QHostAddress(m_ipAddress))) {
         warn("Could not find a suitable interface to ARP Ping.");
         if (m_reachable) {
             m_reachable = false;
@@ -190,28 +199,8 @@ void DeviceMonitor::arping()
     }
 
     log("Sending ARP Ping to " + m_ipAddress + "...");
-    m_arpingProcess->start("arping", {"-I", targetInterface.name(), "-f", "-w", "30", m_ipAddress});
-}
-
-void DeviceMonitor::arpingFinished(int exitCode)
-{
-    if (exitCode == 0) {
-        // we were able to ping the thing
-        log("ARP Ping successful.");
-        if (!m_reachable) {
-            m_reachable = true;
-            emit reachableChanged(true);
-        }
-        emit seen();
-        m_lastSeenTime = QDateTime::currentDateTime();
-    } else {
-        log("ARP Ping failed.");
-        ping();
-    }
-    // read data to discard it from socket
-    QString data = QString::fromLatin1(m_arpingProcess->readAll());
-    Q_UNUSED(data)
-//    qCDebug(dcNetworkDetector()) << "have ping data" << data;
+    m_probing = true;
+    m_probeAddress = m_ipAddress;
 }
 
 void DeviceMonitor::ping()
@@ -233,12 +222,8 @@ void DeviceMonitor::pingFinished(int exitCode)
         emit seen();
         m_lastSeenTime = QDateTime::currentDateTime();
     } else {
-        log("ICMP Ping failed. Last seen: " + m_lastSeenTime.toString() + ", grace period: " + QString::number(m_gracePeriod) + " (until " + m_lastSeenTime.addSecs(60 * m_gracePeriod).toString() + ")");
-        if (m_reachable && m_lastSeenTime.addSecs(m_gracePeriod * 60) < QDateTime::currentDateTime()) {
-            log("Exceeded grace period of " + QString::number(m_gracePeriod) + " minutes. Marking thing as offline.");
-            m_reachable = false;
-            emit reachableChanged(false);
-        }
+        log("ICMP Ping failed.");
+        checkGracePeriod();
     }
     // read data to discard it from socket
     QString data = QString::fromLatin1(m_pingProcess->readAll());
@@ -246,6 +231,16 @@ void DeviceMonitor::pingFinished(int exitCode)
 //    qCDebug(dcNetworkDetector()) << "have ping data" << data;
 }
 
+void DeviceMonitor::checkGracePeriod()
+{
+    log("Last seen: " + m_lastSeenTime.toString() + ", grace period: " + QString::number(m_gracePeriod) + " (until " + m_lastSeenTime.addSecs(60 * m_gracePeriod).toString() + ")");
+    if (m_reachable && m_lastSeenTime.addSecs(m_gracePeriod * 60) < QDateTime::currentDateTime()) {
+        log("Exceeded grace period of " + QString::number(m_gracePeriod) + " minutes. Marking thing as offline.");
+        m_reachable = false;
+        emit reachableChanged(false);
+    }
+}
+
 void DeviceMonitor::log(const QString &message)
 {
     qCDebug(dcNetworkDetector()).noquote().nospace() << m_name << " (" << m_macAddress  << ", " << m_ipAddress << "): " << message;
@@ -35,37 +35,51 @@
 #include <QProcess>
 #include <QDateTime>
 
+#include "neighbourcache.h"
+#include "arpprober.h"
+
 class DeviceMonitor : public QObject
 {
     Q_OBJECT
 public:
-    explicit DeviceMonitor(const QString &name, const QString &macAddress, const QString &ipAddress, bool initialState, QObject *parent = nullptr);
+    explicit DeviceMonitor(NeighbourCache *neighbourCache, ArpProber *arpProber, const QString &name, const QString &macAddress, const QString &ipAddress, bool initialState, QObject *parent = nullptr);
 
     ~DeviceMonitor();
 
     void setGracePeriod(int minutes);
 
+    QString macAddress() const;
+
     void update();
 
+    // Called for every change of a neighbour table entry with our MAC address
+    void neighbourChanged(const NeighbourCache::Entry &entry);
+
+    // Called for every ARP reply from our MAC address and for every finished ARP probe
+    void arpReplyReceived(const QString &ipAddress);
+    void arpProbeFinished(const QString &ipAddress, const QString &macAddress);
+
 signals:
     void addressChanged(const QString &address);
     void reachableChanged(bool reachable);
     void seen();
 
 private:
-    void lookupArpCache();
+    void lookupNeighbourCache();
+    void setSeen(const QString &ipAddress);
     void arping();
     void ping();
+    void checkGracePeriod();
 
     void log(const QString &message);
     void warn(const QString &message);
 
 private slots:
-    void arpLookupFinished(int exitCode);
-    void arpingFinished(int exitCode);
     void pingFinished(int exitCode);
 
 private:
+    NeighbourCache *m_neighbourCache = nullptr;
+    ArpProber *m_arpProber = nullptr;
     QString m_name;
     QString m_macAddress;
     QString m_ipAddress;
@@ -74,8 +88,8 @@ private:
     bool m_reachable = false;
     int m_gracePeriod = 5;
 
-    QProcess *m_arpLookupProcess = nullptr;
-    QProcess *m_arpingProcess = nullptr;
+    bool m_probing = false;
+    QString m_probeAddress;
     QProcess *m_pingProcess = nullptr;
 };
 
@@ -38,8 +38,16 @@
 
 IntegrationPluginNetworkDetector::IntegrationPluginNetworkDetector()
 {
-    m_broadcastPing = new BroadcastPing(this);
+    m_arpProber = new ArpProber(this);
+    connect(m_arpProber, &ArpProber::replyReceived, this, &IntegrationPluginNetworkDetector::arpReplyReceived);
+    connect(m_arpProber, &ArpProber::probeFinished, this, &IntegrationPluginNetworkDetector::arpProbeFinished);
+
+    m_broadcastPing = new BroadcastPing(m_arpProber, this);
     connect(m_broadcastPing, &BroadcastPing::finished, this, &IntegrationPluginNetworkDetector::broadcastPingFinished);
+
+    m_neighbourCache = new NeighbourCache(this);
+    connect(m_neighbourCache, &NeighbourCache::refreshFinished, this, &IntegrationPluginNetworkDetector::neighbourCacheRefreshed);
+    connect(m_neighbourCache, &NeighbourCache::entryChanged, this, &IntegrationPluginNetworkDetector::neighbourEntryChanged);
 }
 
 IntegrationPluginNetworkDetector::~IntegrationPluginNetworkDetector()
@@ -48,13 +56,21 @@ IntegrationPluginNetworkDetector::~IntegrationPluginNetworkDetector()
 
 void IntegrationPluginNetworkDetector::init()
 {
+    if (!m_neighbourCache->initialize()) {
+        qCWarning(dcNetworkDetector()) << "Unable to watch the neighbour table. Network devices will only be detected by pinging them.";
+    }
+    if (!m_arpProber->initialize()) {
+        qCWarning(dcNetworkDetector()) << "Unable to send ARP requests. Falling back to fping and ping.";
+    }
 }
 
 void IntegrationPluginNetworkDetector::setupThing(ThingSetupInfo *info)
 {
     Thing *thing = info->thing();
     qCDebug(dcNetworkDetector()) << "Setup" << thing->name() << thing->params();
-    DeviceMonitor *monitor = new DeviceMonitor(thing->name(),
+    DeviceMonitor *monitor = new DeviceMonitor(m_neighbourCache,
+                                               m_arpProber,
+                                               thing->name(),
                                                thing->paramValue(networkDeviceThingMacAddressParamTypeId).toString(),
                                                thing->paramValue(networkDeviceThingAddressParamTypeId).toString(),
                                                thing->stateValue(networkDeviceIsPresentStateTypeId).toBool(),
@@ -64,6 +80,7 @@ void IntegrationPluginNetworkDetector::setupThing(ThingSetupInfo *info)
     connect(monitor, &DeviceMonitor::seen, this, &IntegrationPluginNetworkDetector::deviceSeen);
     monitor->setGracePeriod(thing->setting(networkDeviceSettingsGracePeriodParamTypeId).toInt());
     m_monitors.insert(monitor, thing);
+    m_monitorsByMac.insert(monitor->macAddress().toLower(), monitor);
 
     connect(thing, &Thing::settingChanged, this, [this, thing](const ParamTypeId &paramTypeId, const QVariant &value){
         if (paramTypeId != networkDeviceSettingsGracePeriodParamTypeId) {
@@ -121,6 +138,9 @@ void IntegrationPluginNetworkDetector::thingRemoved(Thing *thing)
 {
     DeviceMonitor *monitor = m_monitors.key(thing);
     m_monitors.remove(monitor);
+    if (monitor) {
+        m_monitorsByMac.remove(monitor->macAddress().toLower(), monitor);
+    }
     delete monitor;
 
     if (m_monitors.isEmpty()) {
@@ -131,12 +151,39 @@ void IntegrationPluginNetworkDetector::thingRemoved(Thing *thing)
 }
 
 void IntegrationPluginNetworkDetector::broadcastPingFinished()
+{
+    // Resync the neighbour table once per cycle in case we missed notifications
+    m_neighbourCache->refresh();
+}
+
+void IntegrationPluginNetworkDetector::neighbourCacheRefreshed()
 {
     foreach (DeviceMonitor *monitor, m_monitors.keys()) {
         monitor->update();
     }
 }
 
+void IntegrationPluginNetworkDetector::neighbourEntryChanged(const NeighbourCache::Entry &entry)
+{
+    foreach (DeviceMonitor *monitor, m_monitorsByMac.values(entry.macAddress)) {
+        monitor->neighbourChanged(entry);
+    }
+}
+
+void IntegrationPluginNetworkDetector::arpReplyReceived(const QHostAddress &address, const QString &macAddress)
+{
+    foreach (DeviceMonitor *monitor, m_monitorsByMac.values(macAddress)) {
+        monitor->arpReplyReceived(address.toString());
+    }
+}
+
+void IntegrationPluginNetworkDetector::arpProbeFinished(const QHostAddress &address, const QString &macAddress)
+{
+    foreach (DeviceMonitor *monitor, m_monitors.keys()) {
+        monitor->arpProbeFinished(address.toString(), macAddress);
+    }
+}
+
 void IntegrationPluginNetworkDetector::deviceReachableChanged(bool reachable)
 {
     DeviceMonitor *monitor = static_cast<DeviceMonitor*>(sender());
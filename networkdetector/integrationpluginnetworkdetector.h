@@ -37,6 +37,8 @@
 #include "plugintimer.h"
 #include "devicemonitor.h"
 #include "broadcastping.h"
+#include "neighbourcache.h"
+#include "arpprober.h"
 
 #include <QProcess>
 #include <QXmlStreamReader>
@@ -66,11 +68,18 @@ private slots:
     void deviceSeen();
 
     void broadcastPingFinished();
+    void neighbourCacheRefreshed();
+    void neighbourEntryChanged(const NeighbourCache::Entry &entry);
+    void arpReplyReceived(const QHostAddress &address, const QString &macAddress);
+    void arpProbeFinished(const QHostAddress &address, const QString &macAddress);
 
 private:
     PluginTimer *m_pluginTimer = nullptr;
     BroadcastPing *m_broadcastPing = nullptr;
+    NeighbourCache *m_neighbourCache = nullptr;
+    ArpProber *m_arpProber = nullptr;
     QHash<DeviceMonitor*, Thing*> m_monitors;
+    QMultiHash<QString, DeviceMonitor*> m_monitorsByMac;
 };
 
 #endif // INTEGRATIONPLUGINNETWORKDETECTOR_H
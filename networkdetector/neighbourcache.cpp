@@ -0,0 +1,308 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "neighbourcache.h"
+#include "extern-plugininfo.h"
+
+#include <QHostAddress>
+#include <QtEndian>
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/neighbour.h>
+
+bool NeighbourCache::Entry::reachable() const
+{
+    return state & NUD_REACHABLE;
+}
+
+QString NeighbourCache::Entry::stateName() const
+{
+    switch (state) {
+    case NUD_INCOMPLETE: return "INCOMPLETE";
+    case NUD_REACHABLE: return "REACHABLE";
+    case NUD_STALE: return "STALE";
+    case NUD_DELAY: return "DELAY";
+    case NUD_PROBE: return "PROBE";
+    case NUD_FAILED: return "FAILED";
+    case NUD_NOARP: return "NOARP";
+    case NUD_PERMANENT: return "PERMANENT";
+    default: return "NONE";
+    }
+}
+
+NeighbourCache::NeighbourCache(QObject *parent) : QObject(parent)
+{
+    // The cache info times are reported in user clock ticks
+    long clockTicks = sysconf(_SC_CLK_TCK);
+    if (clockTicks > 0) {
+        m_clockTicks = clockTicks;
+    }
+
+    // Don't block refreshes forever if the end of a dump gets lost
+    m_refreshTimeoutTimer = new QTimer(this);
+    m_refreshTimeoutTimer->setSingleShot(true);
+    m_refreshTimeoutTimer->setInterval(5000);
+    connect(m_refreshTimeoutTimer, &QTimer::timeout, this, &NeighbourCache::onRefreshTimeout);
+}
+
+NeighbourCache::~NeighbourCache()
+{
+    if (m_socket >= 0) {
+        close(m_socket);
+    }
+}
+
+bool NeighbourCache::initialize()
+{
+    if (m_socket >= 0)
+        return true;
+
+    m_socket = socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (m_socket < 0) {
+        qCWarning(dcNetworkDetector()) << "Could not create netlink socket:" << strerror(errno);
+        return false;
+    }
+
+    struct sockaddr_nl address;
+    memset(&address, 0, sizeof(address));
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = RTMGRP_NEIGH;
+    if (bind(m_socket, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) < 0) {
+        qCWarning(dcNetworkDetector()) << "Could not bind netlink socket:" << strerror(errno);
+        close(m_socket);
+        m_socket = -1;
+        return false;
+    }
+
+    m_notifier = new QSocketNotifier(m_socket, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &NeighbourCache::readMessages);
+
+    qCDebug(dcNetworkDetector()) << "Neighbour cache initialized.";
+    refresh();
+    return true;
+}
+
+bool NeighbourCache::initialized() const
+{
+    return m_socket >= 0;
+}
+
+void NeighbourCache::refresh()
+{
+    if (m_socket < 0) {
+        emit refreshFinished();
+        return;
+    }
+
+    // Only one dump can be running at a time on a netlink socket
+    if (m_refreshing)
+        return;
+
+    struct {
+        struct nlmsghdr header;
+        struct ndmsg message;
+    } request;
+
+    memset(&request, 0, sizeof(request));
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(struct ndmsg));
+    request.header.nlmsg_type = RTM_GETNEIGH;
+    request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.header.nlmsg_seq = ++m_sequence;
+    request.message.ndm_family = AF_INET;
+
+    if (send(m_socket, &request, request.header.nlmsg_len, 0) < 0) {
+        qCWarning(dcNetworkDetector()) << "Could not request neighbour table:" << strerror(errno);
+        emit refreshFinished();
+        return;
+    }
+
+    m_refreshing = true;
+    m_seenAddresses.clear();
+    m_refreshTimeoutTimer->start();
+}
+
+QList<NeighbourCache::Entry> NeighbourCache::entries(const QString &macAddress) const
+{
+    QList<Entry> entries;
+    foreach (const QString &ipAddress, m_addresses.values(macAddress.toLower())) {
+        entries.append(m_entries.value(ipAddress));
+    }
+
+    return entries;
+}
+
+QString NeighbourCache::macAddress(const QString &ipAddress) const
+{
+    return m_entries.value(ipAddress).macAddress;
+}
+
+void NeighbourCache::processMessage(const void *message, int length, bool deleted)
+{
+    const struct ndmsg *neighbourMessage = static_cast<const struct ndmsg *>(message);
+    if (neighbourMessage->ndm_family != AF_INET)
+        return;
+
+    Entry entry;
+    entry.interfaceIndex = neighbourMessage->ndm_ifindex;
+    entry.state = neighbourMessage->ndm_state;
+
+    int attributesLength = length - static_cast<int>(NLMSG_ALIGN(sizeof(struct ndmsg)));
+    const struct rtattr *attribute = reinterpret_cast<const struct rtattr *>(reinterpret_cast<const char *>(neighbourMessage) + NLMSG_ALIGN(sizeof(struct ndmsg)));
+    for (; RTA_OK(attribute, attributesLength); attribute = RTA_NEXT(attribute, attributesLength)) {
+        const uchar *data = reinterpret_cast<const uchar *>(RTA_DATA(attribute));
+        switch (attribute->rta_type) {
+        case NDA_DST:
+            if (RTA_PAYLOAD(attribute) == 4)
+                entry.ipAddress = QHostAddress(qFromBigEndian<quint32>(data)).toString();
+
+            break;
+        case NDA_LLADDR:
+            entry.macAddress = QByteArray(reinterpret_cast<const char *>(data), static_cast<int>(RTA_PAYLOAD(attribute))).toHex(':');
+            break;
+        case NDA_CACHEINFO:
+            if (RTA_PAYLOAD(attribute) >= static_cast<int>(sizeof(struct nda_cacheinfo))) {
+                const struct nda_cacheinfo *cacheInfo = reinterpret_cast<const struct nda_cacheinfo *>(data);
+                entry.lastUsed = QDateTime::currentDateTime().addMSecs(-static_cast<qint64>(cacheInfo->ndm_used) * 1000 / m_clockTicks);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (entry.ipAddress.isEmpty())
+        return;
+
+    // Entries without link layer address (i.e. INCOMPLETE or FAILED) can not be assigned to a device
+    if (deleted || entry.macAddress.isEmpty()) {
+        removeEntry(entry.ipAddress);
+        return;
+    }
+
+    if (m_refreshing)
+        m_seenAddresses.insert(entry.ipAddress);
+
+    Entry previousEntry = m_entries.value(entry.ipAddress);
+    if (previousEntry.macAddress != entry.macAddress) {
+        removeEntry(entry.ipAddress);
+        m_addresses.insert(entry.macAddress, entry.ipAddress);
+    }
+    m_entries.insert(entry.ipAddress, entry);
+
+    if (previousEntry.macAddress != entry.macAddress || previousEntry.state != entry.state) {
+        emit entryChanged(entry);
+    }
+}
+
+void NeighbourCache::removeEntry(const QString &ipAddress)
+{
+    if (!m_entries.contains(ipAddress))
+        return;
+
+    Entry entry = m_entries.take(ipAddress);
+    m_addresses.remove(entry.macAddress, ipAddress);
+}
+
+void NeighbourCache::readMessages()
+{
+    // Note: aligned for the netlink message headers
+    static const int bufferSize = 32768;
+    alignas(struct nlmsghdr) char buffer[bufferSize];
+
+    forever {
+        ssize_t received = recv(m_socket, buffer, bufferSize, 0);
+        if (received < 0) {
+            if (errno == EINTR)
+                continue;
+
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return;
+
+            if (errno == ENOBUFS) {
+                // We missed notifications, resync the whole table
+                qCWarning(dcNetworkDetector()) << "Neighbour notifications overrun. Refreshing the whole table.";
+                m_refreshing = false;
+                m_refreshTimeoutTimer->stop();
+                refresh();
+                return;
+            }
+
+            qCWarning(dcNetworkDetector()) << "Failed to read from netlink socket:" << strerror(errno);
+            return;
+        }
+
+        int length = static_cast<int>(received);
+        for (const struct nlmsghdr *header = reinterpret_cast<const struct nlmsghdr *>(buffer); NLMSG_OK(header, length); header = NLMSG_NEXT(header, length)) {
+            switch (header->nlmsg_type) {
+            case NLMSG_DONE:
+            case NLMSG_ERROR:
+                if (m_refreshing && header->nlmsg_seq == m_sequence) {
+                    m_refreshing = false;
+                    m_refreshTimeoutTimer->stop();
+
+                    // Neighbours deleted while notifications got lost are not part of a complete dump
+                    if (header->nlmsg_type == NLMSG_DONE) {
+                        foreach (const QString &ipAddress, m_entries.keys()) {
+                            if (!m_seenAddresses.contains(ipAddress)) {
+                                qCDebug(dcNetworkDetector()) << "Neighbour" << ipAddress << "is gone from the table.";
+                                removeEntry(ipAddress);
+                            }
+                        }
+                    }
+                    m_seenAddresses.clear();
+                    emit refreshFinished();
+                }
+                break;
+            case RTM_NEWNEIGH:
+            case RTM_DELNEIGH:
+                if (header->nlmsg_len >= NLMSG_LENGTH(sizeof(struct ndmsg))) {
+                    processMessage(NLMSG_DATA(header), static_cast<int>(header->nlmsg_len - NLMSG_HDRLEN), header->nlmsg_type == RTM_DELNEIGH);
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+void NeighbourCache::onRefreshTimeout()
+{
+    // Note: the dump is incomplete, so no entries are dropped here
+    qCWarning(dcNetworkDetector()) << "Neighbour table dump timed out.";
+    m_refreshing = false;
+    m_seenAddresses.clear();
+    emit refreshFinished();
+}
@@ -0,0 +1,98 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef NEIGHBOURCACHE_H
+#define NEIGHBOURCACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QDateTime>
+#include <QSocketNotifier>
+#include <QTimer>
+
+// Mirror of the kernel IPv4 neighbour (ARP) table, kept up to date using a
+// rtnetlink subscription. Replaces parsing the output of "ip neighbor list".
+class NeighbourCache : public QObject
+{
+    Q_OBJECT
+public:
+    class Entry {
+    public:
+        QString ipAddress;
+        QString macAddress;
+        int interfaceIndex = 0;
+        quint16 state = 0;
+        QDateTime lastUsed;
+
+        bool reachable() const;
+        QString stateName() const;
+    };
+
+    explicit NeighbourCache(QObject *parent = nullptr);
+    ~NeighbourCache();
+
+    bool initialize();
+    bool initialized() const;
+
+    // Request a full dump of the table, refreshFinished() will be emitted once done
+    void refresh();
+
+    QList<Entry> entries(const QString &macAddress) const;
+    QString macAddress(const QString &ipAddress) const;
+
+signals:
+    void entryChanged(const NeighbourCache::Entry &entry);
+    void refreshFinished();
+
+private:
+    int m_socket = -1;
+    QSocketNotifier *m_notifier = nullptr;
+    quint32 m_sequence = 0;
+    bool m_refreshing = false;
+    QTimer *m_refreshTimeoutTimer = nullptr;
+    long m_clockTicks = 100;
+
+    QHash<QString, Entry> m_entries;
+    QMultiHash<QString, QString> m_addresses;
+
+    // Addresses reported while a dump is running, everything else gets dropped once it is complete
+    QSet<QString> m_seenAddresses;
+
+    void processMessage(const void *message, int length, bool deleted);
+    void removeEntry(const QString &ipAddress);
+
+private slots:
+    void readMessages();
+    void onRefreshTimeout();
+
+};
+
+#endif // NEIGHBOURCACHE_H
@@ -9,13 +9,17 @@ SOURCES += \
     host.cpp \
     discovery.cpp \
     devicemonitor.cpp \
-    broadcastping.cpp
+    neighbourcache.cpp \
+    broadcastping.cpp \
+    arpprober.cpp
 
 HEADERS += \
     integrationpluginnetworkdetector.h \
     host.h \
     discovery.h \
     devicemonitor.h \
-    broadcastping.h
+    neighbourcache.h \
+    broadcastping.h \
+    arpprober.h
 
 
@@ -0,0 +1,187 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "hueeventstream.h"
+#include "huebridge.h"
+#include "extern-plugininfo.h"
+
+#include <QJsonDocument>
+#include <QJsonParseError>
+
+HueEventStream::HueEventStream(NetworkAccessManager *networkManager, HueBridge *bridge, QObject *parent) :
+    QObject(parent),
+    m_networkManager(networkManager),
+    m_bridge(bridge)
+{
+    m_reconnectTimer.setSingleShot(true);
+    connect(&m_reconnectTimer, &QTimer::timeout, this, &HueEventStream::start);
+}
+
+HueEventStream::~HueEventStream()
+{
+    stop();
+}
+
+bool HueEventStream::connected() const
+{
+    return m_connected;
+}
+
+void HueEventStream::start()
+{
+    m_running = true;
+    if (m_reply)
+        return;
+
+    // Note: the event stream is only available through the CLIP v2 API, which requires https
+    QNetworkRequest request(QUrl("https://" + m_bridge->hostAddress().toString() + "/eventstream/clip/v2"));
+    request.setRawHeader("hue-application-key", m_bridge->apiKey().toUtf8());
+    request.setRawHeader("Accept", "text/event-stream");
+
+    qCDebug(dcPhilipsHue()) << "Connecting to event stream of bridge" << m_bridge->hostAddress().toString();
+    m_buffer.clear();
+    m_reply = m_networkManager->get(request);
+    // The bridge uses a self signed certificate
+    connect(m_reply, &QNetworkReply::sslErrors, m_reply, [this](){ m_reply->ignoreSslErrors(); });
+    connect(m_reply, &QNetworkReply::readyRead, this, &HueEventStream::onReadyRead);
+    connect(m_reply, &QNetworkReply::finished, this, &HueEventStream::onFinished);
+}
+
+void HueEventStream::stop()
+{
+    m_running = false;
+    m_reconnectTimer.stop();
+    if (m_reply) {
+        QNetworkReply *reply = m_reply;
+        m_reply = nullptr;
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
+    }
+
+    setConnected(false);
+}
+
+void HueEventStream::setConnected(bool connected)
+{
+    if (m_connected == connected)
+        return;
+
+    qCDebug(dcPhilipsHue()) << "Event stream of bridge" << m_bridge->hostAddress().toString() << (connected ? "connected" : "disconnected");
+    m_connected = connected;
+    emit connectedChanged(m_connected);
+}
+
+void HueEventStream::processEvent(const QByteArray &eventData)
+{
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(eventData, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qCWarning(dcPhilipsHue()) << "Failed to parse event stream data:" << error.errorString() << eventData;
+        return;
+    }
+
+    // One message can contain several events, each containing several resource updates
+    foreach (const QVariant &eventVariant, jsonDoc.toVariant().toList()) {
+        QVariantMap event = eventVariant.toMap();
+        if (event.value("type").toString() != "update")
+            continue;
+
+        foreach (const QVariant &dataVariant, event.value("data").toList()) {
+            QVariantMap data = dataVariant.toMap();
+            QString resource = data.value("id_v1").toString();
+            if (resource.isEmpty())
+                continue;
+
+            emit resourceUpdated(data.value("type").toString(), resource, data);
+        }
+    }
+}
+
+void HueEventStream::onReadyRead()
+{
+    int status = m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status != 200) {
+        qCWarning(dcPhilipsHue()) << "Event stream of bridge" << m_bridge->hostAddress().toString() << "returned HTTP status" << status;
+        m_reply->abort();
+        return;
+    }
+
+    setConnected(true);
+    m_reconnectInterval = 5000;
+
+    QByteArray data = m_reply->readAll();
+    data.replace("\r", "");
+    m_buffer.append(data);
+
+    // Events are separated by an empty line and may arrive in several chunks
+    int index = m_buffer.indexOf("\n\n");
+    while (index >= 0) {
+        QByteArray eventData;
+        foreach (const QByteArray &line, m_buffer.left(index).split('\n')) {
+            if (line.startsWith("data:")) {
+                if (!eventData.isEmpty())
+                    eventData.append('\n');
+
+                eventData.append(line.mid(5).trimmed());
+            }
+        }
+
+        m_buffer.remove(0, index + 2);
+        if (!eventData.isEmpty())
+            processEvent(eventData);
+
+        index = m_buffer.indexOf("\n\n");
+    }
+
+    // Note: events are small, an incomplete event this size means the stream is broken
+    static const int maxBufferSize = 1024 * 1024;
+    if (m_buffer.size() > maxBufferSize) {
+        qCWarning(dcPhilipsHue()) << "Event stream of bridge" << m_bridge->hostAddress().toString() << "exceeded" << maxBufferSize << "bytes without an event. Reconnecting.";
+        m_buffer.clear();
+        m_reply->abort();
+    }
+}
+
+void HueEventStream::onFinished()
+{
+    qCDebug(dcPhilipsHue()) << "Event stream of bridge" << m_bridge->hostAddress().toString() << "finished" << m_reply->errorString();
+    m_reply->deleteLater();
+    m_reply = nullptr;
+    setConnected(false);
+
+    if (!m_running)
+        return;
+
+    // Reconnect with backoff, bridges without CLIP v2 support will keep using the polling only
+    qCDebug(dcPhilipsHue()) << "Reconnecting event stream in" << m_reconnectInterval / 1000 << "seconds";
+    m_reconnectTimer.start(m_reconnectInterval);
+    m_reconnectInterval = qMin(m_reconnectInterval * 2, 300000);
+}
@@ -0,0 +1,80 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HUEEVENTSTREAM_H
+#define HUEEVENTSTREAM_H
+
+#include <QObject>
+#include <QTimer>
+#include <QVariantMap>
+#include <QNetworkReply>
+
+#include "network/networkaccessmanager.h"
+
+class HueBridge;
+
+// Long living connection to the CLIP v2 event stream of a bridge. Resource
+// updates are emitted with their v1 resource path (i.e. "/lights/3").
+class HueEventStream : public QObject
+{
+    Q_OBJECT
+public:
+    explicit HueEventStream(NetworkAccessManager *networkManager, HueBridge *bridge, QObject *parent = nullptr);
+    ~HueEventStream();
+
+    bool connected() const;
+
+    void start();
+    void stop();
+
+signals:
+    void connectedChanged(bool connected);
+    void resourceUpdated(const QString &type, const QString &resource, const QVariantMap &data);
+
+private:
+    NetworkAccessManager *m_networkManager = nullptr;
+    HueBridge *m_bridge = nullptr;
+    QNetworkReply *m_reply = nullptr;
+    QByteArray m_buffer;
+    QTimer m_reconnectTimer;
+    int m_reconnectInterval = 5000;
+    bool m_connected = false;
+    bool m_running = false;
+
+    void setConnected(bool connected);
+    void processEvent(const QByteArray &eventData);
+
+private slots:
+    void onReadyRead();
+    void onFinished();
+
+};
+
+#endif // HUEEVENTSTREAM_H
@@ -172,6 +172,30 @@ void HueLight::updateStates(const QVariantMap &statesMap)
     emit stateChanged();
 }
 
+void HueLight::processEventData(const QVariantMap &eventData)
+{
+    // Event stream (CLIP v2) updates contain only the changed properties
+    if (eventData.contains("on")) {
+        setPower(eventData.value("on").toMap().value("on").toBool());
+    }
+
+    // Brightness is given in percent, v1 uses 1 - 254
+    if (eventData.contains("dimming")) {
+        double brightness = eventData.value("dimming").toMap().value("brightness").toDouble();
+        setBrigtness(static_cast<quint8>(qRound(brightness * 254 / 100.0)));
+    }
+
+    if (eventData.contains("color_temperature")) {
+        QVariantMap colorTemperatureMap = eventData.value("color_temperature").toMap();
+        if (colorTemperatureMap.value("mirek_valid", true).toBool() && !colorTemperatureMap.value("mirek").isNull()) {
+            setCt(colorTemperatureMap.value("mirek").toUInt());
+            setColorMode(ColorModeCT);
+        }
+    }
+
+    emit stateChanged();
+}
+
 void HueLight::processActionResponse(const QVariantList &responseList)
 {
     foreach (const QVariant &resultVariant, responseList) {
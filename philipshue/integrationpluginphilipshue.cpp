@@ -55,22 +55,27 @@ IntegrationPluginPhilipsHue::~IntegrationPluginPhilipsHue()
     hardwareManager()->pluginTimerManager()->unregisterTimer(m_pluginTimer1Sec);
     hardwareManager()->pluginTimerManager()->unregisterTimer(m_pluginTimer5Sec);
     hardwareManager()->pluginTimerManager()->unregisterTimer(m_pluginTimer15Sec);
+    hardwareManager()->pluginTimerManager()->unregisterTimer(m_pluginTimer60Sec);
 }
 
 void IntegrationPluginPhilipsHue::init()
 {
     m_pluginTimer1Sec = hardwareManager()->pluginTimerManager()->registerTimer(1);
     connect(m_pluginTimer1Sec, &PluginTimer::timeout, this, [this]() {
-        // refresh sensors every second
+        // refresh sensors every second, bridges with a connected event stream push their changes
         foreach (HueBridge *bridge, m_bridges.keys()) {
-            refreshSensors(bridge);
+            if (!eventStreamConnected(bridge)) {
+                refreshSensors(bridge);
+            }
         }
     });
     m_pluginTimer5Sec = hardwareManager()->pluginTimerManager()->registerTimer(5);
     connect(m_pluginTimer5Sec, &PluginTimer::timeout, this, [this]() {
-        // refresh lights every 5 seconds
+        // refresh lights every 5 seconds, bridges with a connected event stream push their changes
         foreach (HueBridge *bridge, m_bridges.keys()) {
-            refreshLights(bridge);
+            if (!eventStreamConnected(bridge)) {
+                refreshLights(bridge);
+            }
         }
     });
     m_pluginTimer15Sec = hardwareManager()->pluginTimerManager()->registerTimer(15);
@@ -80,6 +85,16 @@ void IntegrationPluginPhilipsHue::init()
             refreshBridge(thing);
         }
     });
+    m_pluginTimer60Sec = hardwareManager()->pluginTimerManager()->registerTimer(60);
+    connect(m_pluginTimer60Sec, &PluginTimer::timeout, this, [this]() {
+        // reconcile the pushed states of bridges with a connected event stream every minute
+        foreach (HueBridge *bridge, m_bridges.keys()) {
+            if (eventStreamConnected(bridge)) {
+                refreshLights(bridge);
+                refreshSensors(bridge);
+            }
+        }
+    });
 
     m_zeroConfBrowser = hardwareManager()->zeroConfController()->createServiceBrowser("_hue._tcp");
     connect(m_zeroConfBrowser, &ZeroConfServiceBrowser::serviceEntryAdded, this, [=](const ZeroConfServiceEntry &entry){
@@ -346,6 +361,15 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
             bridge->setHostAddress(QHostAddress(host));
         }
         discoverBridgeDevices(bridge);
+
+        HueEventStream *eventStream = m_eventStreams.value(bridge);
+        if (!eventStream) {
+            eventStream = new HueEventStream(hardwareManager()->networkManager(), bridge, bridge);
+            connect(eventStream, &HueEventStream::resourceUpdated, this, &IntegrationPluginPhilipsHue::onEventStreamResourceUpdated);
+            m_eventStreams.insert(bridge, eventStream);
+        }
+        eventStream->start();
+
         return info->finish(Thing::ThingErrorNoError);
     }
 
@@ -368,7 +392,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
         hueLight->setType(thing->paramValue(colorLightThingTypeParamTypeId).toString());
 
         connect(hueLight, &HueLight::stateChanged, this, &IntegrationPluginPhilipsHue::lightStateChanged);
-        m_lights.insert(hueLight, thing);
+        registerLight(hueLight, thing);
 
         refreshLight(thing);
 
@@ -386,7 +410,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
         hueLight->setType(thing->paramValue(colorTemperatureLightThingTypeParamTypeId).toString());
 
         connect(hueLight, &HueLight::stateChanged, this, &IntegrationPluginPhilipsHue::lightStateChanged);
-        m_lights.insert(hueLight, thing);
+        registerLight(hueLight, thing);
 
         refreshLight(thing);
 
@@ -430,7 +454,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
 
         connect(hueLight, &HueLight::stateChanged, this, &IntegrationPluginPhilipsHue::lightStateChanged);
 
-        m_lights.insert(hueLight, thing);
+        registerLight(hueLight, thing);
         refreshLight(thing);
 
         return info->finish(Thing::ThingErrorNoError);
@@ -449,7 +473,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
 
         connect(hueLight, &HueLight::stateChanged, this, &IntegrationPluginPhilipsHue::lightStateChanged);
 
-        m_lights.insert(hueLight, thing);
+        registerLight(hueLight, thing);
         refreshLight(thing);
 
         return info->finish(Thing::ThingErrorNoError);
@@ -493,7 +517,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
         connect(hueRemote, &HueRemote::stateChanged, this, &IntegrationPluginPhilipsHue::remoteStateChanged);
         connect(hueRemote, &HueRemote::buttonPressed, this, &IntegrationPluginPhilipsHue::onRemoteButtonEvent);
 
-        m_remotes.insert(hueRemote, thing);
+        registerRemote(hueRemote, thing);
         return info->finish(Thing::ThingErrorNoError);
     }
 
@@ -511,7 +535,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
         connect(hueDimmerSwitch2, &HueRemote::stateChanged, this, &IntegrationPluginPhilipsHue::remoteStateChanged);
         connect(hueDimmerSwitch2, &HueRemote::buttonPressed, this, &IntegrationPluginPhilipsHue::onRemoteButtonEvent);
 
-        m_remotes.insert(hueDimmerSwitch2, thing);
+        registerRemote(hueDimmerSwitch2, thing);
         return info->finish(Thing::ThingErrorNoError);
     }
 
@@ -526,7 +550,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
         connect(hueTap, &HueRemote::stateChanged, this, &IntegrationPluginPhilipsHue::remoteStateChanged);
         connect(hueTap, &HueRemote::buttonPressed, this, &IntegrationPluginPhilipsHue::onRemoteButtonEvent);
 
-        m_remotes.insert(hueTap, thing);
+        registerRemote(hueTap, thing);
         return info->finish(Thing::ThingErrorNoError);
     }
 
@@ -541,7 +565,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
         connect(hueFoh, &HueRemote::stateChanged, this, &IntegrationPluginPhilipsHue::remoteStateChanged);
         connect(hueFoh, &HueRemote::buttonPressed, this, &IntegrationPluginPhilipsHue::onRemoteButtonEvent);
 
-        m_remotes.insert(hueFoh, thing);
+        registerRemote(hueFoh, thing);
         return info->finish(Thing::ThingErrorNoError);
     }
 
@@ -556,7 +580,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
         connect(smartButton, &HueRemote::stateChanged, this, &IntegrationPluginPhilipsHue::remoteStateChanged);
         connect(smartButton, &HueRemote::buttonPressed, this, &IntegrationPluginPhilipsHue::onRemoteButtonEvent);
 
-        m_remotes.insert(smartButton, thing);
+        registerRemote(smartButton, thing);
         return info->finish(Thing::ThingErrorNoError);
     }
 
@@ -571,7 +595,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
         connect(wallSwitch, &HueRemote::stateChanged, this, &IntegrationPluginPhilipsHue::remoteStateChanged);
         connect(wallSwitch, &HueRemote::buttonPressed, this, &IntegrationPluginPhilipsHue::onRemoteButtonEvent);
 
-        m_remotes.insert(wallSwitch, thing);
+        registerRemote(wallSwitch, thing);
         return info->finish(Thing::ThingErrorNoError);
     }
 
@@ -602,7 +626,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
             }
         });
 
-        m_motionSensors.insert(motionSensor, thing);
+        registerMotionSensor(motionSensor, thing);
 
         return info->finish(Thing::ThingErrorNoError);
     }
@@ -634,7 +658,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
             }
         });
 
-        m_motionSensors.insert(outdoorSensor, thing);
+        registerMotionSensor(outdoorSensor, thing);
 
         return info->finish(Thing::ThingErrorNoError);
     }
@@ -652,7 +676,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
             thing->setStateValue(smartPlugConnectedStateTypeId, reachable);
         });
         connect(smartPlug, &HueLight::stateChanged, this, &IntegrationPluginPhilipsHue::lightStateChanged);
-        m_lights.insert(smartPlug, thing);
+        registerLight(smartPlug, thing);
         info->finish(Thing::ThingErrorNoError);
         return;
     }
@@ -667,6 +691,7 @@ void IntegrationPluginPhilipsHue::thingRemoved(Thing *thing)
     abortRequests(m_bridgeRefreshRequests, thing);
     abortRequests(m_lightsRefreshRequests, thing);
     abortRequests(m_sensorsRefreshRequests, thing);
+    abortRequests(m_sensorRefreshRequests, thing);
     abortRequests(m_bridgeLightsDiscoveryRequests, thing);
     abortRequests(m_bridgeSensorsDiscoveryRequests, thing);
     abortRequests(m_bridgeSearchDevicesRequests, thing);
@@ -675,6 +700,10 @@ void IntegrationPluginPhilipsHue::thingRemoved(Thing *thing)
         qCDebug(dcPhilipsHue()) << "Bridge removed" << thing->name();
         HueBridge *bridge = m_bridges.key(thing);
         m_bridges.remove(bridge);
+        HueEventStream *eventStream = m_eventStreams.take(bridge);
+        if (eventStream) {
+            eventStream->stop();
+        }
         bridge->deleteLater();
     }
 
@@ -685,18 +714,25 @@ void IntegrationPluginPhilipsHue::thingRemoved(Thing *thing)
             || thing->thingClassId() == smartPlugThingClassId) {
         HueLight *light = m_lights.key(thing);
         m_lights.remove(light);
+        if (m_lightsIndex.value(HueResourceKey(thing->parentId(), light->id())) == light)
+            m_lightsIndex.remove(HueResourceKey(thing->parentId(), light->id()));
+
         light->deleteLater();
     }
 
     if (thing->thingClassId() == remoteThingClassId || thing->thingClassId() == dimmerSwitch2ThingClassId|| thing->thingClassId() == tapThingClassId || thing->thingClassId() == fohThingClassId || thing->thingClassId() == smartButtonThingClassId || thing->thingClassId() == wallSwitchThingClassId) {
         HueRemote *remote = m_remotes.key(thing);
         m_remotes.remove(remote);
+        if (m_remotesIndex.value(HueResourceKey(thing->parentId(), remote->id())) == remote)
+            m_remotesIndex.remove(HueResourceKey(thing->parentId(), remote->id()));
+
         remote->deleteLater();
     }
 
     if (thing->thingClassId() == outdoorSensorThingClassId || thing->thingClassId() == motionSensorThingClassId) {
         HueMotionSensor *motionSensor = m_motionSensors.key(thing);
         m_motionSensors.remove(motionSensor);
+        unregisterMotionSensor(motionSensor, thing);
         motionSensor->deleteLater();
     }
 }
@@ -862,6 +898,16 @@ void IntegrationPluginPhilipsHue::networkManagerReplyReady()
         }
         processSensorsRefreshResponse(thing, reply->readAll());
 
+    } else if (m_sensorRefreshRequests.contains(reply)) {
+        Thing *thing = m_sensorRefreshRequests.take(reply);
+
+        // check HTTP status code
+        if (status != 200 || reply->error() != QNetworkReply::NoError) {
+            qCWarning(dcPhilipsHue) << "Refresh Hue sensor request error:" << status << reply->errorString();
+            return;
+        }
+        processSensorRefreshResponse(thing, reply->request().url().path().section('/', -1).toInt(), reply->readAll());
+
     } else if (m_setNameRequests.contains(reply)) {
         Thing *thing = m_setNameRequests.take(reply);
 
@@ -1428,6 +1474,98 @@ void IntegrationPluginPhilipsHue::onMotionSensorLightIntensityChanged(double lig
     sensorDevice->setStateValue(sensor->lightIntensityStateTypeId(), lightIntensity);
 }
 
+void IntegrationPluginPhilipsHue::registerLight(HueLight *light, Thing *thing)
+{
+    m_lights.insert(light, thing);
+    m_lightsIndex.insert(HueResourceKey(thing->parentId(), light->id()), light);
+}
+
+void IntegrationPluginPhilipsHue::registerRemote(HueRemote *remote, Thing *thing)
+{
+    m_remotes.insert(remote, thing);
+    m_remotesIndex.insert(HueResourceKey(thing->parentId(), remote->id()), remote);
+}
+
+void IntegrationPluginPhilipsHue::registerMotionSensor(HueMotionSensor *motionSensor, Thing *thing)
+{
+    m_motionSensors.insert(motionSensor, thing);
+    // A motion sensor consists of three sensor resources on the bridge
+    m_motionSensorsIndex.insert(HueResourceKey(thing->parentId(), motionSensor->temperatureSensorId()), motionSensor);
+    m_motionSensorsIndex.insert(HueResourceKey(thing->parentId(), motionSensor->presenceSensorId()), motionSensor);
+    m_motionSensorsIndex.insert(HueResourceKey(thing->parentId(), motionSensor->lightSensorId()), motionSensor);
+}
+
+void IntegrationPluginPhilipsHue::unregisterMotionSensor(HueMotionSensor *motionSensor, Thing *thing)
+{
+    QList<int> sensorIds = { motionSensor->temperatureSensorId(), motionSensor->presenceSensorId(), motionSensor->lightSensorId() };
+    foreach (int sensorId, sensorIds) {
+        HueResourceKey key(thing->parentId(), sensorId);
+        if (m_motionSensorsIndex.value(key) == motionSensor) {
+            m_motionSensorsIndex.remove(key);
+        }
+    }
+}
+
+void IntegrationPluginPhilipsHue::onEventStreamResourceUpdated(const QString &type, const QString &resource, const QVariantMap &data)
+{
+    HueEventStream *eventStream = static_cast<HueEventStream *>(sender());
+    HueBridge *bridge = m_eventStreams.key(eventStream);
+    Thing *bridgeThing = m_bridges.value(bridge);
+    if (!bridgeThing)
+        return;
+
+    // The resource is the v1 path of the updated resource, i.e. "/lights/3" or "/sensors/12"
+    QString collection = resource.section('/', 1, 1);
+    HueResourceKey key(bridgeThing->id(), resource.section('/', 2, 2).toInt());
+
+    if (collection == "lights") {
+        HueLight *light = m_lightsIndex.value(key);
+        if (!light || type != "light")
+            return;
+
+        light->processEventData(data);
+
+        // Colors are reported as xy only, fetch hue and saturation of this light
+        if (data.contains("color")) {
+            refreshLight(m_lights.value(light));
+        }
+        return;
+    }
+
+    if (collection != "sensors")
+        return;
+
+    HueMotionSensor *motionSensor = m_motionSensorsIndex.value(key);
+    if (motionSensor) {
+        // Map the event on a v1 sensor map containing only the changed value
+        QVariantMap sensorMap;
+        QVariantMap stateMap;
+        if (type == "motion") {
+            sensorMap.insert("uniqueid", motionSensor->presenceSensorUuid());
+            stateMap.insert("presence", data.value("motion").toMap().value("motion").toBool());
+        } else if (type == "temperature") {
+            sensorMap.insert("uniqueid", motionSensor->temperatureSensorUuid());
+            stateMap.insert("temperature", qRound(data.value("temperature").toMap().value("temperature").toDouble() * 100));
+        } else if (type == "light_level") {
+            sensorMap.insert("uniqueid", motionSensor->lightSensorUuid());
+            stateMap.insert("lightlevel", data.value("light").toMap().value("light_level").toInt());
+        } else {
+            // Battery and connectivity changes
+            refreshSensor(bridge, key.second);
+            return;
+        }
+
+        sensorMap.insert("state", stateMap);
+        motionSensor->updateStates(sensorMap);
+        return;
+    }
+
+    // Button events only tell which button changed, the v1 sensor contains the complete button code
+    if (m_remotesIndex.contains(key)) {
+        refreshSensor(bridge, key.second);
+    }
+}
+
 void IntegrationPluginPhilipsHue::refreshLight(Thing *thing)
 {
     HueLight *light = m_lights.key(thing);
@@ -1475,6 +1613,23 @@ void IntegrationPluginPhilipsHue::refreshSensors(HueBridge *bridge)
     m_sensorsRefreshRequests.insert(reply, thing);
 }
 
+void IntegrationPluginPhilipsHue::refreshSensor(HueBridge *bridge, int sensorId)
+{
+    Thing *thing = m_bridges.value(bridge);
+
+    QNetworkRequest request(QUrl("http://" + bridge->hostAddress().toString() + "/api/" + bridge->apiKey() + "/sensors/" + QString::number(sensorId)));
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    QNetworkReply *reply = hardwareManager()->networkManager()->get(request);
+    connect(reply, &QNetworkReply::finished, this, &IntegrationPluginPhilipsHue::networkManagerReplyReady);
+    m_sensorRefreshRequests.insert(reply, thing);
+}
+
+bool IntegrationPluginPhilipsHue::eventStreamConnected(HueBridge *bridge) const
+{
+    HueEventStream *eventStream = m_eventStreams.value(bridge);
+    return eventStream && eventStream->connected();
+}
+
 void IntegrationPluginPhilipsHue::discoverBridgeDevices(HueBridge *bridge)
 {
     Thing *thing = m_bridges.value(bridge);
@@ -2023,12 +2178,10 @@ void IntegrationPluginPhilipsHue::processLightsRefreshResponse(Thing *thing, con
     // Update light states
     QVariantMap lightsMap = jsonDoc.toVariant().toMap();
     foreach (const QString &lightId, lightsMap.keys()) {
-        QVariantMap lightMap = lightsMap.value(lightId).toMap();
         // get the light of this bridge
-        foreach (HueLight *light, m_lights.keys()) {
-            if (light->id() == lightId.toInt() && m_lights.value(light)->parentId() == thing->id()) {
-                light->updateStates(lightMap.value("state").toMap());
-            }
+        HueLight *light = m_lightsIndex.value(HueResourceKey(thing->id(), lightId.toInt()));
+        if (light) {
+            light->updateStates(lightsMap.value(lightId).toMap().value("state").toMap());
         }
     }
 }
@@ -2053,21 +2206,48 @@ void IntegrationPluginPhilipsHue::processSensorsRefreshResponse(Thing *thing, co
     // Update sensor states
     QVariantMap sensorsMap = jsonDoc.toVariant().toMap();
     foreach (const QString &sensorId, sensorsMap.keys()) {
-        QVariantMap sensorMap = sensorsMap.value(sensorId).toMap();
+        HueResourceKey key(thing->id(), sensorId.toInt());
+        if (!m_remotesIndex.contains(key) && !m_motionSensorsIndex.contains(key))
+            continue;
 
-        // Remotes
-        foreach (HueRemote *remote, m_remotes.keys()) {
-            if (remote->id() == sensorId.toInt() && m_remotes.value(remote)->parentId() == thing->id()) {
-                remote->updateStates(sensorMap.value("state").toMap(), sensorMap.value("config").toMap());
-            }
-        }
+        updateSensor(thing, sensorId.toInt(), sensorsMap.value(sensorId).toMap());
+    }
+}
 
-        // Motion sensors
-        foreach (HueMotionSensor *motionSensor, m_motionSensors.keys()) {
-            if (motionSensor->hasSensor(sensorId.toInt()) && m_motionSensors.value(motionSensor)->parentId() == thing->id()) {
-                motionSensor->updateStates(sensorMap);
-            }
-        }
+void IntegrationPluginPhilipsHue::processSensorRefreshResponse(Thing *thing, int sensorId, const QByteArray &data)
+{
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
+
+    // check JSON error
+    if (error.error != QJsonParseError::NoError) {
+        qCWarning(dcPhilipsHue) << "Hue Bridge json error in response" << error.errorString();
+        return;
+    }
+
+    // check response error
+    if (!jsonDoc.toVariant().toList().isEmpty()) {
+        qCWarning(dcPhilipsHue) << "Failed to refresh Hue Sensor:" << jsonDoc.toVariant().toList().first().toMap().value("error").toMap().value("description").toString();
+        return;
+    }
+
+    updateSensor(thing, sensorId, jsonDoc.toVariant().toMap());
+}
+
+void IntegrationPluginPhilipsHue::updateSensor(Thing *thing, int sensorId, const QVariantMap &sensorMap)
+{
+    HueResourceKey key(thing->id(), sensorId);
+
+    // Remotes
+    HueRemote *remote = m_remotesIndex.value(key);
+    if (remote) {
+        remote->updateStates(sensorMap.value("state").toMap(), sensorMap.value("config").toMap());
+    }
+
+    // Motion sensors
+    HueMotionSensor *motionSensor = m_motionSensorsIndex.value(key);
+    if (motionSensor) {
+        motionSensor->updateStates(sensorMap);
     }
 }
 
@@ -36,6 +36,7 @@
 #include "huelight.h"
 #include "hueremote.h"
 #include "huemotionsensor.h"
+#include "hueeventstream.h"
 
 #include "plugintimer.h"
 #include "network/networkaccessmanager.h"
@@ -81,6 +82,9 @@ private slots:
     void onMotionSensorPresenceChanged(bool presence);
     void onMotionSensorLightIntensityChanged(double lightIntensity);
 
+    // Event stream
+    void onEventStreamResourceUpdated(const QString &type, const QString &resource, const QVariantMap &data);
+
 private slots:
     void networkManagerReplyReady();
     void onDeviceNameChanged();
@@ -106,6 +110,7 @@ private:
     PluginTimer *m_pluginTimer1Sec = nullptr;
     PluginTimer *m_pluginTimer5Sec = nullptr;
     PluginTimer *m_pluginTimer15Sec = nullptr;
+    PluginTimer *m_pluginTimer60Sec = nullptr;
 
     QList<HueLight *> m_unconfiguredLights;
 
@@ -114,20 +119,35 @@ private:
     QHash<QNetworkReply *, Thing *> m_bridgeRefreshRequests;
     QHash<QNetworkReply *, Thing *> m_lightsRefreshRequests;
     QHash<QNetworkReply *, Thing *> m_sensorsRefreshRequests;
+    QHash<QNetworkReply *, Thing *> m_sensorRefreshRequests;
     QHash<QNetworkReply *, Thing *> m_bridgeLightsDiscoveryRequests;
     QHash<QNetworkReply *, Thing *> m_bridgeSensorsDiscoveryRequests;
     QHash<QNetworkReply *, Thing *> m_bridgeSearchDevicesRequests;
 
     QHash<HueBridge *, Thing *> m_bridges;
+    QHash<HueBridge *, HueEventStream *> m_eventStreams;
     QHash<HueLight *, Thing *> m_lights;
     QHash<HueRemote *, Thing *> m_remotes;
     QHash<HueMotionSensor *, Thing *> m_motionSensors;
 
+    // Lookup index for the refresh responses: (bridge thing id, resource id on the bridge)
+    typedef QPair<ThingId, int> HueResourceKey;
+    QHash<HueResourceKey, HueLight *> m_lightsIndex;
+    QHash<HueResourceKey, HueRemote *> m_remotesIndex;
+    QHash<HueResourceKey, HueMotionSensor *> m_motionSensorsIndex;
+
+    void registerLight(HueLight *light, Thing *thing);
+    void registerRemote(HueRemote *remote, Thing *thing);
+    void registerMotionSensor(HueMotionSensor *motionSensor, Thing *thing);
+    void unregisterMotionSensor(HueMotionSensor *motionSensor, Thing *thing);
+
     void refreshLight(Thing *thing);
     void refreshBridge(Thing *thing);
 
     void refreshLights(HueBridge *bridge);
     void refreshSensors(HueBridge *bridge);
+    void refreshSensor(HueBridge *bridge, int sensorId);
+    bool eventStreamConnected(HueBridge *bridge) const;
 
     void discoverBridgeDevices(HueBridge *bridge);
     void searchNewDevices(HueBridge *bridge, const QString &serialNumber);
@@ -141,6 +161,8 @@ private:
     void processBridgeRefreshResponse(Thing *thing, const QByteArray &data);
     void processLightsRefreshResponse(Thing *thing, const QByteArray &data);
     void processSensorsRefreshResponse(Thing *thing, const QByteArray &data);
+    void processSensorRefreshResponse(Thing *thing, int sensorId, const QByteArray &data);
+    void updateSensor(Thing *thing, int sensorId, const QVariantMap &sensorMap);
     void processSetNameResponse(Thing *thing, const QByteArray &data);
 
     void bridgeReachableChanged(Thing *thing, bool reachable);
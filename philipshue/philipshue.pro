@@ -9,6 +9,7 @@ SOURCES += \
     #huebridgeconnection.cpp \
     #light.cpp \
     huebridge.cpp \
+    hueeventstream.cpp \
     huelight.cpp \
     huemotionsensor.cpp \
     hueremote.cpp \
@@ -20,6 +21,7 @@ HEADERS += \
     #light.h \
     #lightinterface.h \
     huebridge.h \
+    hueeventstream.h \
     huelight.h \
     huemotionsensor.h \
     hueremote.h \
@@ -117,6 +117,19 @@ void IntegrationPluginSerialPortCommander::setupThing(ThingSetupInfo *info)
         connect(serialPort, SIGNAL(stopBitsChanged(QSerialPort::StopBits)), this, SLOT(onStopBitsChanged(QSerialPort::StopBits)));
         connect(serialPort, SIGNAL(flowControlChanged(QSerialPort::FlowControl)), this, SLOT(onFlowControlChanged(QSerialPort::FlowControl)));
         m_serialPorts.insert(thing, serialPort);
+
+        StreamFramer *framer = new StreamFramer(framingConfiguration(thing), serialPort);
+        connect(framer, &StreamFramer::frameReceived, thing, [=](const QByteArray &frame){
+            qDebug(dcSerialPortCommander()) << "Message received" << frame;
+
+            Event event(serialPortCommanderTriggeredEventTypeId, thing->id());
+            ParamList parameters;
+            parameters.append(Param(serialPortCommanderTriggeredEventInputDataParamTypeId, frame));
+            event.setParams(parameters);
+            emitEvent(event);
+        });
+        m_framers.insert(thing, framer);
+
         thing->setStateValue(serialPortCommanderConnectedStateTypeId, true);
     }
     return info->finish(Thing::ThingErrorNoError);
@@ -147,6 +160,7 @@ void IntegrationPluginSerialPortCommander::thingRemoved(Thing *thing)
     if (thing->thingClassId() == serialPortCommanderThingClassId) {
 
         QSerialPort *serialPort = m_serialPorts.take(thing);
+        m_framers.remove(thing);
         if (serialPort) {
             if (serialPort->isOpen()){
                 serialPort->flush();
@@ -167,17 +181,24 @@ void IntegrationPluginSerialPortCommander::onReadyRead()
     QSerialPort *serialPort =  static_cast<QSerialPort*>(sender());
     Thing *thing = m_serialPorts.key(serialPort);
 
-    QByteArray data;
-    while (!serialPort->atEnd()) {
-        data.append(serialPort->read(100));
-    }
-    qDebug(dcSerialPortCommander()) << "Message received" << data;
+    StreamFramer *framer = m_framers.value(thing);
+    if (!framer)
+        return;
 
-    Event event(serialPortCommanderTriggeredEventTypeId, thing->id());
-    ParamList parameters;
-    parameters.append(Param(serialPortCommanderTriggeredEventInputDataParamTypeId, data));
-    event.setParams(parameters);
-    emitEvent(event);
+    framer->addData(serialPort->readAll());
+}
+
+StreamFramer::Configuration IntegrationPluginSerialPortCommander::framingConfiguration(Thing *thing) const
+{
+    StreamFramer::Configuration configuration;
+    configuration.loggingCategory = dcSerialPortCommander;
+    configuration.mode = StreamFramer::modeFromString(thing->paramValue(serialPortCommanderThingFramingParamTypeId).toString());
+    configuration.delimiter = StreamFramer::decodeDelimiter(thing->paramValue(serialPortCommanderThingDelimiterParamTypeId).toString());
+    configuration.frameLength = thing->paramValue(serialPortCommanderThingFrameLengthParamTypeId).toInt();
+    configuration.lengthPrefixSize = thing->paramValue(serialPortCommanderThingLengthPrefixSizeParamTypeId).toInt();
+    configuration.idleTimeout = thing->paramValue(serialPortCommanderThingIdleTimeoutParamTypeId).toInt();
+    configuration.maximumFrameSize = thing->paramValue(serialPortCommanderThingMaxFrameSizeParamTypeId).toInt();
+    return configuration;
 }
 
 void IntegrationPluginSerialPortCommander::onSerialError(QSerialPort::SerialPortError error)
@@ -189,6 +210,9 @@ void IntegrationPluginSerialPortCommander::onSerialError(QSerialPort::SerialPort
         qCCritical(dcSerialPortCommander()) << "Serial port error:" << error << serialPort->errorString();
         m_reconnectTimer->start();
         serialPort->close();
+        if (m_framers.contains(thing))
+            m_framers.value(thing)->reset();
+
         thing->setStateValue(serialPortCommanderConnectedStateTypeId, false);
     }
 }
@@ -32,6 +32,7 @@
 #define INTEGRATIONPLUGINSERIALPORTCOMMANDER_H
 
 #include "integrations/integrationplugin.h"
+#include "streamframer.h"
 
 #include <QTimer>
 #include <QSerialPort>
@@ -55,6 +56,9 @@ public:
 private:
     QTimer *m_reconnectTimer = nullptr;
     QHash<Thing *, QSerialPort *> m_serialPorts;
+    QHash<Thing *, StreamFramer *> m_framers;
+
+    StreamFramer::Configuration framingConfiguration(Thing *thing) const;
 
 private slots:
     void onReadyRead();
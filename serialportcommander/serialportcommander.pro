@@ -1,4 +1,5 @@
 include(../plugins.pri)
+include(../common/streamframer.pri)
 
 QT += serialport
 
@@ -30,6 +30,7 @@
 
 #include "integrationpluginshelly.h"
 #include "plugininfo.h"
+#include "shellytopicrouter.h"
 
 #include <QUrlQuery>
 #include <QNetworkReply>
@@ -37,6 +38,8 @@
 #include <QJsonDocument>
 #include <QColor>
 
+#include <algorithm>
+
 #include "hardwaremanager.h"
 #include "network/networkaccessmanager.h"
 #include "network/mqtt/mqttprovider.h"
@@ -455,11 +458,18 @@ IntegrationPluginShelly::IntegrationPluginShelly()
 
 IntegrationPluginShelly::~IntegrationPluginShelly()
 {
+    qDeleteAll(m_topicRouters);
 }
 
 void IntegrationPluginShelly::init()
 {
     m_zeroconfBrowser = hardwareManager()->zeroConfController()->createServiceBrowser("_http._tcp");
+
+    m_coiotListener = new ShellyCoiotListener(this);
+    connect(m_coiotListener, &ShellyCoiotListener::statusReceived, this, &IntegrationPluginShelly::onCoiotStatusReceived);
+
+    connect(this, &IntegrationPluginShelly::configValueChanged, this, &IntegrationPluginShelly::onPluginConfigurationChanged);
+    onPluginConfigurationChanged(shellyPluginStatusSourceParamTypeId, configValue(shellyPluginStatusSourceParamTypeId));
 }
 
 void IntegrationPluginShelly::discoverThings(ThingDiscoveryInfo *info)
@@ -555,9 +565,7 @@ void IntegrationPluginShelly::postSetupThing(Thing *thing)
 
 void IntegrationPluginShelly::thingRemoved(Thing *thing)
 {
-    if (m_mqttChannels.contains(thing)) {
-        hardwareManager()->mqttProvider()->releaseChannel(m_mqttChannels.take(thing));
-    }
+    releaseMqttChannel(thing);
 
     if (myThings().isEmpty() && m_statusUpdateTimer) {
         hardwareManager()->pluginTimerManager()->unregisterTimer(m_statusUpdateTimer);
@@ -768,7 +776,7 @@ void IntegrationPluginShelly::executeAction(ThingActionInfo *info)
 
 void IntegrationPluginShelly::onClientConnected(MqttChannel *channel)
 {
-    Thing *thing = m_mqttChannels.key(channel);
+    Thing *thing = m_channelThings.value(channel);
     if (!thing) {
         qCWarning(dcShelly()) << "Received a client connect for a thing we don't know!";
         return;
@@ -783,7 +791,7 @@ void IntegrationPluginShelly::onClientConnected(MqttChannel *channel)
 
 void IntegrationPluginShelly::onClientDisconnected(MqttChannel *channel)
 {
-    Thing *thing = m_mqttChannels.key(channel);
+    Thing *thing = m_channelThings.value(channel);
     if (!thing) {
         qCWarning(dcShelly()) << "Received a client disconnect for a thing we don't know!";
         return;
@@ -798,7 +806,7 @@ void IntegrationPluginShelly::onClientDisconnected(MqttChannel *channel)
 
 void IntegrationPluginShelly::onPublishReceived(MqttChannel *channel, const QString &topic, const QByteArray &payload)
 {
-    Thing *thing = m_mqttChannels.key(channel);
+    Thing *thing = m_channelThings.value(channel);
     if (!thing) {
         qCWarning(dcShelly()) << "Received a publish message for a thing we don't know!";
         return;
@@ -806,447 +814,607 @@ void IntegrationPluginShelly::onPublishReceived(MqttChannel *channel, const QStr
 
     qCDebug(dcShelly()) << "Publish received from" << thing->name() << topic << payload;
 
-    QString shellyId = thing->paramValue(idParamTypeMap.value(thing->thingClassId())).toString();
-    if (topic == "shellies/" + shellyId + "/info") {
-        QJsonParseError error;
-        QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
-        if (error.error != QJsonParseError::NoError) {
-            qCWarning(dcShelly()) << "Failed to parse shelly info payload:" << error.errorString();
-            qCWarning(dcShelly()) << qUtf8Printable(payload);
-            return;
-        }
-        QVariantMap data = jsonDoc.toVariant().toMap();
-
-        // Wifi signal strength
-        int signalStrength = -1;
-        if (data.value("wifi_sta").toMap().contains("rssi")) {
-            int rssi = data.value("wifi_sta").toMap().value("rssi").toInt();
-            signalStrength = qMin(100, qMax(0, (rssi + 100) * 2));
-        }
-        thing->setStateValue(signalStrengthStateTypesMap.value(thing->thingClassId()), signalStrength);
-        foreach (Thing *child, myThings().filterByParentId(thing->id())) {
-            child->setStateValue(signalStrengthStateTypesMap.value(child->thingClassId()), signalStrength);
-        }
-
-        // Firmware update
-        QString updateStatus = updateStatusMap.value(data.value("update").toMap().value("status").toString());
-        thing->setStateValue(updateStatusStateTypesMap.value(thing->thingClassId()), updateStatus);
-        thing->setStateValue(currentVersionStateTypesMap.value(thing->thingClassId()), data.value("update").toMap().value("old_version").toString());
-        thing->setStateValue(availableVersionStateTypesMap.value(thing->thingClassId()), data.value("update").toMap().value("new_version").toString());
-
-        if (data.contains("longpush_duration_ms")) {
-            if (longpushMinDurationSettingIds.contains(thing->thingClassId())) {
-                thing->setSettingValue(longpushMinDurationSettingIds.value(thing->thingClassId()), data.value("longpush_duration_ms").toMap().value("min").toUInt());
-            }
-            foreach (Thing *child, myThings().filterByParentId(thing->id())) {
-                if (longpushMinDurationSettingIds.contains(child->thingClassId())) {
-                    thing->setSettingValue(longpushMinDurationSettingIds.value(thing->thingClassId()), data.value("longpush_duration_ms").toMap().value("min").toUInt());
-                }
-            }
-            if (longpushMaxDurationSettingIds.contains(thing->thingClassId())) {
-                thing->setSettingValue(longpushMaxDurationSettingIds.value(thing->thingClassId()), data.value("longpush_duration_ms").toMap().value("max").toUInt());
-            }
-            foreach (Thing *child, myThings().filterByParentId(thing->id())) {
-                if (longpushMaxDurationSettingIds.contains(child->thingClassId())) {
-                    thing->setSettingValue(longpushMaxDurationSettingIds.value(thing->thingClassId()), data.value("longpush_duration_ms").toMap().value("max").toUInt());
-                }
-            }
-        }
-        if (data.contains("multipush_time_between_pushes_ms")) {
-            if (multipushTimeBetweenPushesSettingIds.contains(thing->thingClassId())) {
-                thing->setSettingValue(multipushTimeBetweenPushesSettingIds.value(thing->thingClassId()), data.value("multipush_time_between_pushes_ms").toMap().value("max").toUInt());
-            }
-            foreach (Thing *child, myThings().filterByParentId(thing->id())) {
-                if (multipushTimeBetweenPushesSettingIds.contains(child->thingClassId())) {
-                    thing->setSettingValue(multipushTimeBetweenPushesSettingIds.value(thing->thingClassId()), data.value("multipush_time_between_pushes_ms").toMap().value("max").toUInt());
-                }
-            }
-        }
+    ShellyTopicRouter *router = m_topicRouters.value(thing);
+    if (!router || !router->route(topic, payload)) {
+        qCDebug(dcShelly()) << "Unhandled topic" << topic;
+    }
+}
 
+void IntegrationPluginShelly::onCoiotStatusReceived(const QString &deviceId, const QHostAddress &address, const QHash<int, QVariant> &values)
+{
+    Thing *thing = m_coiotThings.value(deviceId);
+    if (!thing) {
+        return;
+    }
 
-        // While we normally use the specific topics instead of the "info" object, the Shell H&T posts it very rarely
-        // and in combination with its power safe mode let's use this one to get temp/humidity
-        if (thing->thingClassId() == shellyHTThingClassId) {
-            if (data.value("tmp").toMap().value("is_valid").toBool()) {
-                thing->setStateValue(shellyHTTemperatureStateTypeId, data.value("tmp").toMap().value("tC").toDouble());
-            }
-            if (data.value("hum").toMap().value("is_valid").toBool()) {
-                thing->setStateValue(shellyHTHumidityStateTypeId, data.value("hum").toMap().value("value").toDouble());
-            }
+    // Anyone can send multicast packets claiming a device id. Only accept them from the address the thing is known at.
+    if (!m_coiotAddresses.value(thing).isEqual(address, QHostAddress::TolerantConversion)) {
+        m_coiotAddresses.insert(thing, getIP(thing));
+        if (!m_coiotAddresses.value(thing).isEqual(address, QHostAddress::TolerantConversion)) {
+            qCDebug(dcShelly()) << "Ignoring CoIoT packet for" << thing->name() << "from unexpected sender" << address;
+            return;
         }
     }
 
+    if (!m_coiotTopics.contains(thing)) {
+        fetchCoiotDescription(thing);
+        return;
+    }
 
-    if (topic.startsWith("shellies/" + shellyId + "/input/")) {
-        int channel = topic.split("/").last().toInt();
-        // "1" or "0"
-        // Emit event button pressed
-        bool on = payload == "1";
-        if (thing->thingClassId() == shellyI3ThingClassId) {
-            if (channel == 0) {
-                thing->setStateValue(shellyI3Input1StateTypeId, on);
-            } else if (channel == 1) {
-                thing->setStateValue(shellyI3Input2StateTypeId, on);
-            } else {
-                thing->setStateValue(shellyI3Input3StateTypeId, on);
-            }
-            return;
-        }
-        foreach (Thing *child, myThings().filterByParentId(thing->id())) {
-            if (child->thingClassId() == shellySwitchThingClassId && child->paramValue(shellySwitchThingChannelParamTypeId).toInt() == channel + 1) {
-                if (child->stateValue(shellySwitchPowerStateTypeId).toBool() != on) {
-                    child->setStateValue(shellySwitchPowerStateTypeId, on);
-                    emit emitEvent(Event(shellySwitchPressedEventTypeId, child->id()));
-                }
-            }
-        }
+    ShellyTopicRouter *router = m_topicRouters.value(thing);
+    ShellyCoiotListener::TopicMap topicMap = m_coiotTopics.value(thing);
+    if (!router || topicMap.isEmpty()) {
+        return;
     }
 
-    QRegExp topicMatcher = QRegExp("shellies/" + shellyId + "/relay/[0-1]");
-    if (topicMatcher.exactMatch(topic)) {
-        QStringList parts = topic.split("/");
-        int channel = parts.at(3).toInt();
-        bool on = payload == "on";
+    qCDebug(dcShelly()) << "CoIoT status received from" << thing->name() << values;
 
-        // If the shelly main thing has a power state (e.g. Shelly Plug)
-        if (powerStateTypeMap.contains(thing->thingClassId())) {
-            thing->setStateValue(powerStateTypeMap.value(thing->thingClassId()), on);
-        }
-        // If the shelly main thing has multiple channels (e.g. Shelly 2.5)
-        if (thing->thingClassId() == shelly25ThingClassId) {
-            QHash<int, StateTypeId> powerChannelStateTypesMap = {
-                {0, shelly25Channel1StateTypeId},
-                {1, shelly25Channel2StateTypeId}
-            };
-            thing->setStateValue(powerChannelStateTypesMap.value(channel), on);
+    // CoIoT sends all values in one packet. The EM totals are calculated on total_returned, which
+    // is the last value of a channel on MQTT, so route those only after all other values of the packet.
+    QList<int> ids = values.keys();
+    std::sort(ids.begin(), ids.end());
+    QList<int> deferredIds;
+    foreach (int id, ids) {
+        if (!topicMap.contains(id)) {
+            continue;
         }
-
-        // And switch all childs of this shelly too
-        foreach (Thing *child, myThings().filterByParentId(thing->id())) {
-            if (powerStateTypeMap.contains(child->thingClassId())) {
-                ParamTypeId channelParamTypeId = channelParamTypeMap.value(child->thingClassId());
-                if (child->paramValue(channelParamTypeId).toInt() == channel + 1) {
-                    child->setStateValue(powerStateTypeMap.value(child->thingClassId()), on);
-                }
-            }
+        if (topicMap.value(id).topic.endsWith("/total_returned")) {
+            deferredIds.append(id);
+            continue;
         }
+        ShellyCoiotListener::TopicMapping mapping = topicMap.value(id);
+        router->routeRelative(mapping.topic, ShellyCoiotListener::toPayload(mapping, values.value(id)));
+    }
+    foreach (int id, deferredIds) {
+        ShellyCoiotListener::TopicMapping mapping = topicMap.value(id);
+        router->routeRelative(mapping.topic, ShellyCoiotListener::toPayload(mapping, values.value(id)));
+    }
+}
 
+void IntegrationPluginShelly::onPluginConfigurationChanged(const ParamTypeId &paramTypeId, const QVariant &value)
+{
+    if (paramTypeId != shellyPluginStatusSourceParamTypeId) {
+        return;
     }
 
-    topicMatcher = QRegExp("shellies/" + shellyId + "/(relay|roller)/[0-1]/power");
-    if (topicMatcher.exactMatch(topic)) {
-        QStringList parts = topic.split("/");
-        int channel = parts.at(3).toInt();
-        double power = payload.toDouble();
-        // If this gateway thing supports power measuring (e.g. Shelly Plug S) set it directly here
-        if (currentPowerStateTypeMap.contains(thing->thingClassId())) {
-            thing->setStateValue(currentPowerStateTypeMap.value(thing->thingClassId()), power);
-        }
-        // For multi-channel devices, power measurements are per-channel, so, find the child thing
-        foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByInterface("extendedsmartmeterconsumer")) {
-            ParamTypeId channelParamTypeId = channelParamTypeMap.value(child->thingClassId());
-            if (child->paramValue(channelParamTypeId).toInt() == channel + 1) {
-                child->setStateValue(currentPowerStateTypeMap.value(child->thingClassId()), power);
-            }
-        }
+    if (value.toString() == "MQTT") {
+        m_coiotListener->disable();
+    } else {
+        m_coiotListener->enable();
     }
+}
 
-    topicMatcher = QRegExp("shellies/" + shellyId + "/(relay|roller)/[0-1]/energy");
-    if (topicMatcher.exactMatch(topic)) {
-        QStringList parts = topic.split("/");
-        int channel = parts.at(3).toInt();
-        // W/min => kW/h
-        double energy = payload.toDouble() / 1000 / 60;
-        // If this gateway thing supports energy measuring (e.g. Shelly Plug S) set it directly here
-        if (totalEnergyConsumedStateTypeMap.contains(thing->thingClassId())) {
-            thing->setStateValue(totalEnergyConsumedStateTypeMap.value(thing->thingClassId()), energy);
-        }
-        // For multi-channel devices, power measurements are per-channel, so, find the child thing
-        foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByInterface("extendedsmartmeterconsumer")) {
-            ParamTypeId channelParamTypeId = channelParamTypeMap.value(child->thingClassId());
-            if (child->paramValue(channelParamTypeId).toInt() == channel + 1) {
-                child->setStateValue(totalEnergyConsumedStateTypeMap.value(child->thingClassId()), energy);
-            }
-        }
+void IntegrationPluginShelly::setupTopicRouter(Thing *thing, const QString &shellyId)
+{
+    ShellyTopicRouter *router = new ShellyTopicRouter(shellyId);
+
+    router->addRoute("info", [this, thing](const QByteArray &payload){
+        handleInfo(thing, payload);
+    });
+    router->addRoute("status", [this, thing](const QByteArray &payload){
+        handleStatus(thing, payload);
+    });
+
+    for (int channel = 0; channel < 3; channel++) {
+        router->addRoute("input/" + QString::number(channel), [this, thing, channel](const QByteArray &payload){
+            handleInput(thing, channel, payload);
+        });
     }
 
-    if (topic == "shellies/" + shellyId + "/color/0") {
-        bool on = payload == "on";
-        if (powerStateTypeMap.contains(thing->thingClassId())) {
-            thing->setStateValue(powerStateTypeMap.value(thing->thingClassId()), on);
+    if (thing->thingClassId() == shellyButton1ThingClassId || thing->thingClassId() == shellyI3ThingClassId) {
+        for (int channel = 0; channel < 3; channel++) {
+            router->addRoute("input_event/" + QString::number(channel), [this, thing, channel](const QByteArray &payload){
+                handleInputEvent(thing, channel, payload);
+            });
         }
     }
 
-    if (topic == "shellies/" + shellyId + "/color/0/status") {
-        QJsonParseError error;
-        QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
-        if (error.error != QJsonParseError::NoError) {
-            qCWarning(dcShelly()) << "Error parsing JSON from Shelly:" << error.error << error.errorString() << payload;
-            return;
-        }
-        QVariantMap statusMap = jsonDoc.toVariant().toMap();
-        if (colorStateTypeMap.contains(thing->thingClassId())) {
-            QColor color = QColor(statusMap.value("red").toInt(), statusMap.value("green").toInt(), statusMap.value("blue").toInt());
-            thing->setStateValue(colorStateTypeMap.value(thing->thingClassId()), color);
-        }
-        if (brightnessStateTypeMap.contains(thing->thingClassId())) {
-            int brightness = statusMap.value("gain").toInt();
-            thing->setStateValue(brightnessStateTypeMap.value(thing->thingClassId()), brightness);
-        }
-        if (currentPowerStateTypeMap.contains(thing->thingClassId())) {
-            double power = statusMap.value("power").toDouble();
-            thing->setStateValue(currentPowerStateTypeMap.value(thing->thingClassId()), power);
+    for (int channel = 0; channel < 2; channel++) {
+        router->addRoute("relay/" + QString::number(channel), [this, thing, channel](const QByteArray &payload){
+            handleRelay(thing, channel, payload);
+        });
+        foreach (const QString &type, QStringList() << "relay" << "roller") {
+            QString prefix = type + "/" + QString::number(channel);
+            router->addRoute(prefix + "/power", [this, thing, channel](const QByteArray &payload){
+                handlePower(thing, channel, payload);
+            });
+            router->addRoute(prefix + "/energy", [this, thing, channel](const QByteArray &payload){
+                handleEnergy(thing, channel, payload);
+            });
         }
     }
 
-    if (topic == "shellies/" + shellyId + "/light/0") {
-        bool on = payload == "on";
+    router->addRoute("color/0", [thing](const QByteArray &payload){
         if (powerStateTypeMap.contains(thing->thingClassId())) {
-            thing->setStateValue(powerStateTypeMap.value(thing->thingClassId()), on);
+            thing->setStateValue(powerStateTypeMap.value(thing->thingClassId()), payload == "on");
         }
-    }
+    });
+    router->addRoute("color/0/status", [this, thing](const QByteArray &payload){
+        handleColorStatus(thing, payload);
+    });
 
-    if (topic == "shellies/" + shellyId + "/light/0/status") {
-        QJsonParseError error;
-        QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
-        if (error.error != QJsonParseError::NoError) {
-            qCWarning(dcShelly()) << "Error parsing JSON from Shelly:" << error.error << error.errorString() << payload;
-            return;
-        }
-        //        qCDebug(dcShelly()) << "Payload:" << qUtf8Printable(jsonDoc.toJson());
-        QVariantMap statusMap = jsonDoc.toVariant().toMap();
-        if (brightnessStateTypeMap.contains(thing->thingClassId())) {
-            int brightness = statusMap.value("brightness").toInt();
-            thing->setStateValue(brightnessStateTypeMap.value(thing->thingClassId()), brightness);
+    router->addRoute("light/0", [thing](const QByteArray &payload){
+        if (powerStateTypeMap.contains(thing->thingClassId())) {
+            thing->setStateValue(powerStateTypeMap.value(thing->thingClassId()), payload == "on");
         }
-    }
-
-    if (topic == "shellies/" + shellyId + "/light/0/power") {
-//        qCDebug(dcShelly()) << "Payload:" << payload;
+    });
+    router->addRoute("light/0/status", [this, thing](const QByteArray &payload){
+        handleLightStatus(thing, payload);
+    });
+    router->addRoute("light/0/power", [thing](const QByteArray &payload){
         if (currentPowerStateTypeMap.contains(thing->thingClassId())) {
-            double power = payload.toDouble();
-            thing->setStateValue(currentPowerStateTypeMap.value(thing->thingClassId()), power);
+            thing->setStateValue(currentPowerStateTypeMap.value(thing->thingClassId()), payload.toDouble());
         }
-    }
+    });
 
-    if (topic == "shellies/" + shellyId + "/roller/0") {
-        //        qCDebug(dcShelly()) << "Payload:" << payload;
-        // Roller shutters are always child devices...
+    // Roller shutters are always child devices...
+    router->addRoute("roller/0", [this, thing](const QByteArray &payload){
         foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByInterface("extendedshutter")) {
             child->setStateValue(shellyRollerMovingStateTypeId, payload != "stop");
         }
-    }
-    if (topic == "shellies/" + shellyId + "/roller/0/pos") {
-        //        qCDebug(dcShelly()) << "Payload:" << payload;
-        // Roller shutters are always child devices...
+    });
+    router->addRoute("roller/0/pos", [this, thing](const QByteArray &payload){
         int pos = payload.toInt();
         foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByInterface("extendedshutter")) {
             child->setStateValue(shellyRollerPercentageStateTypeId, 100 - pos);
         }
-    }
+    });
 
-    if (topic == "shellies/" + shellyId + "/sensor/battery") {
-        if (batteryLevelStateTypesMap.contains(thing->thingClassId())) {
+    if (batteryLevelStateTypesMap.contains(thing->thingClassId())) {
+        router->addRoute("sensor/battery", [thing](const QByteArray &payload){
             int batteryLevel = payload.toInt();
             thing->setStateValue(batteryLevelStateTypesMap.value(thing->thingClassId()), batteryLevel);
             thing->setStateValue(batteryCriticalStateTypesMap.value(thing->thingClassId()), batteryLevel < 10);
-        }
+        });
     }
 
-    if (topic.startsWith("shellies/" + shellyId + "/input_event/")) {
-        qCDebug(dcShelly()) << "Payload:" << payload;
-        if (thing->thingClassId() == shellyButton1ThingClassId) {  // it can be only at channel 0
-            QJsonParseError error;
-            QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
-            if (error.error != QJsonParseError::NoError) {
-                qCWarning(dcShelly()) << "Failed to parse JSON from shelly:" << error.errorString() << qUtf8Printable(payload);
-                return;
+    if (thing->thingClassId() == shellyEm3ThingClassId) {
+        QList<QHash<QString, StateTypeId>> phases = {
+            {
+                {"power", shellyEm3CurrentPowerPhaseAStateTypeId},
+                {"pf", shellyEm3PowerFactorPhaseAStateTypeId},
+                {"current", shellyEm3CurrentPhaseAStateTypeId},
+                {"voltage", shellyEm3VoltagePhaseAStateTypeId},
+                {"total", shellyEm3EnergyConsumedPhaseAStateTypeId},
+                {"total_returned", shellyEm3EnergyProducedPhaseAStateTypeId}
+            }, {
+                {"power", shellyEm3CurrentPowerPhaseBStateTypeId},
+                {"pf", shellyEm3PowerFactorPhaseBStateTypeId},
+                {"current", shellyEm3CurrentPhaseBStateTypeId},
+                {"voltage", shellyEm3VoltagePhaseBStateTypeId},
+                {"total", shellyEm3EnergyConsumedPhaseBStateTypeId},
+                {"total_returned", shellyEm3EnergyProducedPhaseBStateTypeId}
+            }, {
+                {"power", shellyEm3CurrentPowerPhaseCStateTypeId},
+                {"pf", shellyEm3PowerFactorPhaseCStateTypeId},
+                {"current", shellyEm3CurrentPhaseCStateTypeId},
+                {"voltage", shellyEm3VoltagePhaseCStateTypeId},
+                {"total", shellyEm3EnergyConsumedPhaseCStateTypeId},
+                {"total_returned", shellyEm3EnergyProducedPhaseCStateTypeId}
             }
-            QString event = jsonDoc.toVariant().toMap().value("event").toString();
-            if (event.isEmpty()) {
-                return;
+        };
+        for (int channel = 0; channel < phases.count(); channel++) {
+            foreach (const QString &stateName, phases.at(channel).keys()) {
+                StateTypeId stateTypeId = phases.at(channel).value(stateName);
+                double factor = stateName.startsWith("total") ? 0.001 : 1;
+                // We only refresh the totals when we get the last value for the last channel
+                bool lastValue = channel == 2 && stateName == "total_returned";
+                router->addRoute(QString("emeter/%1/%2").arg(channel).arg(stateName), [this, thing, stateTypeId, factor, lastValue](const QByteArray &payload){
+                    handleEm3Value(thing, stateTypeId, payload.toDouble() * factor, lastValue);
+                });
             }
-            EventTypeId eventTypeId = event == "L" ? shellyButton1LongPressedEventTypeId : shellyButton1PressedEventTypeId;
-            ParamTypeId paramTypeId = eventTypeId == shellyButton1PressedEventTypeId ? shellyButton1PressedEventButtonNameParamTypeId : shellyButton1LongPressedEventButtonNameParamTypeId;
-            QString param = QString::number(event.length());
-            thing->emitEvent(eventTypeId, ParamList() << Param(paramTypeId, param));
         }
-        if (thing->thingClassId() == shellyI3ThingClassId) {
-            int channel = topic.split("/").last().toInt();
-            QJsonParseError error;
-            QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
-            if (error.error != QJsonParseError::NoError) {
-                qCWarning(dcShelly()) << "Failed to parse JSON from shelly:" << error.errorString() << qUtf8Printable(payload);
-                return;
-            }
+    }
 
-            QString buttonName = QString::number(channel + 1);
-            QString event = jsonDoc.toVariant().toMap().value("event").toString();
-            if (event == "S") {
-                thing->emitEvent(shellyI3PressedEventTypeId, ParamList() << Param(shellyI3PressedEventButtonNameParamTypeId, buttonName) << Param(shellyI3PressedEventCountParamTypeId, 1));
-            } else if (event == "L") {
-                thing->emitEvent(shellyI3LongPressedEventTypeId, ParamList() << Param(shellyI3LongPressedEventButtonNameParamTypeId, buttonName));
-            } else if (event == "SS") {
-                thing->emitEvent(shellyI3PressedEventTypeId, ParamList() << Param(shellyI3PressedEventButtonNameParamTypeId, buttonName) << Param(shellyI3PressedEventCountParamTypeId, 2));
-            } else if (event == "SSS") {
-                thing->emitEvent(shellyI3PressedEventTypeId, ParamList() << Param(shellyI3PressedEventButtonNameParamTypeId, buttonName) << Param(shellyI3PressedEventCountParamTypeId, 3));
-            } else if (event == "SL") {
-                thing->emitEvent(shellyI3PressedEventTypeId, ParamList() << Param(shellyI3PressedEventButtonNameParamTypeId, buttonName) << Param(shellyI3PressedEventCountParamTypeId, 1));
-                thing->emitEvent(shellyI3LongPressedEventTypeId, ParamList() << Param(shellyI3LongPressedEventButtonNameParamTypeId, buttonName));
-            } else if (event == "LS") {
-                thing->emitEvent(shellyI3LongPressedEventTypeId, ParamList() << Param(shellyI3LongPressedEventButtonNameParamTypeId, buttonName));
-                thing->emitEvent(shellyI3PressedEventTypeId, ParamList() << Param(shellyI3PressedEventButtonNameParamTypeId, buttonName) << Param(shellyI3PressedEventCountParamTypeId, 1));
-            } else {
-                qCDebug(dcShelly()) << "Invalid button code from shelly I3:" << event;
+    if (thing->thingClassId() == shellyEmThingClassId) {
+        QHash<QString, StateTypeId> stateTypeIdMap = {
+            {"power", shellyEmChannelCurrentPowerStateTypeId},
+            {"pf", shellyEmChannelPowerFactorPhaseAStateTypeId},
+            {"reactive_power", shellyEmChannelReactivePowerPhaseAStateTypeId},
+            {"voltage", shellyEmChannelVoltagePhaseAStateTypeId},
+            {"total", shellyEmChannelTotalEnergyConsumedStateTypeId},
+            {"total_returned", shellyEmChannelTotalEnergyProducedStateTypeId}
+        };
+        for (int channel = 0; channel < 3; channel++) {
+            foreach (const QString &stateName, stateTypeIdMap.keys()) {
+                StateTypeId stateTypeId = stateTypeIdMap.value(stateName);
+                double factor = stateName.startsWith("total") ? 0.001 : 1;
+                bool lastValue = stateName == "total_returned";
+                router->addRoute(QString("emeter/%1/%2").arg(channel).arg(stateName), [this, thing, channel, stateTypeId, factor, lastValue](const QByteArray &payload){
+                    handleEmValue(thing, channel, stateTypeId, payload.toDouble() * factor, lastValue);
+                });
             }
         }
     }
 
-    topicMatcher = QRegExp("shellies/" + shellyId + "/emeter/[0-2]/.*");
-    if (topicMatcher.exactMatch(topic) && thing->thingClassId() == shellyEm3ThingClassId) {
-        int channel = topic.split('/').at(3).toInt();
-        QString stateName = topic.split('/').at(4);
-        QVariant value = payload;
-        QHash<int, QHash<QString, StateTypeId>> channelMap;
-        QHash<QString, StateTypeId> stateTypeIdMap;
-        stateTypeIdMap["power"] = shellyEm3CurrentPowerPhaseAStateTypeId;
-        stateTypeIdMap["pf"] = shellyEm3PowerFactorPhaseAStateTypeId;
-        stateTypeIdMap["current"] = shellyEm3CurrentPhaseAStateTypeId;
-        stateTypeIdMap["voltage"] = shellyEm3VoltagePhaseAStateTypeId;
-        stateTypeIdMap["total"] = shellyEm3EnergyConsumedPhaseAStateTypeId;
-        stateTypeIdMap["total_returned"] = shellyEm3EnergyProducedPhaseAStateTypeId;
-        channelMap[0] = stateTypeIdMap;
-        stateTypeIdMap["power"] = shellyEm3CurrentPowerPhaseBStateTypeId;
-        stateTypeIdMap["pf"] = shellyEm3PowerFactorPhaseBStateTypeId;
-        stateTypeIdMap["current"] = shellyEm3CurrentPhaseBStateTypeId;
-        stateTypeIdMap["voltage"] = shellyEm3VoltagePhaseBStateTypeId;
-        stateTypeIdMap["total"] = shellyEm3EnergyConsumedPhaseBStateTypeId;
-        stateTypeIdMap["total_returned"] = shellyEm3EnergyProducedPhaseBStateTypeId;
-        channelMap[1] = stateTypeIdMap;
-        stateTypeIdMap["power"] = shellyEm3CurrentPowerPhaseCStateTypeId;
-        stateTypeIdMap["pf"] = shellyEm3PowerFactorPhaseCStateTypeId;
-        stateTypeIdMap["current"] = shellyEm3CurrentPhaseCStateTypeId;
-        stateTypeIdMap["voltage"] = shellyEm3VoltagePhaseCStateTypeId;
-        stateTypeIdMap["total"] = shellyEm3EnergyConsumedPhaseCStateTypeId;
-        stateTypeIdMap["total_returned"] = shellyEm3EnergyProducedPhaseCStateTypeId;
-        channelMap[2] = stateTypeIdMap;
-        StateTypeId stateTypeId = channelMap.value(channel).value(stateName);
-        if (stateTypeId.isNull()) {
-            qCDebug(dcShelly()) << "Unhandled emeter value for channel" << channel << stateName;
+    m_topicRouters.insert(thing, router);
+}
+
+void IntegrationPluginShelly::releaseMqttChannel(Thing *thing)
+{
+    if (!m_mqttChannels.contains(thing)) {
+        return;
+    }
+    MqttChannel *channel = m_mqttChannels.take(thing);
+    m_channelThings.remove(channel);
+    delete m_topicRouters.take(thing);
+    hardwareManager()->mqttProvider()->releaseChannel(channel);
+
+    // The CoIoT values are dispatched through the topic router, drop them along with it
+    m_coiotThings.remove(m_coiotThings.key(thing));
+    m_coiotTopics.remove(thing);
+    m_coiotAddresses.remove(thing);
+    m_pendingCoiotDescriptions.removeAll(thing);
+}
+
+void IntegrationPluginShelly::fetchCoiotDescription(Thing *thing)
+{
+    if (m_pendingCoiotDescriptions.contains(thing)) {
+        return;
+    }
+
+    // Never derive the address from the packet, the request carries the device credentials
+    QHostAddress address = getIP(thing);
+    if (address.isNull()) {
+        return;
+    }
+    m_pendingCoiotDescriptions.append(thing);
+
+    QUrl url;
+    url.setScheme("http");
+    url.setHost(address.toString());
+    url.setPort(80);
+    url.setPath("/cit/d");
+    url.setUserName(thing->paramValue(usernameParamTypeMap.value(thing->thingClassId())).toString());
+    url.setPassword(thing->paramValue(passwordParamTypeMap.value(thing->thingClassId())).toString());
+
+    qCDebug(dcShelly()) << "Fetching CoIoT description from" << thing->name();
+    QNetworkReply *reply = hardwareManager()->networkManager()->get(QNetworkRequest(url));
+    connect(reply, &QNetworkReply::finished, reply, &QNetworkReply::deleteLater);
+    connect(reply, &QNetworkReply::finished, thing, [this, thing, reply](){
+        m_pendingCoiotDescriptions.removeAll(thing);
+        if (reply->error() != QNetworkReply::NoError) {
+            qCWarning(dcShelly()) << "Failed to fetch CoIoT description from" << thing->name() << reply->errorString();
             return;
         }
-        double factor = 1;
-        if (stateName == "total" || stateName == "total_returned") {
-            factor = 0.001;
+        // Devices without a usable description end up with an empty map and stay on MQTT only
+        ShellyCoiotListener::TopicMap topicMap = ShellyCoiotListener::parseDescription(reply->readAll());
+        qCDebug(dcShelly()) << "Mapped" << topicMap.count() << "CoIoT values for" << thing->name();
+        m_coiotTopics.insert(thing, topicMap);
+    });
+}
+
+void IntegrationPluginShelly::handleInfo(Thing *thing, const QByteArray &payload)
+{
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qCWarning(dcShelly()) << "Failed to parse shelly info payload:" << error.errorString();
+        qCWarning(dcShelly()) << qUtf8Printable(payload);
+        return;
+    }
+    QVariantMap data = jsonDoc.toVariant().toMap();
+
+    // Wifi signal strength
+    int signalStrength = -1;
+    if (data.value("wifi_sta").toMap().contains("rssi")) {
+        int rssi = data.value("wifi_sta").toMap().value("rssi").toInt();
+        signalStrength = qMin(100, qMax(0, (rssi + 100) * 2));
+    }
+    thing->setStateValue(signalStrengthStateTypesMap.value(thing->thingClassId()), signalStrength);
+    foreach (Thing *child, myThings().filterByParentId(thing->id())) {
+        child->setStateValue(signalStrengthStateTypesMap.value(child->thingClassId()), signalStrength);
+    }
+
+    // Firmware update
+    QString updateStatus = updateStatusMap.value(data.value("update").toMap().value("status").toString());
+    thing->setStateValue(updateStatusStateTypesMap.value(thing->thingClassId()), updateStatus);
+    thing->setStateValue(currentVersionStateTypesMap.value(thing->thingClassId()), data.value("update").toMap().value("old_version").toString());
+    thing->setStateValue(availableVersionStateTypesMap.value(thing->thingClassId()), data.value("update").toMap().value("new_version").toString());
+
+    if (data.contains("longpush_duration_ms")) {
+        if (longpushMinDurationSettingIds.contains(thing->thingClassId())) {
+            thing->setSettingValue(longpushMinDurationSettingIds.value(thing->thingClassId()), data.value("longpush_duration_ms").toMap().value("min").toUInt());
+        }
+        foreach (Thing *child, myThings().filterByParentId(thing->id())) {
+            if (longpushMinDurationSettingIds.contains(child->thingClassId())) {
+                thing->setSettingValue(longpushMinDurationSettingIds.value(thing->thingClassId()), data.value("longpush_duration_ms").toMap().value("min").toUInt());
+            }
+        }
+        if (longpushMaxDurationSettingIds.contains(thing->thingClassId())) {
+            thing->setSettingValue(longpushMaxDurationSettingIds.value(thing->thingClassId()), data.value("longpush_duration_ms").toMap().value("max").toUInt());
+        }
+        foreach (Thing *child, myThings().filterByParentId(thing->id())) {
+            if (longpushMaxDurationSettingIds.contains(child->thingClassId())) {
+                thing->setSettingValue(longpushMaxDurationSettingIds.value(thing->thingClassId()), data.value("longpush_duration_ms").toMap().value("max").toUInt());
+            }
         }
+    }
+    if (data.contains("multipush_time_between_pushes_ms")) {
+        if (multipushTimeBetweenPushesSettingIds.contains(thing->thingClassId())) {
+            thing->setSettingValue(multipushTimeBetweenPushesSettingIds.value(thing->thingClassId()), data.value("multipush_time_between_pushes_ms").toMap().value("max").toUInt());
+        }
+        foreach (Thing *child, myThings().filterByParentId(thing->id())) {
+            if (multipushTimeBetweenPushesSettingIds.contains(child->thingClassId())) {
+                thing->setSettingValue(multipushTimeBetweenPushesSettingIds.value(thing->thingClassId()), data.value("multipush_time_between_pushes_ms").toMap().value("max").toUInt());
+            }
+        }
+    }
+
 
-        thing->setStateValue(stateTypeId, value.toDouble() * factor);
-
-        // Some optimization specific to the EM3: We receive each phase in a separate mqtt message
-        // and calculate the total ourselves. In order to not produce intermediate totals for each incoming message
-        // we'll only refresh the total when we get the last value for the last channel.
-        if (channel == 2 && stateName == "total_returned") {
-            double grandTotal = thing->stateValue(shellyEm3EnergyConsumedPhaseAStateTypeId).toDouble();
-            grandTotal += thing->stateValue(shellyEm3EnergyConsumedPhaseBStateTypeId).toDouble();
-            grandTotal += thing->stateValue(shellyEm3EnergyConsumedPhaseCStateTypeId).toDouble();
-            thing->setStateValue(shellyEm3TotalEnergyConsumedStateTypeId, grandTotal);
-            double grandTotalReturned = thing->stateValue(shellyEm3EnergyProducedPhaseAStateTypeId).toDouble();
-            grandTotalReturned += thing->stateValue(shellyEm3EnergyProducedPhaseBStateTypeId).toDouble();
-            grandTotalReturned += thing->stateValue(shellyEm3EnergyProducedPhaseCStateTypeId).toDouble();
-            thing->setStateValue(shellyEm3TotalEnergyProducedStateTypeId, grandTotalReturned);
-            double totalPower = thing->stateValue(shellyEm3CurrentPowerPhaseAStateTypeId).toDouble();
-            totalPower += thing->stateValue(shellyEm3CurrentPowerPhaseBStateTypeId).toDouble();
-            totalPower += thing->stateValue(shellyEm3CurrentPowerPhaseCStateTypeId).toDouble();
-            thing->setStateValue(shellyEm3CurrentPowerStateTypeId, totalPower);
+    // While we normally use the specific topics instead of the "info" object, the Shell H&T posts it very rarely
+    // and in combination with its power safe mode let's use this one to get temp/humidity
+    if (thing->thingClassId() == shellyHTThingClassId) {
+        if (data.value("tmp").toMap().value("is_valid").toBool()) {
+            thing->setStateValue(shellyHTTemperatureStateTypeId, data.value("tmp").toMap().value("tC").toDouble());
+        }
+        if (data.value("hum").toMap().value("is_valid").toBool()) {
+            thing->setStateValue(shellyHTHumidityStateTypeId, data.value("hum").toMap().value("value").toDouble());
         }
     }
+}
 
-    if (topicMatcher.exactMatch(topic) && thing->thingClassId() == shellyEmThingClassId) {
-        int channel = topic.split('/').at(3).toInt();
-        QString stateName = topic.split('/').at(4);
-        QVariant value = payload;
-        QHash<QString, StateTypeId> stateTypeIdMap;
-        stateTypeIdMap["power"] = shellyEmChannelCurrentPowerStateTypeId;
-        stateTypeIdMap["pf"] = shellyEmChannelPowerFactorPhaseAStateTypeId;
-        stateTypeIdMap["reactive_power"] = shellyEmChannelReactivePowerPhaseAStateTypeId;
-        stateTypeIdMap["voltage"] = shellyEmChannelVoltagePhaseAStateTypeId;
-        stateTypeIdMap["total"] = shellyEmChannelTotalEnergyConsumedStateTypeId;
-        stateTypeIdMap["total_returned"] = shellyEmChannelTotalEnergyProducedStateTypeId;
-        StateTypeId stateTypeId = stateTypeIdMap.value(stateName);
-        if (stateTypeId.isNull()) {
-            qCWarning(dcShelly()) << "Unhandled emeter value for channel" << channel << stateName;
-            return;
+void IntegrationPluginShelly::handleInput(Thing *thing, int channel, const QByteArray &payload)
+{
+    // "1" or "0"
+    // Emit event button pressed
+    bool on = payload == "1";
+    if (thing->thingClassId() == shellyI3ThingClassId) {
+        if (channel == 0) {
+            thing->setStateValue(shellyI3Input1StateTypeId, on);
+        } else if (channel == 1) {
+            thing->setStateValue(shellyI3Input2StateTypeId, on);
+        } else {
+            thing->setStateValue(shellyI3Input3StateTypeId, on);
         }
-        double factor = 1;
-        if (stateName == "total" || stateName == "total_returned") {
-            factor = 0.001;
+        return;
+    }
+    foreach (Thing *child, myThings().filterByParentId(thing->id())) {
+        if (child->thingClassId() == shellySwitchThingClassId && child->paramValue(shellySwitchThingChannelParamTypeId).toInt() == channel + 1) {
+            if (child->stateValue(shellySwitchPowerStateTypeId).toBool() != on) {
+                child->setStateValue(shellySwitchPowerStateTypeId, on);
+                emit emitEvent(Event(shellySwitchPressedEventTypeId, child->id()));
+            }
         }
-        // For multi-channel devices, power measurements are per-channel, so, find the child thing
-        foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByInterface("energymeter")) {
+    }
+}
+
+void IntegrationPluginShelly::handleRelay(Thing *thing, int channel, const QByteArray &payload)
+{
+    bool on = payload == "on";
+
+    // If the shelly main thing has a power state (e.g. Shelly Plug)
+    if (powerStateTypeMap.contains(thing->thingClassId())) {
+        thing->setStateValue(powerStateTypeMap.value(thing->thingClassId()), on);
+    }
+    // If the shelly main thing has multiple channels (e.g. Shelly 2.5)
+    if (thing->thingClassId() == shelly25ThingClassId) {
+        thing->setStateValue(channel == 0 ? shelly25Channel1StateTypeId : shelly25Channel2StateTypeId, on);
+    }
+
+    // And switch all childs of this shelly too
+    foreach (Thing *child, myThings().filterByParentId(thing->id())) {
+        if (powerStateTypeMap.contains(child->thingClassId())) {
             ParamTypeId channelParamTypeId = channelParamTypeMap.value(child->thingClassId());
             if (child->paramValue(channelParamTypeId).toInt() == channel + 1) {
-                child->setStateValue(stateTypeId, value.toDouble() * factor);
+                child->setStateValue(powerStateTypeMap.value(child->thingClassId()), on);
             }
         }
+    }
+}
 
-        // Some optimization specific to the EM: We calculate totals, current & power factor ourselves.
-        // In order to not produce intermediate totals for each incoming message,
-        // we'll only do the calculations when we get the total_returned (i.e. the last message) for the channel.
-        if (stateName == "total_returned") {
-            foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByInterface("energymeter")) {
-                ParamTypeId channelParamTypeId = channelParamTypeMap.value(child->thingClassId());
-                if (child->paramValue(channelParamTypeId).toInt() == channel + 1) {
-                    double power = child->stateValue(shellyEmChannelCurrentPowerStateTypeId).toDouble();
-                    double voltage = child->stateValue(shellyEmChannelVoltagePhaseAStateTypeId).toDouble();
-                    if (qFuzzyCompare(voltage, 0) == false) {
-                        double calcCurrent = power/voltage;
-                        child->setStateValue(shellyEmChannelCurrentPhaseAStateTypeId, calcCurrent);
-                    } else {
-                        child->setStateValue(shellyEmChannelCurrentPhaseAStateTypeId, 0);
-                    }
-                    /*double reactivePower = child->stateValue(shellyEmChannelReactivePowerPhaseAStateTypeId).toDouble();
-                    double root = qSqrt(power*power + reactivePower*reactivePower);
-                    if (qFuzzyCompare(root, 0) == false) {
-                        double calcPf = power/root;
-                        child->setStateValue(shellyEmChannelPowerFactorPhaseAStateTypeId, calcPf);
-                    } else {
-                        child->setStateValue(shellyEmChannelPowerFactorPhaseAStateTypeId, 0);
-                    }*/
-                }
-            }
+void IntegrationPluginShelly::handlePower(Thing *thing, int channel, const QByteArray &payload)
+{
+    double power = payload.toDouble();
+    // If this gateway thing supports power measuring (e.g. Shelly Plug S) set it directly here
+    if (currentPowerStateTypeMap.contains(thing->thingClassId())) {
+        thing->setStateValue(currentPowerStateTypeMap.value(thing->thingClassId()), power);
+    }
+    // For multi-channel devices, power measurements are per-channel, so, find the child thing
+    foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByInterface("extendedsmartmeterconsumer")) {
+        ParamTypeId channelParamTypeId = channelParamTypeMap.value(child->thingClassId());
+        if (child->paramValue(channelParamTypeId).toInt() == channel + 1) {
+            child->setStateValue(currentPowerStateTypeMap.value(child->thingClassId()), power);
+        }
+    }
+}
 
+void IntegrationPluginShelly::handleEnergy(Thing *thing, int channel, const QByteArray &payload)
+{
+    // W/min => kW/h
+    double energy = payload.toDouble() / 1000 / 60;
+    // If this gateway thing supports energy measuring (e.g. Shelly Plug S) set it directly here
+    if (totalEnergyConsumedStateTypeMap.contains(thing->thingClassId())) {
+        thing->setStateValue(totalEnergyConsumedStateTypeMap.value(thing->thingClassId()), energy);
+    }
+    // For multi-channel devices, power measurements are per-channel, so, find the child thing
+    foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByInterface("extendedsmartmeterconsumer")) {
+        ParamTypeId channelParamTypeId = channelParamTypeMap.value(child->thingClassId());
+        if (child->paramValue(channelParamTypeId).toInt() == channel + 1) {
+            child->setStateValue(totalEnergyConsumedStateTypeMap.value(child->thingClassId()), energy);
         }
     }
+}
+
+void IntegrationPluginShelly::handleColorStatus(Thing *thing, const QByteArray &payload)
+{
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qCWarning(dcShelly()) << "Error parsing JSON from Shelly:" << error.error << error.errorString() << payload;
+        return;
+    }
+    QVariantMap statusMap = jsonDoc.toVariant().toMap();
+    if (colorStateTypeMap.contains(thing->thingClassId())) {
+        QColor color = QColor(statusMap.value("red").toInt(), statusMap.value("green").toInt(), statusMap.value("blue").toInt());
+        thing->setStateValue(colorStateTypeMap.value(thing->thingClassId()), color);
+    }
+    if (brightnessStateTypeMap.contains(thing->thingClassId())) {
+        int brightness = statusMap.value("gain").toInt();
+        thing->setStateValue(brightnessStateTypeMap.value(thing->thingClassId()), brightness);
+    }
+    if (currentPowerStateTypeMap.contains(thing->thingClassId())) {
+        double power = statusMap.value("power").toDouble();
+        thing->setStateValue(currentPowerStateTypeMap.value(thing->thingClassId()), power);
+    }
+}
+
+void IntegrationPluginShelly::handleLightStatus(Thing *thing, const QByteArray &payload)
+{
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qCWarning(dcShelly()) << "Error parsing JSON from Shelly:" << error.error << error.errorString() << payload;
+        return;
+    }
+    //        qCDebug(dcShelly()) << "Payload:" << qUtf8Printable(jsonDoc.toJson());
+    QVariantMap statusMap = jsonDoc.toVariant().toMap();
+    if (brightnessStateTypeMap.contains(thing->thingClassId())) {
+        int brightness = statusMap.value("brightness").toInt();
+        thing->setStateValue(brightnessStateTypeMap.value(thing->thingClassId()), brightness);
+    }
+}
 
-    if (topic == "shellies/" + shellyId + "/status") {
+void IntegrationPluginShelly::handleInputEvent(Thing *thing, int channel, const QByteArray &payload)
+{
+    qCDebug(dcShelly()) << "Payload:" << payload;
+    if (thing->thingClassId() == shellyButton1ThingClassId) {  // it can be only at channel 0
         QJsonParseError error;
         QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
         if (error.error != QJsonParseError::NoError) {
-            qCWarning(dcShelly()) << "Error parsing JSON from Shelly:" << error.error << error.errorString() << payload;
+            qCWarning(dcShelly()) << "Failed to parse JSON from shelly:" << error.errorString() << qUtf8Printable(payload);
             return;
         }
-        //        qCDebug(dcShelly()) << "Payload:" << qUtf8Printable(jsonDoc.toJson());
-        QVariantMap statusMap = jsonDoc.toVariant().toMap();
-
-        if (presenceStateTypesMap.contains(thing->thingClassId())) {
-            thing->setStateValue(presenceStateTypesMap.value(thing->thingClassId()), statusMap.value("motion").toBool());
+        QString event = jsonDoc.toVariant().toMap().value("event").toString();
+        if (event.isEmpty()) {
+            return;
+        }
+        EventTypeId eventTypeId = event == "L" ? shellyButton1LongPressedEventTypeId : shellyButton1PressedEventTypeId;
+        ParamTypeId paramTypeId = eventTypeId == shellyButton1PressedEventTypeId ? shellyButton1PressedEventButtonNameParamTypeId : shellyButton1LongPressedEventButtonNameParamTypeId;
+        QString param = QString::number(event.length());
+        thing->emitEvent(eventTypeId, ParamList() << Param(paramTypeId, param));
+    }
+    if (thing->thingClassId() == shellyI3ThingClassId) {
+        QJsonParseError error;
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
+        if (error.error != QJsonParseError::NoError) {
+            qCWarning(dcShelly()) << "Failed to parse JSON from shelly:" << error.errorString() << qUtf8Printable(payload);
+            return;
         }
-        if (lightIntensityStateTypesMap.contains(thing->thingClassId())) {
-            thing->setStateValue(lightIntensityStateTypesMap.value(thing->thingClassId()), statusMap.value("lux").toDouble());
+
+        QString buttonName = QString::number(channel + 1);
+        QString event = jsonDoc.toVariant().toMap().value("event").toString();
+        if (event == "S") {
+            thing->emitEvent(shellyI3PressedEventTypeId, ParamList() << Param(shellyI3PressedEventButtonNameParamTypeId, buttonName) << Param(shellyI3PressedEventCountParamTypeId, 1));
+        } else if (event == "L") {
+            thing->emitEvent(shellyI3LongPressedEventTypeId, ParamList() << Param(shellyI3LongPressedEventButtonNameParamTypeId, buttonName));
+        } else if (event == "SS") {
+            thing->emitEvent(shellyI3PressedEventTypeId, ParamList() << Param(shellyI3PressedEventButtonNameParamTypeId, buttonName) << Param(shellyI3PressedEventCountParamTypeId, 2));
+        } else if (event == "SSS") {
+            thing->emitEvent(shellyI3PressedEventTypeId, ParamList() << Param(shellyI3PressedEventButtonNameParamTypeId, buttonName) << Param(shellyI3PressedEventCountParamTypeId, 3));
+        } else if (event == "SL") {
+            thing->emitEvent(shellyI3PressedEventTypeId, ParamList() << Param(shellyI3PressedEventButtonNameParamTypeId, buttonName) << Param(shellyI3PressedEventCountParamTypeId, 1));
+            thing->emitEvent(shellyI3LongPressedEventTypeId, ParamList() << Param(shellyI3LongPressedEventButtonNameParamTypeId, buttonName));
+        } else if (event == "LS") {
+            thing->emitEvent(shellyI3LongPressedEventTypeId, ParamList() << Param(shellyI3LongPressedEventButtonNameParamTypeId, buttonName));
+            thing->emitEvent(shellyI3PressedEventTypeId, ParamList() << Param(shellyI3PressedEventButtonNameParamTypeId, buttonName) << Param(shellyI3PressedEventCountParamTypeId, 1));
+        } else {
+            qCDebug(dcShelly()) << "Invalid button code from shelly I3:" << event;
         }
-        if (vibrationStateTypesMap.contains(thing->thingClassId())) {
-            thing->setStateValue(vibrationStateTypesMap.value(thing->thingClassId()), statusMap.value("vibration").toBool());
+    }
+}
+
+void IntegrationPluginShelly::handleStatus(Thing *thing, const QByteArray &payload)
+{
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qCWarning(dcShelly()) << "Error parsing JSON from Shelly:" << error.error << error.errorString() << payload;
+        return;
+    }
+    //        qCDebug(dcShelly()) << "Payload:" << qUtf8Printable(jsonDoc.toJson());
+    QVariantMap statusMap = jsonDoc.toVariant().toMap();
+
+    if (presenceStateTypesMap.contains(thing->thingClassId())) {
+        thing->setStateValue(presenceStateTypesMap.value(thing->thingClassId()), statusMap.value("motion").toBool());
+    }
+    if (lightIntensityStateTypesMap.contains(thing->thingClassId())) {
+        thing->setStateValue(lightIntensityStateTypesMap.value(thing->thingClassId()), statusMap.value("lux").toDouble());
+    }
+    if (vibrationStateTypesMap.contains(thing->thingClassId())) {
+        thing->setStateValue(vibrationStateTypesMap.value(thing->thingClassId()), statusMap.value("vibration").toBool());
+    }
+    if (batteryLevelStateTypesMap.contains(thing->thingClassId()) && statusMap.contains("bat")) {
+        thing->setStateValue(batteryLevelStateTypesMap.value(thing->thingClassId()), statusMap.value("bat").toMap().value("value").toInt());
+        thing->setStateValue(batteryCriticalStateTypesMap.value(thing->thingClassId()), statusMap.value("bat").toMap().value("value").toInt() < 10);
+    }
+}
+
+void IntegrationPluginShelly::handleEm3Value(Thing *thing, const StateTypeId &stateTypeId, double value, bool lastValue)
+{
+    thing->setStateValue(stateTypeId, value);
+
+    // Some optimization specific to the EM3: We receive each phase in a separate mqtt message
+    // and calculate the total ourselves. In order to not produce intermediate totals for each incoming message
+    // we'll only refresh the total when we get the last value for the last channel.
+    if (lastValue) {
+        double grandTotal = thing->stateValue(shellyEm3EnergyConsumedPhaseAStateTypeId).toDouble();
+        grandTotal += thing->stateValue(shellyEm3EnergyConsumedPhaseBStateTypeId).toDouble();
+        grandTotal += thing->stateValue(shellyEm3EnergyConsumedPhaseCStateTypeId).toDouble();
+        thing->setStateValue(shellyEm3TotalEnergyConsumedStateTypeId, grandTotal);
+        double grandTotalReturned = thing->stateValue(shellyEm3EnergyProducedPhaseAStateTypeId).toDouble();
+        grandTotalReturned += thing->stateValue(shellyEm3EnergyProducedPhaseBStateTypeId).toDouble();
+        grandTotalReturned += thing->stateValue(shellyEm3EnergyProducedPhaseCStateTypeId).toDouble();
+        thing->setStateValue(shellyEm3TotalEnergyProducedStateTypeId, grandTotalReturned);
+        double totalPower = thing->stateValue(shellyEm3CurrentPowerPhaseAStateTypeId).toDouble();
+        totalPower += thing->stateValue(shellyEm3CurrentPowerPhaseBStateTypeId).toDouble();
+        totalPower += thing->stateValue(shellyEm3CurrentPowerPhaseCStateTypeId).toDouble();
+        thing->setStateValue(shellyEm3CurrentPowerStateTypeId, totalPower);
+    }
+}
+
+void IntegrationPluginShelly::handleEmValue(Thing *thing, int channel, const StateTypeId &stateTypeId, double value, bool lastValue)
+{
+    // For multi-channel devices, power measurements are per-channel, so, find the child thing
+    foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByInterface("energymeter")) {
+        ParamTypeId channelParamTypeId = channelParamTypeMap.value(child->thingClassId());
+        if (child->paramValue(channelParamTypeId).toInt() != channel + 1) {
+            continue;
         }
-        if (batteryLevelStateTypesMap.contains(thing->thingClassId()) && statusMap.contains("bat")) {
-            thing->setStateValue(batteryLevelStateTypesMap.value(thing->thingClassId()), statusMap.value("bat").toMap().value("value").toInt());
-            thing->setStateValue(batteryCriticalStateTypesMap.value(thing->thingClassId()), statusMap.value("bat").toMap().value("value").toInt() < 10);
+        child->setStateValue(stateTypeId, value);
+
+        // Some optimization specific to the EM: We calculate totals, current & power factor ourselves.
+        // In order to not produce intermediate totals for each incoming message,
+        // we'll only do the calculations when we get the total_returned (i.e. the last message) for the channel.
+        if (lastValue) {
+            double power = child->stateValue(shellyEmChannelCurrentPowerStateTypeId).toDouble();
+            double voltage = child->stateValue(shellyEmChannelVoltagePhaseAStateTypeId).toDouble();
+            if (qFuzzyCompare(voltage, 0) == false) {
+                double calcCurrent = power/voltage;
+                child->setStateValue(shellyEmChannelCurrentPhaseAStateTypeId, calcCurrent);
+            } else {
+                child->setStateValue(shellyEmChannelCurrentPhaseAStateTypeId, 0);
+            }
+            /*double reactivePower = child->stateValue(shellyEmChannelReactivePowerPhaseAStateTypeId).toDouble();
+            double root = qSqrt(power*power + reactivePower*reactivePower);
+            if (qFuzzyCompare(root, 0) == false) {
+                double calcPf = power/root;
+                child->setStateValue(shellyEmChannelPowerFactorPhaseAStateTypeId, calcPf);
+            } else {
+                child->setStateValue(shellyEmChannelPowerFactorPhaseAStateTypeId, 0);
+            }*/
         }
     }
 }
 
 void IntegrationPluginShelly::updateStatus()
 {
+    bool coiotOnly = configValue(shellyPluginStatusSourceParamTypeId).toString() == "CoIoT";
     foreach (Thing *thing, m_mqttChannels.keys()) {
+        // Shellies reporting via CoIoT don't need to be polled
+        if (coiotOnly && !m_coiotTopics.value(thing).isEmpty()) {
+            continue;
+        }
 
         if (thing->stateValue("connected").toBool()) {
             MqttChannel *channel = m_mqttChannels.value(thing);
@@ -1355,6 +1523,10 @@ void IntegrationPluginShelly::setupShellyGateway(ThingSetupInfo *info)
     }
 
     m_mqttChannels.insert(info->thing(), channel);
+    m_channelThings.insert(channel, info->thing());
+    setupTopicRouter(info->thing(), shellyId);
+    // CoIoT identifies devices by the part after the model prefix, e.g. "shellyplug-s-A4CF12F3"
+    m_coiotThings.insert(shellyId.section('-', -1).toUpper(), info->thing());
     connect(channel, &MqttChannel::clientConnected, this, &IntegrationPluginShelly::onClientConnected);
     connect(channel, &MqttChannel::clientDisconnected, this, &IntegrationPluginShelly::onClientDisconnected);
     connect(channel, &MqttChannel::publishReceived, this, &IntegrationPluginShelly::onPublishReceived);
@@ -1380,12 +1552,11 @@ void IntegrationPluginShelly::setupShellyGateway(ThingSetupInfo *info)
     qCDebug(dcShelly()) << "Connecting to" << url.toString();
     QNetworkReply *reply = hardwareManager()->networkManager()->get(request);
     connect(reply, &QNetworkReply::finished, reply, &QNetworkReply::deleteLater);
-    connect(info, &ThingSetupInfo::aborted, channel, [this, channel, thing](){
+    connect(info, &ThingSetupInfo::aborted, channel, [this, thing](){
         qCWarning(dcShelly()) << "Setup for" << thing->name() << "aborted.";
-        hardwareManager()->mqttProvider()->releaseChannel(channel);
-        m_mqttChannels.remove(thing);
+        releaseMqttChannel(thing);
     });
-    connect(reply, &QNetworkReply::finished, info, [this, info, reply, channel, address](){
+    connect(reply, &QNetworkReply::finished, info, [this, info, reply, address](){
         if (reply->error() != QNetworkReply::NoError) {
             qCWarning(dcShelly()) << "Error fetching thing settings for" << info->thing()->name() << reply->error() << reply->errorString();
             // Given the networkManagers timeout is the same as the info timeout (30s) and they are
@@ -1394,10 +1565,7 @@ void IntegrationPluginShelly::setupShellyGateway(ThingSetupInfo *info)
             // aborted flag) which both clean up the MQTT channel. Make sure to check if it's still there
             // before actually cleaning up. We can't remove any of the cleanups as that might cause leaks if
             // either the network reply finishes with an earlier error, or the setup is aborted earlier.
-            if (m_mqttChannels.contains(info->thing())) {
-                hardwareManager()->mqttProvider()->releaseChannel(channel);
-                m_mqttChannels.remove(info->thing());
-            }
+            releaseMqttChannel(info->thing());
             if (reply->error() == QNetworkReply::AuthenticationRequiredError) {
                 info->finish(Thing::ThingErrorAuthenticationFailure, QT_TR_NOOP("Username and password not set correctly."));
             } else {
@@ -1411,8 +1579,7 @@ void IntegrationPluginShelly::setupShellyGateway(ThingSetupInfo *info)
         if (error.error != QJsonParseError::NoError) {
             qCWarning(dcShelly()) << "Error parsing settings reply" << error.errorString() << "\n" << data;
             info->finish(Thing::ThingErrorHardwareFailure, QT_TR_NOOP("Unexpected data received from Shelly device."));
-            hardwareManager()->mqttProvider()->releaseChannel(channel);
-            m_mqttChannels.remove(info->thing());
+            releaseMqttChannel(info->thing());
             return;
         }
         qCDebug(dcShelly()) << "Settings data" << qUtf8Printable(jsonDoc.toJson(QJsonDocument::Indented));
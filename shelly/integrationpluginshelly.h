@@ -34,6 +34,7 @@
 #include "integrations/integrationplugin.h"
 
 #include "extern-plugininfo.h"
+#include "shellycoiotlistener.h"
 
 #include <QHostAddress>
 
@@ -41,6 +42,7 @@ class ZeroConfServiceBrowser;
 class PluginTimer;
 
 class MqttChannel;
+class ShellyTopicRouter;
 
 class IntegrationPluginShelly: public IntegrationPlugin
 {
@@ -65,6 +67,8 @@ private slots:
     void onClientConnected(MqttChannel* channel);
     void onClientDisconnected(MqttChannel* channel);
     void onPublishReceived(MqttChannel* channel, const QString &topic, const QByteArray &payload);
+    void onCoiotStatusReceived(const QString &deviceId, const QHostAddress &address, const QHash<int, QVariant> &values);
+    void onPluginConfigurationChanged(const ParamTypeId &paramTypeId, const QVariant &value);
 
     void updateStatus();
     void reconfigureUnconnected();
@@ -75,12 +79,37 @@ private:
 
     QHostAddress getIP(Thing *thing) const;
 
+    void setupTopicRouter(Thing *thing, const QString &shellyId);
+    void releaseMqttChannel(Thing *thing);
+    void fetchCoiotDescription(Thing *thing);
+
+    // Topic handlers, registered once per thing in setupTopicRouter()
+    void handleInfo(Thing *thing, const QByteArray &payload);
+    void handleStatus(Thing *thing, const QByteArray &payload);
+    void handleInput(Thing *thing, int channel, const QByteArray &payload);
+    void handleInputEvent(Thing *thing, int channel, const QByteArray &payload);
+    void handleRelay(Thing *thing, int channel, const QByteArray &payload);
+    void handlePower(Thing *thing, int channel, const QByteArray &payload);
+    void handleEnergy(Thing *thing, int channel, const QByteArray &payload);
+    void handleColorStatus(Thing *thing, const QByteArray &payload);
+    void handleLightStatus(Thing *thing, const QByteArray &payload);
+    void handleEm3Value(Thing *thing, const StateTypeId &stateTypeId, double value, bool lastValue);
+    void handleEmValue(Thing *thing, int channel, const StateTypeId &stateTypeId, double value, bool lastValue);
+
 private:
     ZeroConfServiceBrowser *m_zeroconfBrowser = nullptr;
     PluginTimer *m_statusUpdateTimer = nullptr;
     PluginTimer *m_reconfigureTimer = nullptr;
 
     QHash<Thing*, MqttChannel*> m_mqttChannels;
+    QHash<MqttChannel*, Thing*> m_channelThings;
+    QHash<Thing*, ShellyTopicRouter*> m_topicRouters;
+
+    ShellyCoiotListener *m_coiotListener = nullptr;
+    QHash<QString, Thing*> m_coiotThings;
+    QHash<Thing*, ShellyCoiotListener::TopicMap> m_coiotTopics;
+    QHash<Thing*, QHostAddress> m_coiotAddresses;
+    QList<Thing*> m_pendingCoiotDescriptions;
 };
 
 #endif // INTEGRATIONPLUGINSHELLY_H
@@ -6,6 +6,10 @@ PKGCONFIG += nymea-mqtt
 
 SOURCES += \
     integrationpluginshelly.cpp \
+    shellycoiotlistener.cpp \
+    shellytopicrouter.cpp \
 
 HEADERS += \
     integrationpluginshelly.h \
+    shellycoiotlistener.h \
+    shellytopicrouter.h \
@@ -0,0 +1,269 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "shellycoiotlistener.h"
+#include "extern-plugininfo.h"
+
+#include <QJsonDocument>
+#include <QNetworkDatagram>
+
+static const QHostAddress coiotMulticastAddress = QHostAddress("224.0.1.187");
+static const quint16 coiotPort = 5683;
+
+// CoAP option numbers used by CoIoT
+static const int coapOptionUriPath = 11;
+static const int coiotOptionGlobalDeviceId = 3332;
+
+// Resolves the extended option delta and length encodings, RFC 7252 section 3.1
+static bool readOptionField(const QByteArray &datagram, int &offset, int &field)
+{
+    if (field == 13) {
+        if (offset + 1 > datagram.length()) {
+            return false;
+        }
+        field = 13 + static_cast<quint8>(datagram.at(offset));
+        offset += 1;
+    } else if (field == 14) {
+        if (offset + 2 > datagram.length()) {
+            return false;
+        }
+        field = 269 + (static_cast<quint8>(datagram.at(offset)) << 8 | static_cast<quint8>(datagram.at(offset + 1)));
+        offset += 2;
+    } else if (field == 15) {
+        return false;
+    }
+    return true;
+}
+
+ShellyCoiotListener::ShellyCoiotListener(QObject *parent) : QObject(parent)
+{
+
+}
+
+ShellyCoiotListener::~ShellyCoiotListener()
+{
+    disable();
+}
+
+bool ShellyCoiotListener::enable()
+{
+    if (m_socket) {
+        return true;
+    }
+
+    m_socket = new QUdpSocket(this);
+    if (!m_socket->bind(QHostAddress::AnyIPv4, coiotPort, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)) {
+        qCWarning(dcShelly()) << "Could not bind CoIoT socket to port" << coiotPort << m_socket->errorString();
+        delete m_socket;
+        m_socket = nullptr;
+        return false;
+    }
+
+    if (!m_socket->joinMulticastGroup(coiotMulticastAddress)) {
+        qCWarning(dcShelly()) << "Could not join CoIoT multicast group" << m_socket->errorString();
+        delete m_socket;
+        m_socket = nullptr;
+        return false;
+    }
+
+    connect(m_socket, &QUdpSocket::readyRead, this, &ShellyCoiotListener::onReadyRead);
+    qCDebug(dcShelly()) << "Listening for CoIoT status packets on port" << coiotPort;
+    return true;
+}
+
+void ShellyCoiotListener::disable()
+{
+    if (!m_socket) {
+        return;
+    }
+
+    m_socket->close();
+    delete m_socket;
+    m_socket = nullptr;
+}
+
+bool ShellyCoiotListener::enabled() const
+{
+    return m_socket != nullptr;
+}
+
+ShellyCoiotListener::TopicMap ShellyCoiotListener::parseDescription(const QByteArray &data)
+{
+    TopicMap topicMap;
+
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qCWarning(dcShelly()) << "Failed to parse CoIoT description:" << error.errorString();
+        return topicMap;
+    }
+    QVariantMap description = jsonDoc.toVariant().toMap();
+
+    // Blocks are named like "relay_0", "roller_0", "emeter_2" or "device"
+    QHash<int, QString> blocks;
+    foreach (const QVariant &block, description.value("blk").toList()) {
+        blocks.insert(block.toMap().value("I").toInt(), block.toMap().value("D").toString());
+    }
+
+    // Sensor names in the relay/roller/emeter blocks and the MQTT topics they correspond to
+    static const QHash<QString, QString> relayTopics = {
+        {"output", "relay/%1"},
+        {"power", "relay/%1/power"},
+        {"energy", "relay/%1/energy"},
+        {"input", "input/%1"}
+    };
+    static const QHash<QString, QString> rollerTopics = {
+        {"roller", "roller/%1"},
+        {"rollerPos", "roller/%1/pos"},
+        {"rollerPower", "roller/%1/power"},
+        {"rollerEnergy", "roller/%1/energy"}
+    };
+    static const QHash<QString, QString> emeterTopics = {
+        {"power", "emeter/%1/power"},
+        {"reactivePower", "emeter/%1/reactive_power"},
+        {"voltage", "emeter/%1/voltage"},
+        {"current", "emeter/%1/current"},
+        {"powerFactor", "emeter/%1/pf"},
+        {"energy", "emeter/%1/total"},
+        {"energyReturned", "emeter/%1/total_returned"}
+    };
+
+    foreach (const QVariant &sensorVariant, description.value("sen").toList()) {
+        QVariantMap sensor = sensorVariant.toMap();
+        QString name = sensor.value("D").toString();
+        QString block = blocks.value(sensor.value("L").toInt());
+        QString type = block.section('_', 0, 0);
+        QString channel = block.section('_', 1, 1);
+
+        TopicMapping mapping;
+        if (type == "relay") {
+            mapping.topic = relayTopics.value(name).arg(channel);
+            mapping.onOff = name == "output";
+        } else if (type == "light" || type == "color") {
+            if (name == "output") {
+                mapping.topic = type + "/" + channel;
+                mapping.onOff = true;
+            } else if (name == "power") {
+                mapping.topic = type + "/" + channel + "/power";
+            }
+        } else if (type == "roller") {
+            mapping.topic = rollerTopics.value(name).arg(channel);
+        } else if (type == "emeter") {
+            mapping.topic = emeterTopics.value(name).arg(channel);
+        } else if (type == "input" && name == "input") {
+            mapping.topic = "input/" + channel;
+        } else if (type == "device" && name == "battery") {
+            mapping.topic = "sensor/battery";
+        }
+
+        if (!mapping.topic.isEmpty()) {
+            topicMap.insert(sensor.value("I").toInt(), mapping);
+        }
+    }
+
+    return topicMap;
+}
+
+QByteArray ShellyCoiotListener::toPayload(const TopicMapping &mapping, const QVariant &value)
+{
+    if (mapping.onOff) {
+        return value.toInt() == 1 ? "on" : "off";
+    }
+    if (value.type() == QVariant::String) {
+        return value.toString().toUtf8();
+    }
+    return QByteArray::number(value.toDouble(), 'g', 12);
+}
+
+void ShellyCoiotListener::onReadyRead()
+{
+    while (m_socket->hasPendingDatagrams()) {
+        QNetworkDatagram datagram = m_socket->receiveDatagram();
+        processDatagram(datagram.data(), datagram.senderAddress());
+    }
+}
+
+void ShellyCoiotListener::processDatagram(const QByteArray &datagram, const QHostAddress &address)
+{
+    // CoAP header: version, type and token length, code, message id
+    if (datagram.length() < 4 || (static_cast<quint8>(datagram.at(0)) >> 6) != 1) {
+        return;
+    }
+    int offset = 4 + (datagram.at(0) & 0x0f);
+
+    QStringList uriPath;
+    QString deviceId;
+    int optionNumber = 0;
+    while (offset < datagram.length() && static_cast<quint8>(datagram.at(offset)) != 0xff) {
+        quint8 header = static_cast<quint8>(datagram.at(offset++));
+        int delta = header >> 4;
+        int length = header & 0x0f;
+
+        if (!readOptionField(datagram, offset, delta) || !readOptionField(datagram, offset, length)) {
+            return;
+        }
+
+        if (offset + length > datagram.length()) {
+            return;
+        }
+        optionNumber += delta;
+        QByteArray value = datagram.mid(offset, length);
+        offset += length;
+
+        if (optionNumber == coapOptionUriPath) {
+            uriPath.append(QString::fromUtf8(value));
+        } else if (optionNumber == coiotOptionGlobalDeviceId) {
+            // <device type>#<device id>#<protocol revision>
+            deviceId = QString::fromUtf8(value).section('#', 1, 1);
+        }
+    }
+
+    if (uriPath.join('/') != "cit/s" || deviceId.isEmpty() || offset >= datagram.length()) {
+        return;
+    }
+
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(datagram.mid(offset + 1), &error);
+    if (error.error != QJsonParseError::NoError) {
+        qCDebug(dcShelly()) << "Failed to parse CoIoT status from" << deviceId << error.errorString();
+        return;
+    }
+
+    // {"G":[[<channel>, <sensor id>, <value>], ...]}
+    QHash<int, QVariant> values;
+    foreach (const QVariant &entry, jsonDoc.toVariant().toMap().value("G").toList()) {
+        QVariantList fields = entry.toList();
+        if (fields.count() == 3) {
+            values.insert(fields.at(1).toInt(), fields.at(2));
+        }
+    }
+
+    emit statusReceived(deviceId.toUpper(), address, values);
+}
@@ -0,0 +1,76 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef SHELLYCOIOTLISTENER_H
+#define SHELLYCOIOTLISTENER_H
+
+#include <QObject>
+#include <QHash>
+#include <QVariant>
+#include <QUdpSocket>
+#include <QHostAddress>
+
+// Receives the CoIoT (CoAP) status packets Gen1 shellies multicast on 224.0.1.187:5683
+class ShellyCoiotListener : public QObject
+{
+    Q_OBJECT
+public:
+    // A CoIoT sensor value mapped onto the MQTT topic carrying the same information
+    struct TopicMapping {
+        QString topic;
+        bool onOff = false;
+    };
+    typedef QHash<int, TopicMapping> TopicMap;
+
+    explicit ShellyCoiotListener(QObject *parent = nullptr);
+    ~ShellyCoiotListener() override;
+
+    bool enable();
+    void disable();
+    bool enabled() const;
+
+    // Parses the device description served on http://<shelly>/cit/d (CoIoT v2)
+    static TopicMap parseDescription(const QByteArray &data);
+    static QByteArray toPayload(const TopicMapping &mapping, const QVariant &value);
+
+signals:
+    // Maps the CoIoT sensor ids to their current values
+    void statusReceived(const QString &deviceId, const QHostAddress &address, const QHash<int, QVariant> &values);
+
+private slots:
+    void onReadyRead();
+
+private:
+    void processDatagram(const QByteArray &datagram, const QHostAddress &address);
+
+    QUdpSocket *m_socket = nullptr;
+};
+
+#endif // SHELLYCOIOTLISTENER_H
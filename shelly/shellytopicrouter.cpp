@@ -0,0 +1,97 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "shellytopicrouter.h"
+
+#include <QStringList>
+
+ShellyTopicRouter::ShellyTopicRouter(const QString &shellyId):
+    m_prefix("shellies/" + shellyId + "/")
+{
+    // Root node
+    m_nodes.append(Node());
+}
+
+void ShellyTopicRouter::addRoute(const QString &topic, Handler handler)
+{
+    int node = 0;
+    foreach (const QString &segment, topic.split('/')) {
+        int next = child(node, QStringRef(&segment));
+        if (next < 0) {
+            next = m_nodes.count();
+            m_nodes.append(Node());
+            m_nodes[node].children.append(qMakePair(segment, next));
+        }
+        node = next;
+    }
+    m_nodes[node].handler = handler;
+}
+
+bool ShellyTopicRouter::route(const QString &topic, const QByteArray &payload) const
+{
+    if (!topic.startsWith(m_prefix)) {
+        return false;
+    }
+    return routeSegments(topic.midRef(m_prefix.length()).split('/'), payload);
+}
+
+bool ShellyTopicRouter::routeRelative(const QString &topic, const QByteArray &payload) const
+{
+    return routeSegments(topic.splitRef('/'), payload);
+}
+
+bool ShellyTopicRouter::routeSegments(const QVector<QStringRef> &segments, const QByteArray &payload) const
+{
+    int node = 0;
+    foreach (const QStringRef &segment, segments) {
+        node = child(node, segment);
+        if (node < 0) {
+            return false;
+        }
+    }
+
+    if (!m_nodes.at(node).handler) {
+        return false;
+    }
+    m_nodes.at(node).handler(payload);
+    return true;
+}
+
+int ShellyTopicRouter::child(int node, const QStringRef &segment) const
+{
+    // Nodes only have a handful of children, comparing the segment references
+    // directly is cheaper than hashing them into temporary strings.
+    foreach (const auto &entry, m_nodes.at(node).children) {
+        if (segment == entry.first) {
+            return entry.second;
+        }
+    }
+    return -1;
+}
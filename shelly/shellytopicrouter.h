@@ -0,0 +1,71 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef SHELLYTOPICROUTER_H
+#define SHELLYTOPICROUTER_H
+
+#include <QPair>
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+
+#include <functional>
+
+// Dispatches the MQTT topics of one shelly to their handlers. Topics are registered
+// relative to "shellies/<id>/" and stored in a trie keyed on the topic segments, so
+// an incoming publish is routed with a single walk over its segments.
+class ShellyTopicRouter
+{
+public:
+    typedef std::function<void(const QByteArray &payload)> Handler;
+
+    explicit ShellyTopicRouter(const QString &shellyId);
+
+    void addRoute(const QString &topic, Handler handler);
+
+    // Returns false if no handler is registered for the given topic
+    bool route(const QString &topic, const QByteArray &payload) const;
+    // Same as route(), but for a topic relative to "shellies/<id>/"
+    bool routeRelative(const QString &topic, const QByteArray &payload) const;
+
+private:
+    struct Node {
+        QVector<QPair<QString, int>> children;
+        Handler handler;
+    };
+
+    bool routeSegments(const QVector<QStringRef> &segments, const QByteArray &payload) const;
+    int child(int node, const QStringRef &segment) const;
+
+    QString m_prefix;
+    QVector<Node> m_nodes;
+};
+
+#endif // SHELLYTOPICROUTER_H
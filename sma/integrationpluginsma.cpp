@@ -41,7 +41,8 @@ IntegrationPluginSma::IntegrationPluginSma()
 
 void IntegrationPluginSma::init()
 {
-
+    // All speedwire meters and inverters share one socket
+    m_speedwireMultiplexer = new SpeedwireMultiplexer(this);
 }
 
 void IntegrationPluginSma::discoverThings(ThingDiscoveryInfo *info)
@@ -256,7 +257,7 @@ void IntegrationPluginSma::setupThing(ThingSetupInfo *info)
             m_speedwireMeters.take(thing)->deleteLater();
         }
 
-        SpeedwireMeter *meter = new SpeedwireMeter(address, modelId, serialNumber, this);
+        SpeedwireMeter *meter = new SpeedwireMeter(m_speedwireMultiplexer, address, modelId, serialNumber, this);
         if (!meter->initialize()) {
             qCWarning(dcSma()) << "Setup failed. Could not initialize meter interface.";
             info->finish(Thing::ThingErrorHardwareFailure);
@@ -303,7 +304,7 @@ void IntegrationPluginSma::setupThing(ThingSetupInfo *info)
             m_speedwireInverters.take(thing)->deleteLater();
         }
 
-        SpeedwireInverter *inverter = new SpeedwireInverter(address, modelId, serialNumber, this);
+        SpeedwireInverter *inverter = new SpeedwireInverter(m_speedwireMultiplexer, address, modelId, serialNumber, this);
         if (!inverter->initialize()) {
             qCWarning(dcSma()) << "Setup failed. Could not initialize inverter interface.";
             info->finish(Thing::ThingErrorHardwareFailure);
@@ -37,6 +37,7 @@
 #include "sunnywebbox.h"
 #include "speedwiremeter.h"
 #include "speedwireinverter.h"
+#include "speedwiremultiplexer.h"
 
 class IntegrationPluginSma: public IntegrationPlugin {
     Q_OBJECT
@@ -65,6 +66,8 @@ private slots:
 private:
     PluginTimer *m_refreshTimer = nullptr;
 
+    SpeedwireMultiplexer *m_speedwireMultiplexer = nullptr;
+
     QHash<Thing *, SunnyWebBox *> m_sunnyWebBoxes;
     QHash<Thing *, SpeedwireMeter *> m_speedwireMeters;
     QHash<Thing *, SpeedwireInverter *> m_speedwireInverters;
@@ -9,6 +9,7 @@ SOURCES += \
     speedwireinverter.cpp \
     speedwireinverterreply.cpp \
     speedwireinverterrequest.cpp \
+    speedwiremultiplexer.cpp \
     speedwiremeter.cpp \
     sunnywebbox.cpp
 
@@ -20,5 +21,6 @@ HEADERS += \
     speedwireinverter.h \
     speedwireinverterreply.h \
     speedwireinverterrequest.h \
+    speedwiremultiplexer.h \
     speedwiremeter.h \
     sunnywebbox.h
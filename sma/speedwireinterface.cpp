@@ -29,19 +29,17 @@
 * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 #include "speedwireinterface.h"
+#include "speedwiremultiplexer.h"
 #include "extern-plugininfo.h"
 
-SpeedwireInterface::SpeedwireInterface(const QHostAddress &address, bool multicast, QObject *parent) :
+SpeedwireInterface::SpeedwireInterface(SpeedwireMultiplexer *multiplexer, const QHostAddress &address, quint32 serialNumber, bool multicast, QObject *parent) :
     QObject(parent),
+    m_multiplexer(multiplexer),
     m_address(address),
+    m_serialNumber(serialNumber),
     m_multicast(multicast)
 {
-
     qCDebug(dcSma()) << "SpeedwireInterface: Create interface for" << address.toString() << (multicast ? "multicast" : "unicast");
-    m_socket = new QUdpSocket(this);
-    connect(m_socket, &QUdpSocket::readyRead, this, &SpeedwireInterface::readPendingDatagrams);
-    connect(m_socket, &QUdpSocket::stateChanged, this, &SpeedwireInterface::onSocketStateChanged);
-    connect(m_socket, SIGNAL(error(QAbstractSocket::SocketError)),this, SLOT(onSocketError(QAbstractSocket::SocketError)));
 }
 
 SpeedwireInterface::~SpeedwireInterface()
@@ -51,13 +49,11 @@ SpeedwireInterface::~SpeedwireInterface()
 
 bool SpeedwireInterface::initialize()
 {
-    if (!m_socket->bind(QHostAddress::AnyIPv4, m_port, QAbstractSocket::ShareAddress | QAbstractSocket::ReuseAddressHint)) {
-        qCWarning(dcSma()) << "SpeedwireInterface: Initialization failed. Could not bind to port" << m_port;
-        return false;
-    }
+    if (m_initialized)
+        return true;
 
-    if (m_multicast && !m_socket->joinMulticastGroup(m_multicastAddress)) {
-        qCWarning(dcSma()) << "SpeedwireInterface: Initialization failed. Could not join multicast group" << m_multicastAddress.toString() << m_socket->errorString();
+    if (!m_multiplexer || !m_multiplexer->registerInterface(this)) {
+        qCWarning(dcSma()) << "SpeedwireInterface: Initialization failed. Could not register on the speedwire socket.";
         return false;
     }
 
@@ -69,13 +65,10 @@ bool SpeedwireInterface::initialize()
 void SpeedwireInterface::deinitialize()
 {
     if (m_initialized) {
-        if (m_multicast) {
-            if (!m_socket->leaveMulticastGroup(m_multicastAddress)) {
-                qCWarning(dcSma()) << "SpeedwireInterface: Failed to leave multicast group" << m_multicastAddress.toString();
-            }
-        }
+        // The multiplexer might already be gone if the plugin is shutting down
+        if (m_multiplexer)
+            m_multiplexer->unregisterInterface(this);
 
-        m_socket->close();
         m_initialized = false;
     }
 }
@@ -85,50 +78,45 @@ bool SpeedwireInterface::initialized() const
     return m_initialized;
 }
 
-quint16 SpeedwireInterface::sourceModelId() const
+QHostAddress SpeedwireInterface::address() const
 {
-    return m_sourceModelId;
+    return m_address;
 }
 
-quint32 SpeedwireInterface::sourceSerialNumber() const
+quint32 SpeedwireInterface::serialNumber() const
 {
-    return m_sourceSerialNumber;
+    return m_serialNumber;
 }
 
-void SpeedwireInterface::sendData(const QByteArray &data)
+bool SpeedwireInterface::multicast() const
 {
-    qCDebug(dcSma()) << "SpeedwireInterface: -->" << m_address.toString() << m_port << data.toHex();
-    if (m_socket->writeDatagram(data, m_address, m_port) < 0) {
-        qCWarning(dcSma()) << "SpeedwireInterface: failed to send data" << m_socket->errorString();
-    }
+    return m_multicast;
 }
 
-void SpeedwireInterface::readPendingDatagrams()
+quint16 SpeedwireInterface::sourceModelId() const
 {
-    QByteArray datagram;
-    QHostAddress senderAddress;
-    quint16 senderPort;
-
-    while (m_socket->hasPendingDatagrams()) {
-        datagram.resize(m_socket->pendingDatagramSize());
-        m_socket->readDatagram(datagram.data(), datagram.size(), &senderAddress, &senderPort);
-
-        // Process only data coming from our target address
-        if (senderAddress != m_address)
-            continue;
+    return m_sourceModelId;
+}
 
-        qCDebug(dcSma()) << "SpeedwireInterface: Received data from" << QString("%1:%2").arg(senderAddress.toString()).arg(senderPort);
-        //qCDebug(dcSma()) << "SpeedwireInterface: " << datagram.toHex();
-        emit dataReceived(datagram);
-    }
+quint32 SpeedwireInterface::sourceSerialNumber() const
+{
+    return m_sourceSerialNumber;
 }
 
-void SpeedwireInterface::onSocketError(QAbstractSocket::SocketError error)
+void SpeedwireInterface::sendData(const QByteArray &data)
 {
-    qCDebug(dcSma()) << "SpeedwireInterface: Socket error" << error;
+    if (!m_initialized) {
+        qCWarning(dcSma()) << "SpeedwireInterface: Cannot send data to" << m_address.toString() << "because the interface is not initialized.";
+        return;
+    }
+
+    if (m_multiplexer)
+        m_multiplexer->sendData(data, m_address);
 }
 
-void SpeedwireInterface::onSocketStateChanged(QAbstractSocket::SocketState socketState)
+void SpeedwireInterface::processDatagram(const QByteArray &datagram)
 {
-    qCDebug(dcSma()) << "SpeedwireInterface: Socket state changed" << socketState;
+    qCDebug(dcSma()) << "SpeedwireInterface: Received data from" << m_address.toString();
+    //qCDebug(dcSma()) << "SpeedwireInterface: " << datagram.toHex();
+    emit dataReceived(datagram);
 }
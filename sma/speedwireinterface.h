@@ -32,14 +32,20 @@
 #define SPEEDWIREINTERFACE_H
 
 #include <QObject>
-#include <QUdpSocket>
+#include <QPointer>
+#include <QHostAddress>
 #include <QDataStream>
 
 #include "speedwire.h"
 
+class SpeedwireMultiplexer;
+
 class SpeedwireInterface : public QObject
 {
     Q_OBJECT
+
+    friend class SpeedwireMultiplexer;
+
 public:
     enum DeviceType {
         DeviceTypeUnknown,
@@ -48,7 +54,7 @@ public:
     };
     Q_ENUM(DeviceType)
 
-    explicit SpeedwireInterface(const QHostAddress &address, bool multicast, QObject *parent = nullptr);
+    explicit SpeedwireInterface(SpeedwireMultiplexer *multiplexer, const QHostAddress &address, quint32 serialNumber, bool multicast, QObject *parent = nullptr);
     ~SpeedwireInterface();
 
     bool initialize();
@@ -56,6 +62,10 @@ public:
 
     bool initialized() const;
 
+    QHostAddress address() const;
+    quint32 serialNumber() const;
+    bool multicast() const;
+
     quint16 sourceModelId() const;
     quint32 sourceSerialNumber() const;
 
@@ -66,10 +76,9 @@ signals:
     void dataReceived(const QByteArray &data);
 
 private:
-    QUdpSocket *m_socket = nullptr;
+    QPointer<SpeedwireMultiplexer> m_multiplexer;
     QHostAddress m_address;
-    quint16 m_port = Speedwire::port();
-    QHostAddress m_multicastAddress = Speedwire::multicastAddress();
+    quint32 m_serialNumber = 0;
     bool m_multicast = false;
     bool m_initialized = false;
 
@@ -77,10 +86,7 @@ private:
     quint16 m_sourceModelId = 0x007d;
     quint32 m_sourceSerialNumber = 0x3a28be52;
 
-private slots:
-    void readPendingDatagrams();
-    void onSocketError(QAbstractSocket::SocketError error);
-    void onSocketStateChanged(QAbstractSocket::SocketState socketState);
+    void processDatagram(const QByteArray &datagram);
 
 };
 
@@ -33,14 +33,14 @@
 
 #include <QDateTime>
 
-SpeedwireInverter::SpeedwireInverter(const QHostAddress &address, quint16 modelId, quint32 serialNumber, QObject *parent) :
+SpeedwireInverter::SpeedwireInverter(SpeedwireMultiplexer *multiplexer, const QHostAddress &address, quint16 modelId, quint32 serialNumber, QObject *parent) :
     QObject(parent),
     m_address(address),
     m_modelId(modelId),
     m_serialNumber(serialNumber)
 {
     qCDebug(dcSma()) << "Inverter: setup interface on" << m_address.toString();
-    m_interface = new SpeedwireInterface(m_address, false, this);
+    m_interface = new SpeedwireInterface(multiplexer, m_address, m_serialNumber, false, this);
     connect(m_interface, &SpeedwireInterface::dataReceived, this, &SpeedwireInverter::processData);
 }
 
@@ -344,19 +344,14 @@ void SpeedwireInverter::refresh()
 
 void SpeedwireInverter::sendNextReply()
 {
-    // Pending reply
-    if (m_currentReply)
-        return;
-
-    // No reply left
-    if (m_replyQueue.isEmpty())
-        return;
-
-    // Pick the next reply and send request
-    m_currentReply = m_replyQueue.dequeue();
-    qCDebug(dcSma()) << "Inverter: --> Sending" << m_currentReply->request().command() << "packet ID:" << m_currentReply->request().packetId();
-    m_interface->sendData(m_currentReply->request().requestData());
-    m_currentReply->startWaiting();
+    // Keep up to m_maxPendingReplies requests on the wire, responses get matched by packet id
+    while (m_pendingReplies.count() < m_maxPendingReplies && !m_replyQueue.isEmpty()) {
+        SpeedwireInverterReply *reply = m_replyQueue.dequeue();
+        m_pendingReplies.insert(reply->request().packetId(), reply);
+        qCDebug(dcSma()) << "Inverter: --> Sending" << reply->request().command() << "packet ID:" << reply->request().packetId();
+        m_interface->sendData(reply->request().requestData());
+        reply->startWaiting();
+    }
 }
 
 SpeedwireInverterReply *SpeedwireInverter::createReply(const SpeedwireInverterRequest &request)
@@ -1003,32 +998,30 @@ void SpeedwireInverter::processData(const QByteArray &data)
 
     qCDebug(dcSma()) << "Inverter: <-- Received" << static_cast<Speedwire::Command>(packet.command) << "Packet ID:" << packet.packetId;
     //qCDebug(dcSma()) << "Inverter:" << data.toHex();
-    if (m_currentReply && m_currentReply->request().packetId() == packet.packetId) {
-        qCDebug(dcSma()) << "Inverter: Received response for current reply" << static_cast<Speedwire::Command>(m_currentReply->request().command()) << "Packet ID:" << m_currentReply->request().packetId();
-        m_currentReply->m_responseData = data;
-        m_currentReply->m_responseHeader = header;
-        m_currentReply->m_responsePacket = packet;
-        // Set the payload
-        while (!stream.atEnd()) {
-            quint8 byte;
-            stream >> byte;
-            m_currentReply->m_responsePayload.append(byte);
-        }
-
-        if (packet.errorCode != 0) {
-            m_currentReply->finishReply(SpeedwireInverterReply::ErrorInverterError);
-        } else {
-            m_currentReply->finishReply(SpeedwireInverterReply::ErrorNoError);
-        }
-    } else {
-        if (m_currentReply) {
-            qCWarning(dcSma()) << "Inverter: Received unexpected data: waiting for" << static_cast<Speedwire::Command>(m_currentReply->request().command()) << "Packet ID:" << m_currentReply->request().packetId();
-        } else {
+    SpeedwireInverterReply *reply = m_pendingReplies.value(packet.packetId);
+    if (!reply) {
+        if (m_pendingReplies.isEmpty()) {
             qCWarning(dcSma()) << "Inverter: Received unexpected data: not waiting for any response.";
+        } else {
+            qCWarning(dcSma()) << "Inverter: Received unexpected data: waiting for packet IDs" << m_pendingReplies.keys();
         }
         qCWarning(dcSma()) << "Inverter:" << header;
         qCWarning(dcSma()) << "Inverter:" << packet;
         qCWarning(dcSma()) << "Inverter:" << data.toHex();
+        return;
+    }
+
+    qCDebug(dcSma()) << "Inverter: Received response for pending reply" << static_cast<Speedwire::Command>(reply->request().command()) << "Packet ID:" << reply->request().packetId();
+    reply->m_responseData = data;
+    reply->m_responseHeader = header;
+    reply->m_responsePacket = packet;
+    // Set the payload
+    reply->m_responsePayload = data.mid(stream.device()->pos());
+
+    if (packet.errorCode != 0) {
+        reply->finishReply(SpeedwireInverterReply::ErrorInverterError);
+    } else {
+        reply->finishReply(SpeedwireInverterReply::ErrorNoError);
     }
 }
 
@@ -1036,11 +1029,11 @@ void SpeedwireInverter::onReplyTimeout()
 {
     SpeedwireInverterReply *reply = qobject_cast<SpeedwireInverterReply *>(sender());
     qCDebug(dcSma()) << "Inverter: Reply timeout" << reply->request().packetId() << reply->request().command();
+    m_pendingReplies.remove(reply->request().packetId());
     reply->m_retries += 1;
     if (reply->m_retries <= reply->m_maxRetries) {
         qCDebug(dcSma()) << "Inverter: Resend request" << reply->m_retries << "/" << reply->m_maxRetries;
         m_replyQueue.prepend(reply);
-        m_currentReply = nullptr;
         sendNextReply();
     } else {
         if (reply->m_maxRetries == 0) {
@@ -1056,13 +1049,74 @@ void SpeedwireInverter::onReplyTimeout()
 void SpeedwireInverter::onReplyFinished()
 {
     SpeedwireInverterReply *reply = qobject_cast<SpeedwireInverterReply *>(sender());
-    if (m_currentReply == reply) {
-        // Note: the reply is self deleting on finished
-        m_currentReply = nullptr;
-        sendNextReply();
+    // Note: the reply is self deleting on finished
+    if (m_pendingReplies.value(reply->request().packetId()) == reply)
+        m_pendingReplies.remove(reply->request().packetId());
+
+    sendNextReply();
+}
+
+QList<SpeedwireInverter::DataQuery> SpeedwireInverter::dataQueries()
+{
+    static const QList<DataQuery> queries = {
+        { "inverter status", Speedwire::CommandQueryStatus, 0x00214800, 0x002148ff, &SpeedwireInverter::processInverterStatusResponse },
+        { "AC voltage and current", Speedwire::CommandQueryAc, 0x00464800, 0x004655ff, &SpeedwireInverter::processAcVoltageCurrentResponse },
+        { "DC power", Speedwire::CommandQueryDc, 0x00251e00, 0x00251eff, &SpeedwireInverter::processDcPowerResponse },
+        { "DC voltage and current", Speedwire::CommandQueryDc, 0x00451f00, 0x004521ff, &SpeedwireInverter::processDcVoltageCurrentResponse },
+        { "energy production", Speedwire::CommandQueryEnergy, 0x00260100, 0x002622ff, &SpeedwireInverter::processEnergyProductionResponse },
+        { "total AC power", Speedwire::CommandQueryAc, 0x00263f00, 0x00263fff, &SpeedwireInverter::processAcTotalPowerResponse },
+        { "grid frequency", Speedwire::CommandQueryAc, 0x00465700, 0x004657ff, &SpeedwireInverter::processGridFrequencyResponse }
+    };
+    return queries;
+}
+
+void SpeedwireInverter::startDataQueries()
+{
+    // Schedule all queries at once, sendNextReply() keeps several of them in flight
+    QList<DataQuery> queries = dataQueries();
+    m_pendingDataQueries = queries.count();
+    m_failedDataQueries = 0;
+
+    foreach (const DataQuery &query, queries) {
+        qCDebug(dcSma()) << "Inverter: Request" << query.name << "...";
+        SpeedwireInverterReply *reply = sendQueryRequest(query.command, query.firstWord, query.lastWord);
+        ResponseProcessor processor = query.processor;
+        connect(reply, &SpeedwireInverterReply::finished, this, [=](){
+            onDataQueryFinished(reply, processor);
+        });
     }
 }
 
+void SpeedwireInverter::onDataQueryFinished(SpeedwireInverterReply *reply, ResponseProcessor processor)
+{
+    m_pendingDataQueries--;
+
+    if (reply->error() != SpeedwireInverterReply::ErrorNoError) {
+        // Keep the previous values of this object and continue with the others
+        qCWarning(dcSma()) << "Inverter: Failed to query data from inverter:" << reply->request().command() << reply->error();
+        m_failedDataQueries++;
+    } else {
+        qCDebug(dcSma()) << "Inverter: Query request finished successfully" << reply->request().command();
+        (this->*processor)(reply->responsePayload());
+    }
+
+    if (m_pendingDataQueries > 0)
+        return;
+
+    if (m_failedDataQueries >= dataQueries().count()) {
+        qCWarning(dcSma()) << "Inverter: All data queries failed.";
+        setState(StateDisconnected);
+        return;
+    }
+
+    if (m_failedDataQueries > 0)
+        qCDebug(dcSma()) << "Inverter: Query data cycle finished with" << m_failedDataQueries << "failed queries. Updating the remaining values.";
+
+    setReachable(true);
+    emit valuesUpdated();
+    setState(StateIdle);
+}
+
 void SpeedwireInverter::setState(State state)
 {
     if (m_state == state)
@@ -1165,109 +1219,8 @@ void SpeedwireInverter::setState(State state)
         });
         break;
     }
-    case StateQueryData: {
-        // Query inverter status
-        qCDebug(dcSma()) << "Inverter: Request inverter status...";
-        SpeedwireInverterReply *reply = sendQueryRequest(Speedwire::CommandQueryStatus, 0x00214800, 0x002148FF);
-        connect(reply, &SpeedwireInverterReply::finished, this, [=](){
-            if (reply->error() != SpeedwireInverterReply::ErrorNoError) {
-                qCWarning(dcSma()) << "Inverter: Failed to get status from inverter:" << reply->request().command() << reply->error();
-                setState(StateDisconnected);
-                return;
-            }
-
-            qCDebug(dcSma()) << "Inverter: Get inverter status request finished successfully" << reply->request().command();
-            processInverterStatusResponse(reply->responsePayload());
-
-            // Query AC voltage / current
-            qCDebug(dcSma()) << "Inverter: Request AC voltage and current...";
-            SpeedwireInverterReply *reply = sendQueryRequest(Speedwire::CommandQueryAc, 0x00464800, 0x004655ff);
-            connect(reply, &SpeedwireInverterReply::finished, this, [=](){
-                if (reply->error() != SpeedwireInverterReply::ErrorNoError) {
-                    qCWarning(dcSma()) << "Inverter: Failed to query data from inverter:" << reply->request().command() << reply->error();
-                    setState(StateDisconnected);
-                    return;
-                }
-
-                qCDebug(dcSma()) << "Inverter: Query request finished successfully" << reply->request().command();
-                processAcVoltageCurrentResponse(reply->responsePayload());
-
-                // Query DC power
-                qCDebug(dcSma()) << "Inverter: Request DC power...";
-                SpeedwireInverterReply *reply = sendQueryRequest(Speedwire::CommandQueryDc, 0x00251e00, 0x00251eff);
-                connect(reply, &SpeedwireInverterReply::finished, this, [=](){
-                    if (reply->error() != SpeedwireInverterReply::ErrorNoError) {
-                        qCWarning(dcSma()) << "Inverter: Failed to query data from inverter:" << reply->request().command() << reply->error();
-                        setState(StateDisconnected);
-                        return;
-                    }
-
-                    qCDebug(dcSma()) << "Inverter: Query request finished successfully" << reply->request().command();
-                    processDcPowerResponse(reply->responsePayload());
-
-                    // Query DC voltage/current
-                    qCDebug(dcSma()) << "Inverter: Request DC voltage and current...";
-                    SpeedwireInverterReply *reply = sendQueryRequest(Speedwire::CommandQueryDc, 0x00451f00, 0x004521ff);
-                    connect(reply, &SpeedwireInverterReply::finished, this, [=](){
-                        if (reply->error() != SpeedwireInverterReply::ErrorNoError) {
-                            qCWarning(dcSma()) << "Inverter: Failed to query data from inverter:" << reply->request().command() << reply->error();
-                            setState(StateDisconnected);
-                            return;
-                        }
-
-                        qCDebug(dcSma()) << "Inverter: Query request finished successfully" << reply->request().command();
-                        processDcVoltageCurrentResponse(reply->responsePayload());
-
-                        // Query energy production
-                        qCDebug(dcSma()) << "Inverter: Request energy production...";
-                        SpeedwireInverterReply *reply = sendQueryRequest(Speedwire::CommandQueryEnergy, 0x00260100, 0x002622ff);
-                        connect(reply, &SpeedwireInverterReply::finished, this, [=](){
-                            if (reply->error() != SpeedwireInverterReply::ErrorNoError) {
-                                qCWarning(dcSma()) << "Inverter: Failed to query data from inverter:" << reply->request().command() << reply->error();
-                                setState(StateDisconnected);
-                                return;
-                            }
-
-                            qCDebug(dcSma()) << "Inverter: Query request finished successfully" << reply->request().command();
-                            processEnergyProductionResponse(reply->responsePayload());
-
-                            // Query total AC power
-                            qCDebug(dcSma()) << "Inverter: Request total AC power...";
-                            SpeedwireInverterReply *reply = sendQueryRequest(Speedwire::CommandQueryAc, 0x00263f00, 0x00263fff);
-                            connect(reply, &SpeedwireInverterReply::finished, this, [=](){
-                                if (reply->error() != SpeedwireInverterReply::ErrorNoError) {
-                                    qCWarning(dcSma()) << "Inverter: Failed to query data from inverter:" << reply->request().command() << reply->error();
-                                    setState(StateDisconnected);
-                                    return;
-                                }
-
-                                qCDebug(dcSma()) << "Inverter: Query request finished successfully" << reply->request().command();
-                                processAcTotalPowerResponse(reply->responsePayload());
-
-                                // Query grid frequency
-                                qCDebug(dcSma()) << "Inverter: Request grid frequency...";
-                                SpeedwireInverterReply *reply = sendQueryRequest(Speedwire::CommandQueryAc, 0x00465700, 0x004657ff);
-                                connect(reply, &SpeedwireInverterReply::finished, this, [=](){
-                                    if (reply->error() != SpeedwireInverterReply::ErrorNoError) {
-                                        qCWarning(dcSma()) << "Inverter: Failed to query data from inverter:" << reply->request().command() << reply->error();
-                                        setState(StateDisconnected);
-                                        return;
-                                    }
-
-                                    qCDebug(dcSma()) << "Inverter: Query request finished successfully" << reply->request().command();
-                                    processGridFrequencyResponse(reply->responsePayload());
-
-                                    setReachable(true);
-                                    emit valuesUpdated();
-                                    setState(StateIdle);
-                                });
-                            });
-                        });
-                    });
-                });
-            });
-        });
+    case StateQueryData:
+        startDataQueries();
         break;
     }
-    }
 }
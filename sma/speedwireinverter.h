@@ -31,6 +31,7 @@
 #ifndef SPEEDWIREINVERTER_H
 #define SPEEDWIREINVERTER_H
 
+#include <QHash>
 #include <QObject>
 #include <QQueue>
 
@@ -53,7 +54,7 @@ public:
     };
     Q_ENUM(State)
 
-    explicit SpeedwireInverter(const QHostAddress &address, quint16 modelId, quint32 serialNumber, QObject *parent = nullptr);
+    explicit SpeedwireInverter(SpeedwireMultiplexer *multiplexer, const QHostAddress &address, quint16 modelId, quint32 serialNumber, QObject *parent = nullptr);
 
     bool initialize();
     bool initialized() const;
@@ -127,8 +128,23 @@ private:
 
     bool m_deviceInformationFetched = false;
 
-    SpeedwireInverterReply *m_currentReply = nullptr;
+    // Replies on the wire, matched by packet id
+    QHash<quint16, SpeedwireInverterReply *> m_pendingReplies;
     QQueue<SpeedwireInverterReply *> m_replyQueue;
+    int m_maxPendingReplies = 4;
+
+    // Query data cycle
+    typedef void (SpeedwireInverter::*ResponseProcessor)(const QByteArray &response);
+    struct DataQuery {
+        const char *name;
+        Speedwire::Command command;
+        quint32 firstWord;
+        quint32 lastWord;
+        ResponseProcessor processor;
+    };
+    static QList<DataQuery> dataQueries();
+    int m_pendingDataQueries = 0;
+    int m_failedDataQueries = 0;
 
     // Properties
     Speedwire::DeviceClass m_deviceClass = Speedwire::DeviceClassUnknown;
@@ -167,6 +183,9 @@ private:
     void sendNextReply();
     SpeedwireInverterReply *createReply(const SpeedwireInverterRequest &request);
 
+    void startDataQueries();
+    void onDataQueryFinished(SpeedwireInverterReply *reply, ResponseProcessor processor);
+
     // Request builder function
     void buildDefaultHeader(QDataStream &stream, quint16 payloadSize = 38, quint8 control = 0xa0);
     void buildPacket(QDataStream &stream, quint32 command, quint16 packetId);
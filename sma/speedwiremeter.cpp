@@ -31,13 +31,13 @@
 #include "speedwiremeter.h"
 #include "extern-plugininfo.h"
 
-SpeedwireMeter::SpeedwireMeter(const QHostAddress &address, quint16 modelId, quint32 serialNumber, QObject *parent) :
+SpeedwireMeter::SpeedwireMeter(SpeedwireMultiplexer *multiplexer, const QHostAddress &address, quint16 modelId, quint32 serialNumber, QObject *parent) :
     QObject(parent),
     m_address(address),
     m_modelId(modelId),
     m_serialNumber(serialNumber)
 {
-    m_interface = new SpeedwireInterface(m_address, true, this);
+    m_interface = new SpeedwireInterface(multiplexer, m_address, m_serialNumber, true, this);
     connect(m_interface, &SpeedwireInterface::dataReceived, this, &SpeedwireMeter::processData);
 
     // Reachable timestamp
@@ -41,7 +41,7 @@ class SpeedwireMeter : public QObject
 {
     Q_OBJECT
 public:
-    explicit SpeedwireMeter(const QHostAddress &address, quint16 modelId, quint32 serialNumber, QObject *parent = nullptr);
+    explicit SpeedwireMeter(SpeedwireMultiplexer *multiplexer, const QHostAddress &address, quint16 modelId, quint32 serialNumber, QObject *parent = nullptr);
 
     bool initialize();
     bool initialized() const;
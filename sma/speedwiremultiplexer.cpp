@@ -0,0 +1,221 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "speedwiremultiplexer.h"
+#include "speedwireinterface.h"
+#include "extern-plugininfo.h"
+
+#include <QtEndian>
+
+SpeedwireMultiplexer::SpeedwireMultiplexer(QObject *parent) :
+    QObject(parent)
+{
+    m_socket = new QUdpSocket(this);
+    connect(m_socket, &QUdpSocket::readyRead, this, &SpeedwireMultiplexer::readPendingDatagrams);
+    connect(m_socket, SIGNAL(error(QAbstractSocket::SocketError)),this, SLOT(onSocketError(QAbstractSocket::SocketError)));
+}
+
+SpeedwireMultiplexer::~SpeedwireMultiplexer()
+{
+    deinitialize();
+}
+
+bool SpeedwireMultiplexer::registerInterface(SpeedwireInterface *interface)
+{
+    if (!m_initialized && !initialize())
+        return false;
+
+    if (!m_interfaces.contains(interface->address(), interface))
+        m_interfaces.insert(interface->address(), interface);
+
+    updateMulticastMembership();
+    if (interface->multicast() && !m_multicastJoined) {
+        unregisterInterface(interface);
+        return false;
+    }
+
+    qCDebug(dcSma()) << "SpeedwireMultiplexer: Registered interface for" << interface->address().toString() << "Interfaces:" << m_interfaces.count();
+    return true;
+}
+
+void SpeedwireMultiplexer::unregisterInterface(SpeedwireInterface *interface)
+{
+    m_interfaces.remove(interface->address(), interface);
+    qCDebug(dcSma()) << "SpeedwireMultiplexer: Unregistered interface for" << interface->address().toString() << "Interfaces:" << m_interfaces.count();
+
+    if (m_interfaces.isEmpty()) {
+        deinitialize();
+    } else {
+        updateMulticastMembership();
+    }
+}
+
+bool SpeedwireMultiplexer::initialized() const
+{
+    return m_initialized;
+}
+
+bool SpeedwireMultiplexer::sendData(const QByteArray &data, const QHostAddress &address)
+{
+    qCDebug(dcSma()) << "SpeedwireMultiplexer: -->" << address.toString() << m_port << data.toHex();
+    if (m_socket->writeDatagram(data, address, m_port) < 0) {
+        qCWarning(dcSma()) << "SpeedwireMultiplexer: failed to send data" << m_socket->errorString();
+        return false;
+    }
+
+    return true;
+}
+
+bool SpeedwireMultiplexer::initialize()
+{
+    // Note: the discovery binds the same port while running, so the address has to be shared
+    if (!m_socket->bind(QHostAddress::AnyIPv4, m_port, QAbstractSocket::ShareAddress | QAbstractSocket::ReuseAddressHint)) {
+        qCWarning(dcSma()) << "SpeedwireMultiplexer: Initialization failed. Could not bind to port" << m_port << m_socket->errorString();
+        return false;
+    }
+
+    qCDebug(dcSma()) << "SpeedwireMultiplexer: Socket initialized successfully.";
+    m_initialized = true;
+    return m_initialized;
+}
+
+void SpeedwireMultiplexer::deinitialize()
+{
+    if (!m_initialized)
+        return;
+
+    if (m_multicastJoined && !m_socket->leaveMulticastGroup(m_multicastAddress)) {
+        qCWarning(dcSma()) << "SpeedwireMultiplexer: Failed to leave multicast group" << m_multicastAddress.toString();
+    }
+
+    m_multicastJoined = false;
+    m_socket->close();
+    m_initialized = false;
+}
+
+bool SpeedwireMultiplexer::multicastRequired() const
+{
+    foreach (SpeedwireInterface *interface, m_interfaces) {
+        if (interface->multicast()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void SpeedwireMultiplexer::updateMulticastMembership()
+{
+    bool required = multicastRequired();
+    if (required == m_multicastJoined)
+        return;
+
+    if (required) {
+        if (!m_socket->joinMulticastGroup(m_multicastAddress)) {
+            qCWarning(dcSma()) << "SpeedwireMultiplexer: Could not join multicast group" << m_multicastAddress.toString() << m_socket->errorString();
+            return;
+        }
+        qCDebug(dcSma()) << "SpeedwireMultiplexer: Joined multicast group" << m_multicastAddress.toString();
+    } else {
+        if (!m_socket->leaveMulticastGroup(m_multicastAddress)) {
+            qCWarning(dcSma()) << "SpeedwireMultiplexer: Failed to leave multicast group" << m_multicastAddress.toString();
+        }
+        qCDebug(dcSma()) << "SpeedwireMultiplexer: Left multicast group" << m_multicastAddress.toString();
+    }
+
+    m_multicastJoined = required;
+}
+
+quint32 SpeedwireMultiplexer::sourceSerialNumber(const QByteArray &datagram)
+{
+    // Header (18 bytes, big endian), protocol id at offset 16
+    if (datagram.size() < 18)
+        return 0;
+
+    const uchar *data = reinterpret_cast<const uchar *>(datagram.constData());
+    switch (qFromBigEndian<quint16>(data + 16)) {
+    case Speedwire::ProtocolIdMeter:
+        // Model id (2) and serial number (4), big endian
+        if (datagram.size() >= 24)
+            return qFromBigEndian<quint32>(data + 20);
+
+        break;
+    case Speedwire::ProtocolIdInverter:
+        // Word count, control, destination (8), source model id (2) and serial number (4), little endian
+        if (datagram.size() >= 34)
+            return qFromLittleEndian<quint32>(data + 30);
+
+        break;
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+void SpeedwireMultiplexer::readPendingDatagrams()
+{
+    QHostAddress senderAddress;
+    quint16 senderPort;
+
+    // Drain everything the socket has queued in one go and reuse the receive buffer
+    while (m_socket->hasPendingDatagrams()) {
+        qint64 size = m_socket->pendingDatagramSize();
+        if (size < 0)
+            break;
+
+        m_buffer.resize(static_cast<int>(size));
+        qint64 bytesRead = m_socket->readDatagram(m_buffer.data(), m_buffer.size(), &senderAddress, &senderPort);
+        if (bytesRead < 0)
+            continue;
+
+        QList<SpeedwireInterface *> interfaces = m_interfaces.values(senderAddress);
+        if (interfaces.isEmpty())
+            continue;
+
+        if (interfaces.count() == 1) {
+            interfaces.first()->processDatagram(m_buffer);
+            continue;
+        }
+
+        // Several devices behind the same address, dispatch by serial number
+        quint32 serialNumber = sourceSerialNumber(m_buffer);
+        foreach (SpeedwireInterface *interface, interfaces) {
+            if (serialNumber == 0 || interface->serialNumber() == 0 || interface->serialNumber() == serialNumber) {
+                interface->processDatagram(m_buffer);
+            }
+        }
+    }
+}
+
+void SpeedwireMultiplexer::onSocketError(QAbstractSocket::SocketError error)
+{
+    qCDebug(dcSma()) << "SpeedwireMultiplexer: Socket error" << error;
+}
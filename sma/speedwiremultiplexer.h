@@ -0,0 +1,81 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2022, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef SPEEDWIREMULTIPLEXER_H
+#define SPEEDWIREMULTIPLEXER_H
+
+#include <QObject>
+#include <QUdpSocket>
+#include <QMultiHash>
+
+#include "speedwire.h"
+
+class SpeedwireInterface;
+
+// Owns the one Speedwire socket of the plugin and dispatches each received
+// datagram only to the interfaces registered for the sender address.
+class SpeedwireMultiplexer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SpeedwireMultiplexer(QObject *parent = nullptr);
+    ~SpeedwireMultiplexer();
+
+    bool registerInterface(SpeedwireInterface *interface);
+    void unregisterInterface(SpeedwireInterface *interface);
+
+    bool initialized() const;
+
+    bool sendData(const QByteArray &data, const QHostAddress &address);
+
+private:
+    QUdpSocket *m_socket = nullptr;
+    quint16 m_port = Speedwire::port();
+    QHostAddress m_multicastAddress = Speedwire::multicastAddress();
+    bool m_initialized = false;
+    bool m_multicastJoined = false;
+
+    QMultiHash<QHostAddress, SpeedwireInterface *> m_interfaces;
+    QByteArray m_buffer;
+
+    bool initialize();
+    void deinitialize();
+    bool multicastRequired() const;
+    void updateMulticastMembership();
+
+    static quint32 sourceSerialNumber(const QByteArray &datagram);
+
+private slots:
+    void readPendingDatagrams();
+    void onSocketError(QAbstractSocket::SocketError error);
+
+};
+
+#endif // SPEEDWIREMULTIPLEXER_H
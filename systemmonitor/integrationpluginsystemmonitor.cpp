@@ -49,6 +49,9 @@ void IntegrationPluginSystemMonitor::setupThing(ThingSetupInfo *info)
     if (!m_refreshTimer) {
         m_refreshTimer = hardwareManager()->pluginTimerManager()->registerTimer(2);
         connect(m_refreshTimer, &PluginTimer::timeout, this, &IntegrationPluginSystemMonitor::onRefreshTimer);
+
+        // Take a first sample so CPU usage is available on the first refresh
+        m_sampler.update();
     }
     info->finish(Thing::ThingErrorNoError);
 }
@@ -66,52 +69,30 @@ void IntegrationPluginSystemMonitor::thingRemoved(Thing *thing)
 
 void IntegrationPluginSystemMonitor::onRefreshTimer()
 {
-    QProcess *p = new QProcess(this);
-    connect(p, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(onProcessFinished(int,QProcess::ExitStatus)));
-    p->start("ps", {"-C", "nymead", "-o", "%mem=,vsz=,rss=,pcpu="});
-}
-
-void IntegrationPluginSystemMonitor::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
-{
-    QProcess *p = static_cast<QProcess*>(sender());
-    p->deleteLater();
-
-    if (exitCode != 0 || exitStatus != QProcess::NormalExit) {
-            qWarning(dcSystemMonitor) << "Error reading process memory usage:" << p->readAllStandardError();
-            return;
-    }
-    QString data = QString(p->readAllStandardOutput().trimmed()).replace(QRegExp("[ ]{2,}"), " ");
-    QStringList parts = data.split(' ');
-    if (parts.count() != 4) {
-        qCWarning(dcSystemMonitor()) << "Unexpected result from ps" << data << parts;
-        return;
-    }
-    bool ok;
-    qreal percentMem = parts.at(0).toDouble(&ok);
-    if (!ok) {
-        qWarning(dcSystemMonitor) << "Failed to parse % memory value to a number:" << parts.at(0);
+    if (!m_sampler.update()) {
+        qCWarning(dcSystemMonitor()) << "Error reading process resource usage";
         return;
     }
-    qint64 virtualMem = parts.at(1).toLongLong(&ok);
-    if (!ok) {
-        qWarning(dcSystemMonitor) << "Failed to parse virtual memory value to a number:" << parts.at(1);
-        return;
-    }
-    quint64 rssMem = parts.at(2).toLongLong(&ok);
-    if (!ok) {
-        qWarning(dcSystemMonitor) << "Failed to parse RSS memory value to a number:" << data;
-        return;
-    }
-    qreal cpuUsage = parts.at(3).toDouble(&ok);
-    if (!ok) {
-        qWarning(dcSystemMonitor) << "Failed to parse CPU usage value to a number:" << parts.at(3);
-        return;
+
+    QList<ProcessSampler::ThreadSample> threads = m_sampler.threads();
+    foreach (const ProcessSampler::ThreadSample &thread, threads.mid(0, 5)) {
+        qCDebug(dcSystemMonitor()) << "Thread" << thread.id << thread.name << "CPU usage:" << thread.cpuUsage;
     }
+    ProcessSampler::ThreadSample busiestThread = threads.value(0);
+
     foreach (Thing *dev, myThings()) {
-        dev->setStateValue(systemMonitorRssMemoryStateTypeId, rssMem);
-        dev->setStateValue(systemMonitorPercentMemoryStateTypeId, percentMem);
-        dev->setStateValue(systemMonitorVirtualMemoryStateTypeId, virtualMem);
-        dev->setStateValue(systemMonitorCpuUsageStateTypeId, cpuUsage);
+        dev->setStateValue(systemMonitorRssMemoryStateTypeId, m_sampler.rssMemory());
+        dev->setStateValue(systemMonitorPercentMemoryStateTypeId, m_sampler.percentMemory());
+        dev->setStateValue(systemMonitorVirtualMemoryStateTypeId, m_sampler.virtualMemory());
+        dev->setStateValue(systemMonitorCpuUsageStateTypeId, m_sampler.cpuUsage());
+        dev->setStateValue(systemMonitorThreadCountStateTypeId, m_sampler.threadCount());
+        dev->setStateValue(systemMonitorBusiestThreadStateTypeId, busiestThread.name);
+        dev->setStateValue(systemMonitorBusiestThreadCpuUsageStateTypeId, qMin(100.0, busiestThread.cpuUsage));
+        dev->setStateValue(systemMonitorOpenFileDescriptorsStateTypeId, m_sampler.openFileDescriptors());
+        dev->setStateValue(systemMonitorVoluntaryContextSwitchesStateTypeId, m_sampler.voluntaryContextSwitches());
+        dev->setStateValue(systemMonitorInvoluntaryContextSwitchesStateTypeId, m_sampler.involuntaryContextSwitches());
+        dev->setStateValue(systemMonitorCpuPressureStateTypeId, m_sampler.cpuPressure());
+        dev->setStateValue(systemMonitorMemoryPressureStateTypeId, m_sampler.memoryPressure());
+        dev->setStateValue(systemMonitorIoPressureStateTypeId, m_sampler.ioPressure());
     }
 }
-
@@ -33,9 +33,9 @@
 
 #include "integrations/integrationplugin.h"
 #include "plugintimer.h"
+#include "processsampler.h"
 
 #include <QDebug>
-#include <QProcess>
 #include <QUrlQuery>
 
 
@@ -53,10 +53,10 @@ public:
 
 private slots:
     void onRefreshTimer();
-    void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
 
 private:
     PluginTimer *m_refreshTimer = nullptr;
+    ProcessSampler m_sampler;
 
 };
 
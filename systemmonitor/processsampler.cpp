@@ -0,0 +1,253 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "processsampler.h"
+#include "extern-plugininfo.h"
+
+#include <QDir>
+#include <QFile>
+
+#include <algorithm>
+
+#include <unistd.h>
+#include <sys/resource.h>
+
+ProcessSampler::ProcessSampler()
+{
+    long clockTicks = sysconf(_SC_CLK_TCK);
+    if (clockTicks > 0) {
+        m_clockTicks = clockTicks;
+    }
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if (pageSize > 0) {
+        m_pageSize = pageSize;
+    }
+
+    // MemTotal:        3884360 kB
+    foreach (const QByteArray &line, readFile("/proc/meminfo").split('\n')) {
+        if (line.startsWith("MemTotal:")) {
+            QList<QByteArray> parts = line.simplified().split(' ');
+            if (parts.count() >= 2) {
+                m_totalMemory = parts.at(1).toLongLong();
+            }
+            break;
+        }
+    }
+}
+
+bool ProcessSampler::update()
+{
+    QString name;
+    quint64 cpuTicks = 0;
+    if (!parseStat(readFile("/proc/self/stat"), &name, &cpuTicks)) {
+        qCWarning(dcSystemMonitor()) << "Failed to parse /proc/self/stat";
+        return false;
+    }
+
+    // No rates can be calculated on the first sample
+    double elapsedSeconds = 0;
+    if (m_sampleTimer.isValid()) {
+        elapsedSeconds = m_sampleTimer.restart() / 1000.0;
+    } else {
+        m_sampleTimer.start();
+    }
+    bool haveDelta = elapsedSeconds > 0;
+
+    if (haveDelta) {
+        m_cpuUsage = qMin(100.0, (cpuTicks - m_cpuTicks) * 100.0 / m_clockTicks / elapsedSeconds);
+    }
+    m_cpuTicks = cpuTicks;
+
+    // size resident shared text lib data dt, all in pages
+    QList<QByteArray> statm = readFile("/proc/self/statm").split(' ');
+    if (statm.count() >= 2) {
+        m_virtualMemory = statm.at(0).toLongLong() * m_pageSize / 1024;
+        m_rssMemory = statm.at(1).toLongLong() * m_pageSize / 1024;
+        if (m_totalMemory > 0) {
+            m_percentMemory = m_rssMemory * 100.0 / m_totalMemory;
+        }
+    }
+
+    QHash<int, quint64> threadTicks;
+    m_threads.clear();
+    QDir taskDir("/proc/self/task");
+    foreach (const QString &entry, taskDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        ThreadSample thread;
+        thread.id = entry.toInt();
+        quint64 ticks = 0;
+        if (!parseStat(readFile(taskDir.filePath(entry) + "/stat"), &thread.name, &ticks)) {
+            // The thread exited in the meantime
+            continue;
+        }
+        if (haveDelta && m_threadTicks.contains(thread.id)) {
+            thread.cpuUsage = (ticks - m_threadTicks.value(thread.id)) * 100.0 / m_clockTicks / elapsedSeconds;
+        }
+        threadTicks.insert(thread.id, ticks);
+        m_threads.append(thread);
+    }
+    m_threadTicks = threadTicks;
+    std::sort(m_threads.begin(), m_threads.end(), [](const ThreadSample &a, const ThreadSample &b) {
+        return a.cpuUsage > b.cpuUsage;
+    });
+
+    // The directory listing itself holds one descriptor while reading
+    m_openFileDescriptors = qMax(0, QDir("/proc/self/fd").entryList(QDir::AllEntries | QDir::System | QDir::NoDotAndDotDot).count() - 1);
+
+    // Unlike /proc/self/status, getrusage() sums up the context switches of all threads
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        if (haveDelta) {
+            m_voluntaryContextSwitchRate = qRound((usage.ru_nvcsw - m_voluntaryContextSwitches) / elapsedSeconds);
+            m_involuntaryContextSwitchRate = qRound((usage.ru_nivcsw - m_involuntaryContextSwitches) / elapsedSeconds);
+        }
+        m_voluntaryContextSwitches = usage.ru_nvcsw;
+        m_involuntaryContextSwitches = usage.ru_nivcsw;
+    }
+
+    if (m_pressureAvailable) {
+        m_cpuPressure = readPressure("cpu");
+        m_memoryPressure = readPressure("memory");
+        m_ioPressure = readPressure("io");
+    }
+
+    return true;
+}
+
+double ProcessSampler::cpuUsage() const
+{
+    return m_cpuUsage;
+}
+
+double ProcessSampler::percentMemory() const
+{
+    return m_percentMemory;
+}
+
+qint64 ProcessSampler::rssMemory() const
+{
+    return m_rssMemory;
+}
+
+qint64 ProcessSampler::virtualMemory() const
+{
+    return m_virtualMemory;
+}
+
+int ProcessSampler::threadCount() const
+{
+    return m_threads.count();
+}
+
+QList<ProcessSampler::ThreadSample> ProcessSampler::threads() const
+{
+    return m_threads;
+}
+
+int ProcessSampler::openFileDescriptors() const
+{
+    return m_openFileDescriptors;
+}
+
+int ProcessSampler::voluntaryContextSwitches() const
+{
+    return m_voluntaryContextSwitchRate;
+}
+
+int ProcessSampler::involuntaryContextSwitches() const
+{
+    return m_involuntaryContextSwitchRate;
+}
+
+double ProcessSampler::cpuPressure() const
+{
+    return m_cpuPressure;
+}
+
+double ProcessSampler::memoryPressure() const
+{
+    return m_memoryPressure;
+}
+
+double ProcessSampler::ioPressure() const
+{
+    return m_ioPressure;
+}
+
+QByteArray ProcessSampler::readFile(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+bool ProcessSampler::parseStat(const QByteArray &data, QString *name, quint64 *ticks)
+{
+    // pid (comm) state ppid ... The name may contain spaces and parentheses itself
+    int nameStart = data.indexOf('(');
+    int nameEnd = data.lastIndexOf(')');
+    if (nameStart < 0 || nameEnd < nameStart) {
+        return false;
+    }
+
+    // Fields starting with the state (field 3), utime and stime are fields 14 and 15
+    QList<QByteArray> fields = data.mid(nameEnd + 2).split(' ');
+    if (fields.count() < 13) {
+        return false;
+    }
+
+    *name = QString::fromUtf8(data.mid(nameStart + 1, nameEnd - nameStart - 1));
+    *ticks = fields.at(11).toULongLong() + fields.at(12).toULongLong();
+    return true;
+}
+
+double ProcessSampler::readPressure(const QString &resource)
+{
+    QByteArray data = readFile("/proc/pressure/" + resource);
+    if (data.isEmpty()) {
+        qCDebug(dcSystemMonitor()) << "Pressure stall information not available on this system.";
+        m_pressureAvailable = false;
+        return 0;
+    }
+
+    // some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+    foreach (const QByteArray &line, data.split('\n')) {
+        if (!line.startsWith("some ")) {
+            continue;
+        }
+        foreach (const QByteArray &field, line.split(' ')) {
+            if (field.startsWith("avg10=")) {
+                return field.mid(6).toDouble();
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,102 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef PROCESSSAMPLER_H
+#define PROCESSSAMPLER_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QElapsedTimer>
+
+// Samples the resource usage of our own process (nymead) directly from /proc.
+// CPU usage and rates are computed from the delta to the previous sample.
+class ProcessSampler
+{
+public:
+    class ThreadSample {
+    public:
+        int id = 0;
+        QString name;
+        double cpuUsage = 0;
+    };
+
+    ProcessSampler();
+
+    bool update();
+
+    double cpuUsage() const;
+    double percentMemory() const;
+    qint64 rssMemory() const;
+    qint64 virtualMemory() const;
+
+    int threadCount() const;
+    // Sorted by CPU usage, busiest thread first
+    QList<ThreadSample> threads() const;
+
+    int openFileDescriptors() const;
+    int voluntaryContextSwitches() const;
+    int involuntaryContextSwitches() const;
+
+    // Share of time in the last 10 seconds some tasks were stalled, 0 if PSI is not available
+    double cpuPressure() const;
+    double memoryPressure() const;
+    double ioPressure() const;
+
+private:
+    long m_clockTicks = 100;
+    long m_pageSize = 4096;
+    qint64 m_totalMemory = 0;
+    bool m_pressureAvailable = true;
+
+    QElapsedTimer m_sampleTimer;
+    quint64 m_cpuTicks = 0;
+    QHash<int, quint64> m_threadTicks;
+    qint64 m_voluntaryContextSwitches = 0;
+    qint64 m_involuntaryContextSwitches = 0;
+
+    double m_cpuUsage = 0;
+    double m_percentMemory = 0;
+    qint64 m_rssMemory = 0;
+    qint64 m_virtualMemory = 0;
+    QList<ThreadSample> m_threads;
+    int m_openFileDescriptors = 0;
+    int m_voluntaryContextSwitchRate = 0;
+    int m_involuntaryContextSwitchRate = 0;
+    double m_cpuPressure = 0;
+    double m_memoryPressure = 0;
+    double m_ioPressure = 0;
+
+    static QByteArray readFile(const QString &fileName);
+    static bool parseStat(const QByteArray &data, QString *name, quint64 *ticks);
+    double readPressure(const QString &resource);
+};
+
+#endif // PROCESSSAMPLER_H
@@ -4,6 +4,8 @@ TARGET = $$qtLibraryTarget(nymea_integrationpluginsystemmonitor)
 
 SOURCES += \
     integrationpluginsystemmonitor.cpp \
+    processsampler.cpp \
 
 HEADERS += \
     integrationpluginsystemmonitor.h \
+    processsampler.h \
@@ -54,10 +54,26 @@ void IntegrationPluginTcpCommander::setupThing(ThingSetupInfo *info)
             // In case of a reconfigure, make sure we reconnect
             tcpSocket->disconnectFromHost();
         }
+
+        // Recreate the framer, the framing params might have changed
+        delete m_tcpSocketFramers.take(thing);
+        StreamFramer *framer = new StreamFramer(framingConfiguration(thing), tcpSocket);
+        connect(framer, &StreamFramer::frameReceived, thing, [=](const QByteArray &frame){
+            ParamList params;
+            params << Param(tcpClientTriggeredEventDataParamTypeId, frame);
+            Event event(tcpClientTriggeredEventTypeId, thing->id(), params);
+            emitEvent(event);
+        });
+        m_tcpSocketFramers.insert(thing, framer);
+
         connect(tcpSocket, &QTcpSocket::stateChanged, thing, [=](QAbstractSocket::SocketState state){
             thing->setStateValue(tcpClientConnectedStateTypeId, state == QAbstractSocket::ConnectedState);
 
             if (state == QAbstractSocket::UnconnectedState) {
+                // Don't glue a partial frame to data of the next connection
+                if (m_tcpSocketFramers.contains(thing))
+                    m_tcpSocketFramers.value(thing)->reset();
+
                 QTimer::singleShot(10000, tcpSocket, [=](){
                     qCDebug(dcTCPCommander()) << "Reconnecting to server" << address << port;
                     tcpSocket->connectToHost(address, port);
@@ -66,10 +82,10 @@ void IntegrationPluginTcpCommander::setupThing(ThingSetupInfo *info)
         });
         connect(tcpSocket, &QTcpSocket::readyRead, thing, [=](){
             QByteArray data = tcpSocket->readAll();
-            ParamList params;
-            params << Param(tcpClientTriggeredEventDataParamTypeId, data);
-            Event event(tcpClientTriggeredEventTypeId, thing->id(), params);
-            emitEvent(event);
+            StreamFramer *framer = m_tcpSocketFramers.value(thing);
+            if (framer) {
+                framer->addData(data);
+            }
         });
 
         tcpSocket->connectToHost(address, port);
@@ -86,6 +102,7 @@ void IntegrationPluginTcpCommander::setupThing(ThingSetupInfo *info)
             delete tcpServer;
         }
         tcpServer = new TcpServer(port, this);
+        tcpServer->setFramingConfiguration(framingConfiguration(thing));
 
         if (tcpServer->isValid()) {
             m_tcpServers.insert(thing, tcpServer);
@@ -135,6 +152,7 @@ void IntegrationPluginTcpCommander::thingRemoved(Thing *thing)
 {
     if(thing->thingClassId() == tcpClientThingClassId){
         QTcpSocket *tcpSocket = m_tcpSockets.take(thing);
+        m_tcpSocketFramers.remove(thing);
         tcpSocket->deleteLater();
 
     } else if(thing->thingClassId() == tcpServerThingClassId){
@@ -144,6 +162,28 @@ void IntegrationPluginTcpCommander::thingRemoved(Thing *thing)
 }
 
 
+StreamFramer::Configuration IntegrationPluginTcpCommander::framingConfiguration(Thing *thing) const
+{
+    StreamFramer::Configuration configuration;
+    configuration.loggingCategory = dcTCPCommander;
+    if (thing->thingClassId() == tcpClientThingClassId) {
+        configuration.mode = StreamFramer::modeFromString(thing->paramValue(tcpClientThingFramingParamTypeId).toString());
+        configuration.delimiter = StreamFramer::decodeDelimiter(thing->paramValue(tcpClientThingDelimiterParamTypeId).toString());
+        configuration.frameLength = thing->paramValue(tcpClientThingFrameLengthParamTypeId).toInt();
+        configuration.lengthPrefixSize = thing->paramValue(tcpClientThingLengthPrefixSizeParamTypeId).toInt();
+        configuration.idleTimeout = thing->paramValue(tcpClientThingIdleTimeoutParamTypeId).toInt();
+        configuration.maximumFrameSize = thing->paramValue(tcpClientThingMaxFrameSizeParamTypeId).toInt();
+    } else if (thing->thingClassId() == tcpServerThingClassId) {
+        configuration.mode = StreamFramer::modeFromString(thing->paramValue(tcpServerThingFramingParamTypeId).toString());
+        configuration.delimiter = StreamFramer::decodeDelimiter(thing->paramValue(tcpServerThingDelimiterParamTypeId).toString());
+        configuration.frameLength = thing->paramValue(tcpServerThingFrameLengthParamTypeId).toInt();
+        configuration.lengthPrefixSize = thing->paramValue(tcpServerThingLengthPrefixSizeParamTypeId).toInt();
+        configuration.idleTimeout = thing->paramValue(tcpServerThingIdleTimeoutParamTypeId).toInt();
+        configuration.maximumFrameSize = thing->paramValue(tcpServerThingMaxFrameSizeParamTypeId).toInt();
+    }
+    return configuration;
+}
+
 void IntegrationPluginTcpCommander::onTcpSocketConnectionChanged(bool connected)
 {
     QTcpSocket *tcpSocket = static_cast<QTcpSocket *>(sender());
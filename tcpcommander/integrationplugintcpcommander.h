@@ -53,6 +53,9 @@ public:
 private:
     QHash<Thing*, QTcpSocket*> m_tcpSockets;
     QHash<Thing*, TcpServer*> m_tcpServers;
+    QHash<Thing*, StreamFramer*> m_tcpSocketFramers;
+
+    StreamFramer::Configuration framingConfiguration(Thing *thing) const;
 
 private slots:
     void onTcpSocketConnectionChanged(bool connected);
@@ -98,6 +98,11 @@ bool TcpServer::sendCommand(const QString &clientIp, const QByteArray &data)
     return success;
 }
 
+void TcpServer::setFramingConfiguration(const StreamFramer::Configuration &configuration)
+{
+    m_framingConfiguration = configuration;
+}
+
 void TcpServer::newConnection()
 {
     qDebug(dcTCPCommander()) << "TCP Server new Connection request";
@@ -105,6 +110,15 @@ void TcpServer::newConnection()
     socket->flush();
 
     m_clients.append(socket);
+
+    // Each connection has its own framer, frames of different clients must not get mixed up
+    StreamFramer *framer = new StreamFramer(m_framingConfiguration, socket);
+    QString clientIp = socket->peerAddress().toString();
+    connect(framer, &StreamFramer::frameReceived, this, [this, clientIp](const QByteArray &frame){
+        emit commandReceived(clientIp, frame);
+    });
+    m_framers.insert(socket, framer);
+
     emit connectionCountChanged(m_clients.count());
     connect(socket, &QTcpSocket::disconnected, this, &TcpServer::onDisconnected);
     connect(socket, &QTcpSocket::readyRead, this, &TcpServer::readData);
@@ -117,6 +131,7 @@ void TcpServer::onDisconnected()
     QTcpSocket *client = qobject_cast<QTcpSocket*>(sender());
     qDebug(dcTCPCommander()) << "TCP client disconnected";
     m_clients.removeAll(client);
+    m_framers.remove(client);
     emit connectionCountChanged(m_clients.count());
 }
 
@@ -126,7 +141,11 @@ void TcpServer::readData()
     QByteArray data = socket->readAll();
     qDebug(dcTCPCommander()) << "TCP Server data received: " << data;
     socket->write("OK\n");
-    emit commandReceived(socket->peerAddress().toString(), data);
+
+    StreamFramer *framer = m_framers.value(socket);
+    if (framer) {
+        framer->addData(data);
+    }
 }
 
 void TcpServer::onError(QAbstractSocket::SocketError error)
@@ -31,10 +31,13 @@
 #ifndef TCPSERVER_H
 #define TCPSERVER_H
 
+#include <QHash>
 #include <QObject>
 #include <QTcpSocket>
 #include <QTcpServer>
 
+#include "streamframer.h"
+
 class TcpServer : public QObject
 {
     Q_OBJECT
@@ -52,6 +55,9 @@ public:
 
     bool sendCommand(const QString &clientIp, const QByteArray &data);
 
+    // Applies to connections established afterwards
+    void setFramingConfiguration(const StreamFramer::Configuration &configuration);
+
 signals:
     void newPendingConnection();
     void commandReceived(const QString &clientIp, const QByteArray &message);
@@ -67,6 +73,8 @@ private:
     QTcpServer *m_tcpServer = nullptr;
 
     QList<QTcpSocket*> m_clients;
+    QHash<QTcpSocket*, StreamFramer*> m_framers;
+    StreamFramer::Configuration m_framingConfiguration;
 
 };
 
@@ -38,6 +38,7 @@
 #include <QJsonDocument>
 #include <QTimer>
 #include <QDataStream>
+#include <QDateTime>
 
 // Related projects:
 
@@ -105,6 +106,18 @@ void IntegrationPluginTPLink::init()
 {
     m_broadcastSocket = new QUdpSocket(this);
 
+    // Replies to the periodic state broadcast arrive on their own socket so they don't interfere with discovery
+    m_refreshSocket = new QUdpSocket(this);
+    connect(m_refreshSocket, &QUdpSocket::readyRead, this, &IntegrationPluginTPLink::onRefreshReadyRead);
+
+    QVariantMap map;
+    QVariantMap getSysInfo;
+    getSysInfo.insert("get_sysinfo", QVariant());
+    map.insert("system", getSysInfo);
+    QVariantMap getRealTime;
+    getRealTime.insert("get_realtime", QVariant());
+    map.insert("emeter", getRealTime);
+    m_stateRequest = encryptPayload(QJsonDocument::fromVariant(map).toJson(QJsonDocument::Compact));
 }
 
 void IntegrationPluginTPLink::discoverThings(ThingDiscoveryInfo *info)
@@ -188,18 +201,8 @@ void IntegrationPluginTPLink::setupThing(ThingSetupInfo *info)
         return;
     }
 
-    QVariantMap map;
-    QVariantMap getSysInfo;
-    getSysInfo.insert("get_sysinfo", QVariant());
-    map.insert("system", getSysInfo);
-    QVariantMap getRealTime;
-    getRealTime.insert("get_realtime", QVariant());
-    map.insert("emeter", getRealTime);
-    QByteArray payload = QJsonDocument::fromVariant(map).toJson(QJsonDocument::Compact);
-    QByteArray datagram = encryptPayload(payload);
-
-    qint64 len = m_broadcastSocket->writeDatagram(datagram, QHostAddress::Broadcast, 9999);
-    if (len != datagram.length()) {
+    qint64 len = m_broadcastSocket->writeDatagram(m_stateRequest, QHostAddress::Broadcast, 9999);
+    if (len != m_stateRequest.length()) {
         info->finish(Thing::ThingErrorHardwareFailure, QT_TR_NOOP("An error happened finding the device in the network."));
         return;
     }
@@ -286,15 +289,13 @@ void IntegrationPluginTPLink::postSetupThing(Thing *thing)
         processQueue(thing);
     });
 
+    if (thing->parentId().isNull()) {
+        m_deviceIds.insert(thing->paramValue(idParamTypesMap.value(thing->thingClassId())).toString(), thing);
+    }
+
     if (!m_timer) {
         m_timer = hardwareManager()->pluginTimerManager()->registerTimer(1);
-        connect(m_timer, &PluginTimer::timeout, this, [this](){
-            foreach (Thing *d, myThings()) {
-                if (d->parentId().isNull() && !m_pendingJobs.contains(d) && m_jobQueue[d].isEmpty()) {
-                    fetchState(d);
-                }
-            }
-        });
+        connect(m_timer, &PluginTimer::timeout, this, &IntegrationPluginTPLink::refreshStates);
     }
 
     // Update connected state in case the parent connected before we've completed the child setups
@@ -310,6 +311,9 @@ void IntegrationPluginTPLink::thingRemoved(Thing *thing)
     m_sockets.remove(thing);
     m_pendingJobs.remove(thing);
     m_jobQueue.remove(thing);
+    m_deviceIds.remove(m_deviceIds.key(thing));
+    m_lastBroadcastReply.remove(thing);
+    m_addresses.remove(thing);
 
     if (myThings().isEmpty() && m_timer) {
         hardwareManager()->pluginTimerManager()->unregisterTimer(m_timer);
@@ -396,6 +400,7 @@ void IntegrationPluginTPLink::connectToDevice(Thing *thing, const QHostAddress &
 
     connect(socket, &QTcpSocket::connected, thing, [this, thing, address] () {
         qCDebug(dcTplink()) << "Connected to device" << thing->name() << "at address:" << address;
+        m_addresses.insert(thing, address);
         StateTypeId connectedStateTypeId = connectedStateTypesMap.value(thing->thingClassId());
         thing->setStateValue(connectedStateTypeId, true);
 
@@ -460,45 +465,7 @@ void IntegrationPluginTPLink::connectToDevice(Thing *thing, const QHostAddress &
                     }
                 }
                 if (systemMap.contains("get_sysinfo")) {
-                    StateTypeId signalStrengthStateTypeId = signalStrengthStateTypesMap.value(thing->thingClassId());
-                    int rssi = systemMap.value("get_sysinfo").toMap().value("rssi").toInt();
-                    int signalStrength = qMax(0, qMin(100, 2 * (rssi + 100)));
-                    thing->setStateValue(signalStrengthStateTypeId, signalStrength);
-
-                    if (thing->thingClassId() == kasaSocketThingClassId) {
-                        foreach (Thing *child, myThings().filterByParentId(kasaSocketThingClassId)) {
-                            child->setStateValue(kasaSocketSignalStrengthStateTypeId, signalStrength);
-                        }
-                    }
-
-                    QString alias = systemMap.value("get_sysinfo").toMap().value("alias").toString();
-                    if (thing->name() != alias) {
-                        thing->setName(alias);
-                    }
-
-                    if (systemMap.value("get_sysinfo").toMap().contains("relay_state")) {
-                        int relayState = systemMap.value("get_sysinfo").toMap().value("relay_state").toInt();
-                        StateTypeId powerStateTypeId = powerStateTypesMap.value(thing->thingClassId());
-                        thing->setStateValue(powerStateTypeId, relayState == 1 ? true : false);
-
-                    } else if (systemMap.value("get_sysinfo").toMap().contains("children")) {
-                        // For now, only the HS300 has children, which we map to child things of type kasaSocket
-                        QVariantList children = systemMap.value("get_sysinfo").toMap().value("children").toList();
-                        foreach (const QVariant &childVariant, children) {
-                            QVariantMap childMap = childVariant.toMap();
-                            QString idParam = childMap.value("id").toString();
-                            bool relayState = childMap.value("state").toInt() == 1;
-                            Things things = myThings().filterByParentId(thing->id()).filterByParam(kasaSocketThingIdParamTypeId, idParam);
-                            if (things.count() == 1) {
-                                things.first()->setStateValue(kasaSocketPowerStateTypeId, relayState);
-                            } else {
-                                qCWarning(dcTplink()) << "Error matching child devices" << qUtf8Printable(jsonDoc.toJson());
-                                foreach (Thing *child, myThings().filterByParentId(thing->id())) {
-                                    qCDebug(dcTplink()) << "Existing child device:" << child->name() << child->params();
-                                }
-                            }
-                        }
-                    }
+                    updateSysInfo(thing, systemMap.value("get_sysinfo").toMap());
 
                     if (job.actionInfo) {
                         qCDebug(dcTplink()) << "Finishing action execution";
@@ -509,15 +476,7 @@ void IntegrationPluginTPLink::connectToDevice(Thing *thing, const QHostAddress &
             if (map.contains("emeter")) {
                 QVariantMap emeterMap = map.value("emeter").toMap();
                 if (emeterMap.contains("get_realtime")) {
-                    // This has quite a bit of jitter... Let's smoothen it while within +/- 0.1W to produce less events in the system
-                    StateTypeId currentPowerStateTypeId = currentPowerStatetTypesMap.value(thing->thingClassId());
-                    double oldValue = thing->stateValue(currentPowerStateTypeId).toDouble();
-                    double newValue = emeterMap.value("get_realtime").toMap().value("power_mw").toDouble() / 1000;
-                    if (qAbs(oldValue - newValue) > 0.1) {
-                        thing->setStateValue(currentPowerStateTypeId, newValue);
-                    }
-                    StateTypeId totalEnergyConsumedStateTypeId = totalEnergyConsumedStatetTypesMap.value(thing->thingClassId());
-                    thing->setStateValue(totalEnergyConsumedStateTypeId, emeterMap.value("get_realtime").toMap().value("total_wh").toDouble() / 1000);
+                    updateRealtime(thing, emeterMap.value("get_realtime").toMap());
                 }
             }
 
@@ -549,20 +508,11 @@ void IntegrationPluginTPLink::connectToDevice(Thing *thing, const QHostAddress &
 
 void IntegrationPluginTPLink::fetchState(Thing *thing, ThingActionInfo *info)
 {
-    QVariantMap map;
-    QVariantMap getSysInfo;
-    getSysInfo.insert("get_sysinfo", QVariant());
-    map.insert("system", getSysInfo);
-    QVariantMap getRealTime;
-    getRealTime.insert("get_realtime", QVariant());
-    map.insert("emeter", getRealTime);
-    QByteArray plaintext = QJsonDocument::fromVariant(map).toJson(QJsonDocument::Compact);
     qCDebug(dcTplink()) << "Fetching device state";
-    QByteArray payload = encryptPayload(plaintext);
     QByteArray data;
     QDataStream stream(&data, QIODevice::ReadWrite);
-    stream << static_cast<quint32>(payload.length());
-    data.append(payload);
+    stream << static_cast<quint32>(m_stateRequest.length());
+    data.append(m_stateRequest);
 
     Job job;
     job.id = m_jobIdx++;
@@ -606,3 +556,126 @@ void IntegrationPluginTPLink::processQueue(Thing *thing)
     }
 }
 
+void IntegrationPluginTPLink::refreshStates()
+{
+    bool broadcastRefresh = configValue(tplinkPluginBroadcastRefreshParamTypeId).toBool();
+    if (broadcastRefresh) {
+        qint64 len = m_refreshSocket->writeDatagram(m_stateRequest, QHostAddress::Broadcast, 9999);
+        if (len != m_stateRequest.length()) {
+            qCWarning(dcTplink()) << "Error sending state refresh broadcast:" << m_refreshSocket->errorString();
+        }
+    }
+
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    foreach (Thing *d, myThings()) {
+        if (!d->parentId().isNull()) {
+            continue;
+        }
+        // Devices which recently answered the broadcast don't need a TCP roundtrip. Others (e.g. broadcasts not
+        // reaching them or their reply not fitting in a datagram) fall back to polling via TCP.
+        if (broadcastRefresh && now - m_lastBroadcastReply.value(d) < 5000) {
+            continue;
+        }
+        if (!m_pendingJobs.contains(d) && m_jobQueue[d].isEmpty()) {
+            fetchState(d);
+        }
+    }
+}
+
+void IntegrationPluginTPLink::onRefreshReadyRead()
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    while (m_refreshSocket->hasPendingDatagrams()) {
+        QByteArray datagram;
+        datagram.resize(static_cast<int>(m_refreshSocket->pendingDatagramSize()));
+        QHostAddress senderAddress;
+        qint64 len = m_refreshSocket->readDatagram(datagram.data(), datagram.size(), &senderAddress);
+        if (len < 0) {
+            continue;
+        }
+        datagram.truncate(static_cast<int>(len));
+
+        QJsonParseError error;
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(decryptPayload(datagram), &error);
+        if (error.error != QJsonParseError::NoError) {
+            qCDebug(dcTplink()) << "Cannot parse state broadcast reply:" << error.errorString();
+            continue;
+        }
+
+        QVariantMap map = jsonDoc.toVariant().toMap();
+        QVariantMap sysInfo = map.value("system").toMap().value("get_sysinfo").toMap();
+        Thing *thing = m_deviceIds.value(sysInfo.value("deviceId").toString());
+        if (!thing) {
+            // Not one of ours
+            continue;
+        }
+        // Anyone can claim a device id, only accept replies from the address we're connected to
+        if (!m_addresses.value(thing).isEqual(senderAddress, QHostAddress::TolerantConversion)) {
+            qCDebug(dcTplink()) << "Ignoring state reply for" << thing->name() << "from unexpected sender" << senderAddress;
+            continue;
+        }
+
+        updateSysInfo(thing, sysInfo);
+        QVariantMap emeterMap = map.value("emeter").toMap();
+        if (emeterMap.contains("get_realtime")) {
+            updateRealtime(thing, emeterMap.value("get_realtime").toMap());
+        }
+        m_lastBroadcastReply[thing] = now;
+    }
+}
+
+void IntegrationPluginTPLink::updateSysInfo(Thing *thing, const QVariantMap &sysInfo)
+{
+    StateTypeId signalStrengthStateTypeId = signalStrengthStateTypesMap.value(thing->thingClassId());
+    int rssi = sysInfo.value("rssi").toInt();
+    int signalStrength = qMax(0, qMin(100, 2 * (rssi + 100)));
+    thing->setStateValue(signalStrengthStateTypeId, signalStrength);
+
+    if (thing->thingClassId() == kasaSocketThingClassId) {
+        foreach (Thing *child, myThings().filterByParentId(kasaSocketThingClassId)) {
+            child->setStateValue(kasaSocketSignalStrengthStateTypeId, signalStrength);
+        }
+    }
+
+    QString alias = sysInfo.value("alias").toString();
+    if (thing->name() != alias) {
+        thing->setName(alias);
+    }
+
+    if (sysInfo.contains("relay_state")) {
+        int relayState = sysInfo.value("relay_state").toInt();
+        StateTypeId powerStateTypeId = powerStateTypesMap.value(thing->thingClassId());
+        thing->setStateValue(powerStateTypeId, relayState == 1 ? true : false);
+
+    } else if (sysInfo.contains("children")) {
+        // For now, only the HS300 has children, which we map to child things of type kasaSocket
+        QVariantList children = sysInfo.value("children").toList();
+        foreach (const QVariant &childVariant, children) {
+            QVariantMap childMap = childVariant.toMap();
+            QString idParam = childMap.value("id").toString();
+            bool relayState = childMap.value("state").toInt() == 1;
+            Things things = myThings().filterByParentId(thing->id()).filterByParam(kasaSocketThingIdParamTypeId, idParam);
+            if (things.count() == 1) {
+                things.first()->setStateValue(kasaSocketPowerStateTypeId, relayState);
+            } else {
+                qCWarning(dcTplink()) << "Error matching child devices" << sysInfo;
+                foreach (Thing *child, myThings().filterByParentId(thing->id())) {
+                    qCDebug(dcTplink()) << "Existing child device:" << child->name() << child->params();
+                }
+            }
+        }
+    }
+}
+
+void IntegrationPluginTPLink::updateRealtime(Thing *thing, const QVariantMap &realtime)
+{
+    // This has quite a bit of jitter... Let's smoothen it while within +/- 0.1W to produce less events in the system
+    StateTypeId currentPowerStateTypeId = currentPowerStatetTypesMap.value(thing->thingClassId());
+    double oldValue = thing->stateValue(currentPowerStateTypeId).toDouble();
+    double newValue = realtime.value("power_mw").toDouble() / 1000;
+    if (qAbs(oldValue - newValue) > 0.1) {
+        thing->setStateValue(currentPowerStateTypeId, newValue);
+    }
+    StateTypeId totalEnergyConsumedStateTypeId = totalEnergyConsumedStatetTypesMap.value(thing->thingClassId());
+    thing->setStateValue(totalEnergyConsumedStateTypeId, realtime.value("total_wh").toDouble() / 1000);
+}
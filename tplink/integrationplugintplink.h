@@ -64,6 +64,12 @@ private:
     void connectToDevice(Thing *thing, const QHostAddress &address);
     void fetchState(Thing *thing, ThingActionInfo *info = nullptr);
 
+    void refreshStates();
+    void onRefreshReadyRead();
+
+    void updateSysInfo(Thing *thing, const QVariantMap &sysInfo);
+    void updateRealtime(Thing *thing, const QVariantMap &realtime);
+
     void processQueue(Thing *thing);
 
 private:
@@ -79,6 +85,12 @@ private:
     int m_jobIdx = 0;
 
     QUdpSocket *m_broadcastSocket = nullptr;
+    QUdpSocket *m_refreshSocket = nullptr;
+    // Encrypted get_sysinfo and get_realtime request, used for all state refreshes
+    QByteArray m_stateRequest;
+    QHash<QString, Thing*> m_deviceIds;
+    QHash<Thing*, qint64> m_lastBroadcastReply;
+    QHash<Thing*, QHostAddress> m_addresses;
     QHash<Thing*, QTcpSocket*> m_sockets;
     QHash<ThingSetupInfo*, int> m_setupRetries;
 
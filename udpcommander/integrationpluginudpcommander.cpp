@@ -44,18 +44,37 @@ void IntegrationPluginUdpCommander::setupThing(ThingSetupInfo *info)
     qCDebug(dcUdpCommander()) << "Setup thing" << thing->name() << thing->params();
 
     if (thing->thingClassId() == udpReceiverThingClassId) {
-        QUdpSocket *udpSocket = new QUdpSocket(this);
-        int port = thing->paramValue(udpReceiverThingPortParamTypeId).toInt();
-        if (!udpSocket->bind(QHostAddress::Any, port, QUdpSocket::ShareAddress)) {
-            qCWarning(dcUdpCommander()) << thing->name() << "cannot bind to port" << port;
-            delete udpSocket;
-            return info->finish(Thing::ThingErrorHardwareNotAvailable, QT_TR_NOOP("Error opening UDP port."));
+        quint16 port = static_cast<quint16>(thing->paramValue(udpReceiverThingPortParamTypeId).toUInt());
+
+        // In case of a reconfigure the port might have changed
+        unregisterReceiver(thing);
+
+        UdpReceiver *receiver = m_receivers.value(port);
+        if (!receiver) {
+            receiver = new UdpReceiver(port, this);
+            if (!receiver->bind()) {
+                qCWarning(dcUdpCommander()) << thing->name() << "cannot bind to port" << port;
+                delete receiver;
+                return info->finish(Thing::ThingErrorHardwareNotAvailable, QT_TR_NOOP("Error opening UDP port."));
+            }
+            connect(receiver, &UdpReceiver::datagramReceived, this, &IntegrationPluginUdpCommander::onDatagramReceived);
+            m_receivers.insert(port, receiver);
         }
-        qCDebug(dcUdpCommander()) << "Listening on port" << port;
 
-        connect(udpSocket, SIGNAL(readyRead()), this, SLOT(readPendingDatagrams()));
-        m_receiverList.insert(udpSocket, thing);
+        QString senderAddress = thing->paramValue(udpReceiverThingSenderAddressParamTypeId).toString().trimmed();
+        if (!senderAddress.isEmpty()) {
+            QHostAddress senderFilter(senderAddress);
+            if (senderFilter.isNull()) {
+                qCWarning(dcUdpCommander()) << thing->name() << "invalid sender address" << senderAddress;
+                if (!m_receiverThings.contains(port)) {
+                    m_receivers.take(port)->deleteLater();
+                }
+                return info->finish(Thing::ThingErrorInvalidParameter, QT_TR_NOOP("The given sender address is not valid."));
+            }
+            m_senderFilters.insert(thing, senderFilter);
+        }
 
+        m_receiverThings[port].append(thing);
         return info->finish(Thing::ThingErrorNoError);
     } else if (thing->thingClassId() == udpCommanderThingClassId) {
         QUdpSocket *udpSocket = new QUdpSocket(this);
@@ -85,10 +104,7 @@ void IntegrationPluginUdpCommander::executeAction(ThingActionInfo *info)
 void IntegrationPluginUdpCommander::thingRemoved(Thing *thing)
 {
     if (thing->thingClassId() == udpReceiverThingClassId) {
-        QUdpSocket *socket = m_receiverList.key(thing);
-        m_receiverList.remove(socket);
-        socket->close();
-        socket->deleteLater();
+        unregisterReceiver(thing);
 
     } else if (thing->thingClassId() == udpCommanderThingClassId) {
         QUdpSocket *socket = m_commanderList.key(thing);
@@ -98,34 +114,50 @@ void IntegrationPluginUdpCommander::thingRemoved(Thing *thing)
     }
 }
 
-void IntegrationPluginUdpCommander::readPendingDatagrams()
+void IntegrationPluginUdpCommander::unregisterReceiver(Thing *thing)
 {
-    qCDebug(dcUdpCommander()) << "UDP datagram received";
-    QUdpSocket *socket= static_cast<QUdpSocket *>(sender());
-    Thing *thing = m_receiverList.value(socket);
+    m_senderFilters.remove(thing);
+
+    foreach (quint16 port, m_receiverThings.keys()) {
+        QList<Thing *> &things = m_receiverThings[port];
+        if (!things.removeAll(thing))
+            continue;
 
-    if (!thing) {
-        qCWarning(dcUdpCommander()) << "Received a datagram from a socket we don't know";
-        return;
+        // Close the socket once the last thing on this port is gone
+        if (things.isEmpty()) {
+            m_receiverThings.remove(port);
+            m_receivers.take(port)->deleteLater();
+        }
     }
+}
 
-    QByteArray datagram;
-    QHostAddress sender;
-    quint16 senderPort = 0;
+void IntegrationPluginUdpCommander::onDatagramReceived(const QByteArray &datagram, const QHostAddress &senderAddress, quint16 senderPort)
+{
+    UdpReceiver *receiver = static_cast<UdpReceiver *>(sender());
+    QByteArray data;
+    bool matched = false;
+
+    foreach (Thing *thing, m_receiverThings.value(receiver->port())) {
+        if (m_senderFilters.contains(thing) && !m_senderFilters.value(thing).isEqual(senderAddress, QHostAddress::TolerantConversion))
+            continue;
+
+        // Copied once from the receive buffer and shared by all matching things
+        if (!matched) {
+            data = QByteArray(datagram.constData(), datagram.size());
+            matched = true;
+        }
 
-    while (socket->hasPendingDatagrams()) {
-        datagram.resize(socket->pendingDatagramSize());
-        socket->readDatagram(datagram.data(), datagram.size(), &sender, &senderPort);
-        qCDebug(dcUdpCommander()) << "Incoming datatram" << datagram << "on" << thing->name() << "from" << sender.toString() << senderPort;
+        qCDebug(dcUdpCommander()) << "Incoming datagram" << data << "on" << thing->name() << "from" << senderAddress.toString() << senderPort;
 
         Event ev = Event(udpReceiverTriggeredEventTypeId, thing->id());
         ParamList params;
-        params.append(Param(udpReceiverTriggeredEventDataParamTypeId, datagram));
+        params.append(Param(udpReceiverTriggeredEventDataParamTypeId, data));
         ev.setParams(params);
         emit emitEvent(ev);
-
-        // Send response for verification
-        socket->writeDatagram("OK\n", sender, senderPort);
     }
 
+    // Send response for verification
+    if (matched) {
+        receiver->sendReply("OK\n", senderAddress, senderPort);
+    }
 }
@@ -32,6 +32,7 @@
 #define INTEGRATIONPLUGINUDPCOMMANDER_H
 
 #include "integrations/integrationplugin.h"
+#include "udpreceiver.h"
 
 #include <QHash>
 #include <QDebug>
@@ -52,11 +53,15 @@ public:
     void executeAction(ThingActionInfo *info) override;
 
 private:
-    QHash<QUdpSocket *, Thing *> m_receiverList;
+    QHash<quint16, UdpReceiver *> m_receivers;
+    QHash<quint16, QList<Thing *>> m_receiverThings;
+    QHash<Thing *, QHostAddress> m_senderFilters;
     QHash<QUdpSocket *, Thing *> m_commanderList;
 
+    void unregisterReceiver(Thing *thing);
+
 private slots:
-    void readPendingDatagrams();
+    void onDatagramReceived(const QByteArray &datagram, const QHostAddress &senderAddress, quint16 senderPort);
 
 };
 
@@ -0,0 +1,82 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "udpreceiver.h"
+#include "extern-plugininfo.h"
+
+UdpReceiver::UdpReceiver(quint16 port, QObject *parent) :
+    QObject(parent),
+    m_port(port)
+{
+    m_socket = new QUdpSocket(this);
+    connect(m_socket, &QUdpSocket::readyRead, this, &UdpReceiver::readPendingDatagrams);
+}
+
+quint16 UdpReceiver::port() const
+{
+    return m_port;
+}
+
+bool UdpReceiver::bind()
+{
+    // Still shared with other applications listening on this port
+    if (!m_socket->bind(QHostAddress::Any, m_port, QUdpSocket::ShareAddress)) {
+        qCWarning(dcUdpCommander()) << "Cannot bind to port" << m_port << m_socket->errorString();
+        return false;
+    }
+    qCDebug(dcUdpCommander()) << "Listening on port" << m_port;
+    return true;
+}
+
+void UdpReceiver::sendReply(const QByteArray &data, const QHostAddress &address, quint16 port)
+{
+    m_socket->writeDatagram(data, address, port);
+}
+
+void UdpReceiver::readPendingDatagrams()
+{
+    QHostAddress sender;
+    quint16 senderPort = 0;
+
+    // Read all queued datagrams in one go, the buffer only grows if a larger datagram arrives
+    while (m_socket->hasPendingDatagrams()) {
+        qint64 pendingSize = m_socket->pendingDatagramSize();
+        if (pendingSize > m_buffer.size())
+            m_buffer.resize(static_cast<int>(pendingSize));
+
+        qint64 size = m_socket->readDatagram(m_buffer.data(), m_buffer.size(), &sender, &senderPort);
+        if (size < 0) {
+            qCWarning(dcUdpCommander()) << "Error reading datagram on port" << m_port << m_socket->errorString();
+            break;
+        }
+
+        emit datagramReceived(QByteArray::fromRawData(m_buffer.constData(), static_cast<int>(size)), sender, senderPort);
+    }
+}
@@ -0,0 +1,66 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef UDPRECEIVER_H
+#define UDPRECEIVER_H
+
+#include <QObject>
+#include <QUdpSocket>
+
+// One socket per port, shared by all receiver things listening on that port
+class UdpReceiver : public QObject
+{
+    Q_OBJECT
+public:
+    explicit UdpReceiver(quint16 port, QObject *parent = nullptr);
+
+    quint16 port() const;
+    bool bind();
+
+    void sendReply(const QByteArray &data, const QHostAddress &address, quint16 port);
+
+signals:
+    // Note: the datagram only references the internal receive buffer and is valid
+    // for the duration of the signal emission. Copy it if it needs to be kept.
+    void datagramReceived(const QByteArray &datagram, const QHostAddress &sender, quint16 senderPort);
+
+private:
+    QUdpSocket *m_socket = nullptr;
+    quint16 m_port = 0;
+
+    // Reused for every datagram read from the socket
+    QByteArray m_buffer;
+
+private slots:
+    void readPendingDatagrams();
+
+};
+
+#endif // UDPRECEIVER_H